@@ -4,7 +4,7 @@ from conan.tools.cmake import CMake, CMakeDeps, CMakeToolchain
 class VulkanTutorial(ConanFile):
     version = '1.0.0'
     name = 'VulkanTutorial'
-    requires = 'glfw/3.3.4', 'glm/0.9.9.8', 'fmt/8.0.1', 'vulkan-loader/1.3.224.0'
+    requires = 'glfw/3.3.4', 'glm/0.9.9.8', 'fmt/8.0.1', 'lz4/1.9.4', 'stb/cci.20230920', 'vulkan-loader/1.3.224.0'
     build_requires = 'shaderc/2021.1'
     generators = 'CMakeToolchain', 'CMakeDeps'
     settings = 'os', 'compiler', 'arch', 'build_type'
@@ -0,0 +1,207 @@
+// Packs every file below a directory into an lve::file::archive.
+//
+// usage: archive-packer <directory> <archive> [--chunk-size <KiB>]
+// Entries are named by their path relative to the directory with '/'
+// separators. Each is compressed with LZ4 HC in independent chunks, and
+// stored as it is when that saves less than a tenth of it, e.g. for already
+// compressed textures, which can then be read straight from the mapping.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <file/archive.hpp>
+#include <file/io.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <lz4hc.h>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+using namespace lve::file;
+
+struct packed_entry
+{
+    std::string name;
+    archive_entry entry;
+    std::pmr::vector<std::byte> data;
+};
+
+// Chunk sizes followed by the chunks, or the content itself when
+// compressing doesn't pay off
+packed_entry pack(std::string name,
+                  std::pmr::vector<std::byte> content,
+                  uint32_t chunk_size)
+{
+    packed_entry packed{.name  = std::move(name),
+                        .entry = {.original_size = content.size(),
+                                  .method        = compression::stored}};
+
+    const auto chunk_count = (content.size() + chunk_size - 1) / chunk_size;
+    std::pmr::vector<uint32_t> compressed_sizes(chunk_count);
+    std::pmr::vector<char> compressed(
+        chunk_count * LZ4_compressBound(static_cast<int>(chunk_size)));
+    size_t compressed_size = 0;
+    for (size_t i = 0; i < chunk_count; ++i)
+    {
+        const auto offset = i * chunk_size;
+        const auto size =
+            std::min<size_t>(chunk_size, content.size() - offset);
+        const auto result = LZ4_compress_HC(
+            reinterpret_cast<const char*>(content.data() + offset),
+            compressed.data() + compressed_size,
+            static_cast<int>(size),
+            static_cast<int>(compressed.size() - compressed_size),
+            LZ4HC_CLEVEL_DEFAULT);
+        if (result <= 0)
+        {
+            throw std::runtime_error(
+                fmt::format("failed to compress: {}", packed.name));
+        }
+        compressed_sizes[i] = static_cast<uint32_t>(result);
+        compressed_size += static_cast<size_t>(result);
+    }
+
+    const auto sizes_size = chunk_count * sizeof(uint32_t);
+    if (content.empty() ||
+        (sizes_size + compressed_size) * 10 > content.size() * 9)
+    {
+        packed.entry.size = content.size();
+        packed.data       = std::move(content);
+        return packed;
+    }
+    packed.entry.size        = sizes_size + compressed_size;
+    packed.entry.method      = compression::lz4;
+    packed.entry.chunk_count = static_cast<uint32_t>(chunk_count);
+    packed.data.resize(packed.entry.size);
+    std::memcpy(packed.data.data(), compressed_sizes.data(), sizes_size);
+    std::memcpy(
+        packed.data.data() + sizes_size, compressed.data(), compressed_size);
+    return packed;
+}
+
+void write_padding(std::ofstream& output, uint64_t alignment)
+{
+    static constexpr char zeros[archive_alignment] = {};
+    const auto position = static_cast<uint64_t>(output.tellp());
+    const auto padding  = (alignment - position % alignment) % alignment;
+    output.write(zeros, static_cast<std::streamsize>(padding));
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t chunk_size = 256 * 1024;
+    if (argc == 5 && std::string_view{argv[3]} == "--chunk-size")
+    {
+        chunk_size =
+            static_cast<uint32_t>(std::strtoul(argv[4], nullptr, 10) * 1024);
+    }
+    if ((argc != 3 && argc != 5) || chunk_size == 0)
+    {
+        fmt::print(stderr,
+                   "usage: {} <directory> <archive> [--chunk-size <KiB>]\n",
+                   argv[0]);
+        return EXIT_FAILURE;
+    }
+    const std::filesystem::path directory   = argv[1];
+    const std::filesystem::path output_path = argv[2];
+
+    try
+    {
+        std::pmr::vector<packed_entry> packed;
+        uint64_t original_size = 0;
+        for (const auto& file :
+             std::filesystem::recursive_directory_iterator{directory})
+        {
+            if (!file.is_regular_file())
+            {
+                continue;
+            }
+            auto name =
+                file.path().lexically_relative(directory).generic_string();
+            auto content = load(file.path());
+            original_size += content.size();
+            packed.push_back(
+                pack(std::move(name), std::move(content), chunk_size));
+        }
+        std::sort(packed.begin(),
+                  packed.end(),
+                  [](const packed_entry& a, const packed_entry& b) {
+                      return std::pair{archive_hash(a.name), a.name} <
+                             std::pair{archive_hash(b.name), b.name};
+                  });
+
+        // the names follow the table of contents, the data the names
+        uint64_t names_size = 0;
+        for (auto& [name, entry, data] : packed)
+        {
+            entry.name_hash   = archive_hash(name);
+            entry.name_offset = static_cast<uint32_t>(names_size);
+            entry.name_size   = static_cast<uint32_t>(name.size());
+            names_size += name.size();
+        }
+        auto offset = sizeof(archive_header) +
+                      packed.size() * sizeof(archive_entry) + names_size;
+        for (auto& [name, entry, data] : packed)
+        {
+            offset = (offset + archive_alignment - 1) / archive_alignment *
+                     archive_alignment;
+            entry.offset = offset;
+            offset += entry.size;
+        }
+
+        std::ofstream output(output_path, std::ios::binary);
+        if (!output.is_open())
+        {
+            throw std::runtime_error(
+                fmt::format("failed to open file: {}", output_path.string()));
+        }
+        archive_header header{
+            .version     = archive_version,
+            .entry_count = static_cast<uint32_t>(packed.size()),
+            .chunk_size  = chunk_size};
+        std::memcpy(header.magic, archive_magic, sizeof(archive_magic));
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& [name, entry, data] : packed)
+        {
+            output.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+        for (const auto& [name, entry, data] : packed)
+        {
+            output.write(name.data(),
+                         static_cast<std::streamsize>(name.size()));
+        }
+        for (const auto& [name, entry, data] : packed)
+        {
+            write_padding(output, archive_alignment);
+            output.write(reinterpret_cast<const char*>(data.data()),
+                         static_cast<std::streamsize>(data.size()));
+        }
+        if (!output)
+        {
+            throw std::runtime_error(
+                fmt::format("failed to write file: {}", output_path.string()));
+        }
+
+        const auto compressed = std::count_if(
+            packed.begin(), packed.end(), [](const packed_entry& packed) {
+                return packed.entry.method == compression::lz4;
+            });
+        fmt::print("{} entries, {} compressed, {:.1f} MiB to {:.1f} MiB\n",
+                   packed.size(),
+                   compressed,
+                   static_cast<double>(original_size) / (1 << 20),
+                   static_cast<double>(output.tellp()) / (1 << 20));
+    }
+    catch (const std::exception& e)
+    {
+        fmt::print(stderr, "{}\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+// Checks that callbacks of lve::file::async_loader can queue loads at any
+// queue depth: one thread keeps the queue full while every callback
+// queues one more load, on each backend the system has. A hang is reported
+// as a failure after a timeout.
+//
+// usage: async-loader-test
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <file/async_loader.hpp>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <future>
+#include <string_view>
+
+namespace
+{
+constexpr uint32_t LOAD_COUNT = 50;
+constexpr std::array<unsigned, 3> QUEUE_DEPTHS{1, 2, 4};
+constexpr auto TIMEOUT = std::chrono::seconds{10};
+
+std::string_view backend_name(lve::file::async_backend backend)
+{
+    return backend == lve::file::async_backend::io_uring ? "io_uring"
+                                                         : "thread pool";
+}
+
+// Returns the backend the loader picked, leaves the process when the loads
+// don't all call back in time: the hung threads can't be joined, not even by
+// the future of std::async
+lve::file::async_backend run_chained_loads(const std::filesystem::path& file,
+                                           unsigned queue_depth,
+                                           lve::file::async_backend backend)
+{
+    std::atomic<uint32_t> loaded{0};
+    std::atomic<uint32_t> failed{0};
+    auto loads = std::async(std::launch::async, [&] {
+        lve::file::async_loader loader{queue_depth, backend};
+        auto on_chained = [&](std::pmr::vector<std::byte>,
+                              std::exception_ptr error) {
+            failed += error ? 1 : 0;
+            ++loaded;
+        };
+        for (uint32_t i = 0; i < LOAD_COUNT; ++i)
+        {
+            loader.load(file,
+                        [&](std::pmr::vector<std::byte>,
+                            std::exception_ptr error) {
+                            failed += error ? 1 : 0;
+                            ++loaded;
+                            loader.load(file, on_chained);
+                        });
+        }
+        loader.wait();
+        return loader.backend();
+    });
+    if (loads.wait_for(TIMEOUT) != std::future_status::ready)
+    {
+        fmt::print(stderr,
+                   "hung at queue depth {} after {} of {} loads\n",
+                   queue_depth,
+                   loaded.load(),
+                   2 * LOAD_COUNT);
+        std::filesystem::remove(file);
+        std::_Exit(EXIT_FAILURE);
+    }
+    const auto used = loads.get();
+    if (failed != 0 || loaded != 2 * LOAD_COUNT)
+    {
+        fmt::print(stderr,
+                   "{} backend at queue depth {}: {} of {} loads called "
+                   "back, {} failed\n",
+                   backend_name(used),
+                   queue_depth,
+                   loaded.load(),
+                   2 * LOAD_COUNT,
+                   failed.load());
+        std::filesystem::remove(file);
+        std::exit(EXIT_FAILURE);
+    }
+    return used;
+}
+} // namespace
+
+int main()
+{
+    const auto file =
+        std::filesystem::temp_directory_path() / "async-loader-test.bin";
+    std::ofstream{file, std::ios::binary} << "loaded from a callback";
+
+    for (const auto backend : {lve::file::async_backend::thread_pool,
+                               lve::file::async_backend::automatic})
+    {
+        for (const auto depth : QUEUE_DEPTHS)
+        {
+            const auto used = run_chained_loads(file, depth, backend);
+            fmt::print("{} backend at queue depth {}: ok\n",
+                       backend_name(used),
+                       depth);
+        }
+    }
+    std::filesystem::remove(file);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+// Times lve::Bvh on scenes of random boxes, 10k, 100k and 1M of them by
+// default. Each scene is built with binned SAH on every hardware thread and
+// on one, then queried with random rays and with the view frustums of
+// random cameras. The first frustum queries are also answered by testing
+// every box, which they have to agree with.
+//
+// usage: bvh-benchmark [object count...]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <memory_resource>
+#include <random>
+#include <tutorial/bounds.hpp>
+#include <tutorial/bvh.hpp>
+#include <tutorial/camera.hpp>
+#include <tutorial/job_system.hpp>
+#include <vector>
+
+namespace
+{
+constexpr std::array<size_t, 3> DEFAULT_SIZES{10'000, 100'000, 1'000'000};
+constexpr uint32_t BUILD_REPEATS = 3;
+constexpr uint32_t RAY_COUNT     = 100'000;
+constexpr uint32_t FRUSTUM_COUNT = 1'000;
+// frustum queries checked against testing every box
+constexpr uint32_t CHECKED_FRUSTUM_COUNT = 10;
+// space per box, so scenes of any size are equally crowded
+constexpr float VOLUME_PER_OBJECT = 64.f;
+
+struct Scene
+{
+    std::pmr::vector<lve::BoundingBox> boxes;
+    // the boxes are centered in [0, extent) on each axis
+    float extent;
+};
+
+template <typename Function>
+double time_ms(const Function& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// boxes of 0.5 to 1.5 units on a side
+Scene random_scene(size_t count, std::mt19937& random)
+{
+    Scene scene;
+    scene.extent = std::cbrt(static_cast<float>(count) * VOLUME_PER_OBJECT);
+    std::uniform_real_distribution<float> position{0.f, scene.extent};
+    std::uniform_real_distribution<float> half_size{0.25f, 0.75f};
+    scene.boxes.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 center{
+            position(random), position(random), position(random)};
+        const glm::vec3 half{
+            half_size(random), half_size(random), half_size(random)};
+        scene.boxes.push_back({center - half, center + half});
+    }
+    return scene;
+}
+
+glm::vec3 random_direction(std::mt19937& random)
+{
+    std::normal_distribution<float> normal;
+    glm::vec3 direction{};
+    while (glm::dot(direction, direction) < 1e-6f)
+    {
+        direction = {normal(random), normal(random), normal(random)};
+    }
+    return glm::normalize(direction);
+}
+
+double best_build_ms(lve::Bvh& bvh, const Scene& scene)
+{
+    double best = 0.0;
+    for (uint32_t i = 0; i < BUILD_REPEATS; ++i)
+    {
+        const auto ms = time_ms([&] { bvh.build(scene.boxes); });
+        best          = i == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+void benchmark_rays(const lve::Bvh& bvh,
+                    const Scene& scene,
+                    std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position{0.f, scene.extent};
+    std::pmr::vector<lve::Ray> rays(RAY_COUNT);
+    for (auto& ray : rays)
+    {
+        ray.origin    = {position(random), position(random), position(random)};
+        ray.direction = random_direction(random);
+    }
+
+    uint32_t hits = 0;
+    const auto ms = time_ms([&] {
+        for (const auto& ray : rays)
+        {
+            hits += bvh.raycast(ray, scene.extent).has_value() ? 1 : 0;
+        }
+    });
+    fmt::print("  rays      {:8.3f} us/ray, {:.1f}% hit\n",
+               ms * 1000.0 / RAY_COUNT,
+               100.0 * hits / RAY_COUNT);
+}
+
+// Returns whether the checked queries found what testing every box did
+bool benchmark_frustums(const lve::Bvh& bvh,
+                        const Scene& scene,
+                        std::mt19937& random)
+{
+    // cameras inside the scene seeing a quarter of it deep
+    std::uniform_real_distribution<float> position{0.f, scene.extent};
+    std::pmr::vector<lve::Frustum> frustums;
+    frustums.reserve(FRUSTUM_COUNT);
+    for (uint32_t i = 0; i < FRUSTUM_COUNT; ++i)
+    {
+        lve::LveCamera camera;
+        camera.set_perspective_projection(
+            glm::radians(50.f), 16.f / 9.f, 0.1f, scene.extent * 0.25f);
+        const glm::vec3 eye{
+            position(random), position(random), position(random)};
+        camera.set_view_direction(eye, random_direction(random));
+        frustums.push_back(lve::Frustum::from_matrix(camera.get_projection() *
+                                                     camera.get_view()));
+    }
+
+    std::pmr::vector<uint32_t> visible;
+    uint64_t visible_total = 0;
+    uint64_t visited_total = 0;
+    const auto ms          = time_ms([&] {
+        for (const auto& frustum : frustums)
+        {
+            visible.clear();
+            visited_total += bvh.query(frustum, visible);
+            visible_total += visible.size();
+        }
+    });
+
+    bool agreed       = true;
+    const auto linear = time_ms([&] {
+        for (uint32_t i = 0; i < CHECKED_FRUSTUM_COUNT; ++i)
+        {
+            std::pmr::vector<uint32_t> expected;
+            for (uint32_t box = 0; box < scene.boxes.size(); ++box)
+            {
+                if (frustums[i].test(scene.boxes[box]) !=
+                    lve::Frustum::Containment::outside)
+                {
+                    expected.push_back(box);
+                }
+            }
+            visible.clear();
+            bvh.query(frustums[i], visible);
+            std::sort(visible.begin(), visible.end());
+            agreed = agreed && visible == expected;
+        }
+    });
+    fmt::print("  frustums  {:8.3f} ms/query, {:.0f} objects visible, {:.0f} "
+               "nodes visited, {:.3f} ms/query testing every box{}\n",
+               ms / FRUSTUM_COUNT,
+               static_cast<double>(visible_total) / FRUSTUM_COUNT,
+               static_cast<double>(visited_total) / FRUSTUM_COUNT,
+               linear / CHECKED_FRUSTUM_COUNT,
+               agreed ? "" : ", MISMATCH");
+    return agreed;
+}
+
+bool benchmark(size_t count, lve::JobSystem& job_system)
+{
+    // the same scene and queries every run
+    std::mt19937 random{static_cast<uint32_t>(count)};
+    const auto scene = random_scene(count, random);
+
+    lve::Bvh single_threaded;
+    const auto single_ms = best_build_ms(single_threaded, scene);
+    lve::Bvh bvh{&job_system};
+    const auto build_ms = best_build_ms(bvh, scene);
+    fmt::print("{} objects\n"
+               "  build     {:8.2f} ms, {:.2f} ms on one thread, {} nodes, "
+               "SAH cost {:.1f}\n",
+               count,
+               build_ms,
+               single_ms,
+               bvh.node_count(),
+               bvh.cost());
+
+    benchmark_rays(bvh, scene, random);
+    return benchmark_frustums(bvh, scene, random);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::pmr::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        char* end        = nullptr;
+        const auto count = std::strtoull(argv[i], &end, 10);
+        if (count == 0 || *end != '\0')
+        {
+            fmt::print(stderr, "usage: {} [object count...]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        sizes.push_back(count);
+    }
+    if (sizes.empty())
+    {
+        sizes.assign(DEFAULT_SIZES.begin(), DEFAULT_SIZES.end());
+    }
+
+    lve::JobSystem job_system;
+    fmt::print("{} threads\n", job_system.thread_count());
+    bool agreed = true;
+    for (const auto count : sizes)
+    {
+        agreed = benchmark(count, job_system) && agreed;
+    }
+    return agreed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
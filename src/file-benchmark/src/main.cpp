@@ -0,0 +1,276 @@
+// Compares the ways lve::file reads files. For one large file: one chunk at
+// a time, through a memory mapping and loading it whole. For a directory of
+// small files: loading them one after another and loading them all at once
+// with the async loader. Each pass sums the bytes so every page is actually
+// read.
+//
+// usage: file-benchmark [file | --size <MiB>]
+//        file-benchmark --files [directory]
+// Without a file a temporary one of the given size (1 GiB by default) is
+// written first, without a directory 2000 files of 4 to 64 KiB. On Linux
+// the files are dropped from the page cache before each pass, so the passes
+// measure the disk rather than memory.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <file/async_loader.hpp>
+#include <file/chunked_reader.hpp>
+#include <file/io.hpp>
+#include <file/mapped_file.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr size_t MiB = 1 << 20;
+
+uint64_t checksum(std::span<const std::byte> bytes, uint64_t sum = 0)
+{
+    for (const auto byte : bytes)
+    {
+        sum += static_cast<uint8_t>(byte);
+    }
+    return sum;
+}
+
+// peak resident set of the process so far, 0 where it isn't available
+size_t peak_resident_size()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+void write_test_file(const std::filesystem::path& path, size_t size)
+{
+    std::ofstream file(path, std::ios::binary);
+    std::pmr::vector<char> chunk(MiB);
+    for (size_t i = 0; i < chunk.size(); ++i)
+    {
+        chunk[i] = static_cast<char>(i * 31 + 7);
+    }
+    for (size_t written = 0; written < size; written += chunk.size())
+    {
+        file.write(chunk.data(),
+                   static_cast<std::streamsize>(
+                       std::min(chunk.size(), size - written)));
+    }
+}
+
+// Evicts the file from the page cache so the next read comes from the disk
+void drop_cached(const std::filesystem::path& path)
+{
+#ifdef __linux__
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#endif
+}
+
+void run(std::string_view name,
+         std::span<const std::filesystem::path> files,
+         size_t size,
+         const std::function<uint64_t()>& pass)
+{
+    for (const auto& path : files)
+    {
+        drop_cached(path);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto sum   = pass();
+    const std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    fmt::print("{:<10} {:8.3f} s {:9.1f} MiB/s  peak rss {:7.1f} MiB  "
+               "checksum {:x}\n",
+               name,
+               seconds.count(),
+               static_cast<double>(size) / MiB / seconds.count(),
+               static_cast<double>(peak_resident_size()) / MiB,
+               sum);
+}
+void benchmark_large_file(std::filesystem::path path, size_t size)
+{
+    using namespace lve::file;
+
+    const bool temporary = path.empty();
+    if (temporary)
+    {
+        path =
+            std::filesystem::temp_directory_path() / "lve-file-benchmark.bin";
+        fmt::print("writing {} MiB to {}\n", size / MiB, path.string());
+        write_test_file(path, size);
+    }
+    size = std::filesystem::file_size(path);
+    const std::span files{&path, 1};
+
+    // the streaming passes go first, the peak resident size only grows
+    run("chunked", files, size, [&] {
+        chunked_reader reader{path};
+        uint64_t sum = 0;
+        for (auto chunk = reader.next(); !chunk.empty(); chunk = reader.next())
+        {
+            sum = checksum(chunk, sum);
+        }
+        return sum;
+    });
+    run("mapped", files, size, [&] {
+        const mapped_file file{path, access_pattern::sequential};
+        const auto bytes    = file.bytes();
+        constexpr auto step = 16 * MiB;
+        uint64_t sum        = 0;
+        for (size_t offset = 0; offset < bytes.size(); offset += step)
+        {
+            file.prefetch(offset + step, step);
+            const auto chunk = std::min(step, bytes.size() - offset);
+            sum              = checksum(bytes.subspan(offset, chunk), sum);
+            file.release(offset, step);
+        }
+        return sum;
+    });
+    run("load", files, size, [&] {
+        return checksum(load(path));
+    });
+
+    if (temporary)
+    {
+        std::filesystem::remove(path);
+    }
+}
+
+uint64_t load_all(lve::file::async_loader& loader,
+                  std::span<const std::filesystem::path> files)
+{
+    std::atomic<uint64_t> sum = 0;
+    for (const auto& path : files)
+    {
+        loader.load(path,
+                    [&sum](std::pmr::vector<std::byte> content,
+                           std::exception_ptr error) {
+                        if (error)
+                        {
+                            std::rethrow_exception(error);
+                        }
+                        sum += checksum(content);
+                    });
+    }
+    loader.wait();
+    return sum;
+}
+
+void benchmark_small_files(std::filesystem::path directory)
+{
+    using namespace lve::file;
+
+    const bool temporary = directory.empty();
+    if (temporary)
+    {
+        directory =
+            std::filesystem::temp_directory_path() / "lve-file-benchmark";
+        std::filesystem::create_directories(directory);
+        fmt::print("writing 2000 files to {}\n", directory.string());
+        for (size_t i = 0; i < 2000; ++i)
+        {
+            write_test_file(directory / fmt::format("{}.bin", i),
+                            (4 + i * 7 % 61) * 1024);
+        }
+    }
+
+    std::pmr::vector<std::filesystem::path> files;
+    size_t size = 0;
+    for (const auto& entry :
+         std::filesystem::recursive_directory_iterator{directory})
+    {
+        if (entry.is_regular_file())
+        {
+            files.push_back(entry.path());
+            size += entry.file_size();
+        }
+    }
+    fmt::print("{} files, {:.1f} MiB\n",
+               files.size(),
+               static_cast<double>(size) / MiB);
+
+    run("load", files, size, [&] {
+        uint64_t sum = 0;
+        for (const auto& path : files)
+        {
+            sum = checksum(load(path), sum);
+        }
+        return sum;
+    });
+    for (const auto backend : {async_backend::thread_pool,
+                               async_backend::io_uring})
+    {
+        const auto name = backend == async_backend::io_uring ? "io_uring"
+                                                             : "threads";
+        try
+        {
+            async_loader loader{async_loader::default_queue_depth, backend};
+            run(name, files, size, [&] { return load_all(loader, files); });
+        }
+        catch (const std::runtime_error& error)
+        {
+            fmt::print("{:<10} skipped, {}\n", name, error.what());
+        }
+    }
+
+    if (temporary)
+    {
+        std::filesystem::remove_all(directory);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::string_view mode = argc > 1 ? argv[1] : "";
+    if (mode == "--files" && argc <= 3)
+    {
+        benchmark_small_files(argc == 3 ? argv[2] : "");
+    }
+    else if (mode == "--size" && argc == 3)
+    {
+        benchmark_large_file({}, std::strtoull(argv[2], nullptr, 10) * MiB);
+    }
+    else if (argc <= 2 && !mode.starts_with("--"))
+    {
+        benchmark_large_file(argc == 2 ? argv[1] : "", 1024 * MiB);
+    }
+    else
+    {
+        fmt::print(stderr,
+                   "usage: {0} [file | --size <MiB>]\n"
+                   "       {0} --files [directory]\n",
+                   argv[0]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <file/archive.hpp>
+#include <fmt/format.h>
+#include <lz4.h>
+#include <stdexcept>
+#include <thread>
+
+namespace lve::file
+{
+namespace
+{
+// smaller entries aren't worth starting threads for
+constexpr uint64_t parallel_threshold = 1 << 20;
+
+[[noreturn]] void throw_corrupt(std::string_view name)
+{
+    throw std::runtime_error(fmt::format("corrupt archive entry: {}", name));
+}
+} // namespace
+
+archive::archive(const std::filesystem::path& file_path)
+    : file_{file_path, access_pattern::random}
+{
+    const auto bytes = file_.bytes();
+    const auto fail  = [&](std::string_view reason) {
+        const auto path = std::filesystem::absolute(file_path);
+        throw std::runtime_error(fmt::format(
+            "failed to open archive: {}: {}", path.string(), reason));
+    };
+
+    if (bytes.size() < sizeof(archive_header))
+    {
+        fail("too small");
+    }
+    header_ = reinterpret_cast<const archive_header*>(bytes.data());
+    if (std::memcmp(header_->magic, archive_magic, sizeof(archive_magic)) != 0)
+    {
+        fail("not an archive");
+    }
+    if (header_->version != archive_version)
+    {
+        fail(fmt::format("version {} instead of {}",
+                         header_->version,
+                         archive_version));
+    }
+    if (header_->chunk_size == 0)
+    {
+        fail("no chunk size");
+    }
+
+    const auto entries_size =
+        uint64_t{header_->entry_count} * sizeof(archive_entry);
+    if (entries_size > bytes.size() - sizeof(archive_header))
+    {
+        fail("table of contents out of bounds");
+    }
+    entries_ = {reinterpret_cast<const archive_entry*>(header_ + 1),
+                header_->entry_count};
+
+    // the names run up to the first entry's data, or the end of the file
+    const auto names_offset = sizeof(archive_header) + entries_size;
+    auto names_end          = bytes.size();
+    for (const auto& entry : entries_)
+    {
+        if (entry.offset < names_offset || entry.offset > bytes.size() ||
+            entry.size > bytes.size() - entry.offset)
+        {
+            fail("entry out of bounds");
+        }
+        names_end = std::min<size_t>(names_end, entry.offset);
+    }
+    names_ = {reinterpret_cast<const char*>(bytes.data() + names_offset),
+              names_end - names_offset};
+    for (const auto& entry : entries_)
+    {
+        if (entry.name_offset > names_.size() ||
+            entry.name_size > names_.size() - entry.name_offset)
+        {
+            fail("entry name out of bounds");
+        }
+    }
+}
+
+const archive_entry* archive::find(std::string_view name) const
+{
+    const auto hash  = archive_hash(name);
+    const auto first = std::lower_bound(
+        entries_.begin(),
+        entries_.end(),
+        hash,
+        [](const archive_entry& entry, uint64_t hash) {
+            return entry.name_hash < hash;
+        });
+    for (auto entry = first;
+         entry != entries_.end() && entry->name_hash == hash;
+         ++entry)
+    {
+        if (this->name(*entry) == name)
+        {
+            return &*entry;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view archive::name(const archive_entry& entry) const
+{
+    return names_.substr(entry.name_offset, entry.name_size);
+}
+
+std::span<const std::byte> archive::view(const archive_entry& entry) const
+{
+    return file_.bytes().subspan(entry.offset, entry.size);
+}
+
+std::pmr::vector<std::byte> archive::load(std::string_view name) const
+{
+    const auto* entry = find(name);
+    if (!entry)
+    {
+        throw std::runtime_error(
+            fmt::format("no archive entry named: {}", name));
+    }
+    return load(*entry);
+}
+
+std::pmr::vector<std::byte> archive::load(const archive_entry& entry) const
+{
+    const auto data = view(entry);
+    if (entry.method == compression::stored)
+    {
+        if (entry.size != entry.original_size)
+        {
+            throw_corrupt(name(entry));
+        }
+        return {data.begin(), data.end()};
+    }
+    if (entry.method != compression::lz4)
+    {
+        throw std::runtime_error(
+            fmt::format("unknown compression of archive entry: {}",
+                        name(entry)));
+    }
+
+    const uint64_t chunk_size  = header_->chunk_size;
+    const uint64_t chunk_count = entry.chunk_count;
+    const auto sizes_size      = chunk_count * sizeof(uint32_t);
+    if (sizes_size > data.size() ||
+        chunk_count != (entry.original_size + chunk_size - 1) / chunk_size)
+    {
+        throw_corrupt(name(entry));
+    }
+
+    // where each chunk starts in the entry, entries are 4 KiB aligned so the
+    // sizes can be read in place
+    const auto* compressed_sizes =
+        reinterpret_cast<const uint32_t*>(data.data());
+    std::pmr::vector<uint64_t> chunk_offsets(chunk_count + 1);
+    chunk_offsets[0] = sizes_size;
+    for (uint64_t i = 0; i < chunk_count; ++i)
+    {
+        chunk_offsets[i + 1] = chunk_offsets[i] + compressed_sizes[i];
+    }
+    if (chunk_offsets.back() != data.size())
+    {
+        throw_corrupt(name(entry));
+    }
+
+    std::pmr::vector<std::byte> content(entry.original_size);
+    std::atomic<uint64_t> next_chunk = 0;
+    std::atomic<bool> corrupt        = false;
+
+    const auto decompress = [&] {
+        for (auto i = next_chunk++; i < chunk_count && !corrupt;
+             i = next_chunk++)
+        {
+            const auto expanded =
+                std::min(chunk_size, entry.original_size - i * chunk_size);
+            const auto result = LZ4_decompress_safe(
+                reinterpret_cast<const char*>(data.data() + chunk_offsets[i]),
+                reinterpret_cast<char*>(content.data() + i * chunk_size),
+                static_cast<int>(chunk_offsets[i + 1] - chunk_offsets[i]),
+                static_cast<int>(expanded));
+            if (result < 0 || static_cast<uint64_t>(result) != expanded)
+            {
+                corrupt = true;
+            }
+        }
+    };
+
+    std::pmr::vector<std::thread> helpers;
+    if (entry.original_size >= parallel_threshold)
+    {
+        const auto threads = std::min<uint64_t>(
+            chunk_count, std::max(std::thread::hardware_concurrency(), 1u));
+        for (uint64_t i = 1; i < threads; ++i)
+        {
+            helpers.emplace_back(decompress);
+        }
+    }
+    decompress();
+    for (auto& helper : helpers)
+    {
+        helper.join();
+    }
+
+    if (corrupt)
+    {
+        throw_corrupt(name(entry));
+    }
+    return content;
+}
+} // namespace lve::file
@@ -0,0 +1,504 @@
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <file/async_loader.hpp>
+#include <file/io.hpp>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace lve::file
+{
+namespace
+{
+// the loader whose callback runs on this thread with its queue slot still
+// held, the first load the callback queues takes the slot over
+thread_local const async_loader* slot_to_hand_over = nullptr;
+} // namespace
+
+class loader_backend
+{
+  public:
+    virtual ~loader_backend() = default;
+
+    virtual void submit(const std::filesystem::path& file_path,
+                        async_loader::callback on_loaded) = 0;
+};
+
+namespace
+{
+class thread_pool_backend final : public loader_backend
+{
+  public:
+    explicit thread_pool_backend(unsigned thread_count)
+    {
+        for (unsigned i = 0; i < thread_count; ++i)
+        {
+            threads_.emplace_back([this] { work(); });
+        }
+    }
+
+    ~thread_pool_backend() override
+    {
+        {
+            std::lock_guard lock{mutex_};
+            stopping_ = true;
+        }
+        queued_.notify_all();
+        for (auto& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void submit(const std::filesystem::path& file_path,
+                async_loader::callback on_loaded) override
+    {
+        {
+            std::lock_guard lock{mutex_};
+            requests_.push_back({file_path, std::move(on_loaded)});
+        }
+        queued_.notify_one();
+    }
+
+  private:
+    struct request
+    {
+        std::filesystem::path file_path;
+        async_loader::callback on_loaded;
+    };
+
+    void work()
+    {
+        for (;;)
+        {
+            request next;
+            {
+                std::unique_lock lock{mutex_};
+                queued_.wait(lock, [this] {
+                    return stopping_ || !requests_.empty();
+                });
+                if (requests_.empty())
+                {
+                    return;
+                }
+                next = std::move(requests_.front());
+                requests_.pop_front();
+            }
+
+            std::pmr::vector<std::byte> content;
+            std::exception_ptr error;
+            try
+            {
+                content = file::load(next.file_path);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            next.on_loaded(std::move(content), error);
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::deque<request> requests_;
+    bool stopping_ = false;
+    std::pmr::vector<std::thread> threads_;
+};
+
+#ifdef __linux__
+// io_uring through its system calls, without liburing. Files are opened on
+// the calling thread, their reads go to the kernel queue and one thread
+// reaps the completions and calls back.
+class io_uring_backend final : public loader_backend
+{
+  public:
+    // At most `entries` reads are in flight, the caller keeps them below
+    explicit io_uring_backend(unsigned entries)
+    {
+        io_uring_params params{};
+        // one entry more for the nop that stops the completion thread
+        ring_fd_ = static_cast<int>(
+            ::syscall(__NR_io_uring_setup, entries + 1, &params));
+        if (ring_fd_ < 0)
+        {
+            throw std::system_error(
+                errno, std::generic_category(), "failed to set up io_uring");
+        }
+
+        sq_ring_size_ =
+            params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_size_ =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            sq_ring_size_ = cq_ring_size_ =
+                std::max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ =
+            single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ =
+            static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (!sq_ring_ || !cq_ring_ || !sqes_)
+        {
+            const auto error = errno;
+            unmap();
+            throw std::system_error(
+                error, std::generic_category(), "failed to map io_uring");
+        }
+
+        auto* sq = static_cast<std::byte*>(sq_ring_);
+        auto* cq = static_cast<std::byte*>(cq_ring_);
+        sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        cqes_    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        // entries are used in ring order, the indirection array stays fixed
+        auto* sq_array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+        for (uint32_t i = 0; i < params.sq_entries; ++i)
+        {
+            sq_array[i] = i;
+        }
+
+        completion_thread_ = std::thread{[this] { reap(); }};
+    }
+
+    ~io_uring_backend() override
+    {
+        // the nop's completion is the last one the thread handles
+        push([](io_uring_sqe& sqe) { sqe.opcode = IORING_OP_NOP; });
+        completion_thread_.join();
+        unmap();
+    }
+
+    void submit(const std::filesystem::path& file_path,
+                async_loader::callback on_loaded) override
+    {
+        auto read = std::make_unique<request>();
+        read->file_path = file_path;
+        read->on_loaded = std::move(on_loaded);
+        read->fd        = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat status = {};
+        if (read->fd < 0 || ::fstat(read->fd, &status) != 0)
+        {
+            const auto path = std::filesystem::absolute(file_path);
+            fail(*read, fmt::format("failed to open file: {}", path.string()));
+            return;
+        }
+        read->content.resize(static_cast<size_t>(status.st_size));
+        queue_read(read.release());
+    }
+
+  private:
+    struct request
+    {
+        std::filesystem::path file_path;
+        async_loader::callback on_loaded;
+        int fd = -1;
+        std::pmr::vector<std::byte> content;
+        size_t offset = 0;
+        iovec buffer{};
+    };
+
+    void* map(size_t size, uint64_t offset)
+    {
+        void* ring = ::mmap(nullptr,
+                            size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            ring_fd_,
+                            static_cast<off_t>(offset));
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    void unmap()
+    {
+        if (sqes_)
+        {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && cq_ring_ != sq_ring_)
+        {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_)
+        {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        ::close(ring_fd_);
+    }
+
+    template <typename Prepare> void push(Prepare prepare)
+    {
+        std::lock_guard lock{submit_mutex_};
+        // only this side writes the tail, and the caller keeps the number in
+        // flight below the ring size, so the entry is free
+        const uint32_t tail = *sq_tail_;
+        auto& sqe           = sqes_[tail & sq_mask_];
+        std::memset(&sqe, 0, sizeof(sqe));
+        prepare(sqe);
+        std::atomic_ref{*sq_tail_}.store(tail + 1, std::memory_order_release);
+        while (::syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) <
+               0)
+        {
+            if (errno != EINTR)
+            {
+                throw std::system_error(
+                    errno, std::generic_category(), "failed to submit read");
+            }
+        }
+    }
+
+    // Reads the rest of the file, an empty file completes with a nop
+    void queue_read(request* read)
+    {
+        read->buffer = {read->content.data() + read->offset,
+                        read->content.size() - read->offset};
+        try
+        {
+            push([read](io_uring_sqe& sqe) {
+                sqe.opcode    = read->buffer.iov_len > 0 ? IORING_OP_READV
+                                                         : IORING_OP_NOP;
+                sqe.fd        = read->fd;
+                sqe.addr      = reinterpret_cast<uint64_t>(&read->buffer);
+                sqe.len       = 1;
+                sqe.off       = read->offset;
+                sqe.user_data = reinterpret_cast<uint64_t>(read);
+            });
+        }
+        catch (const std::system_error& error)
+        {
+            fail(*read, error.what());
+            delete read;
+        }
+    }
+
+    void reap()
+    {
+        for (;;)
+        {
+            if (::syscall(__NR_io_uring_enter,
+                          ring_fd_,
+                          0,
+                          1,
+                          IORING_ENTER_GETEVENTS,
+                          nullptr,
+                          0) < 0 &&
+                errno != EINTR)
+            {
+                // nothing left to do but spin until a completion shows up
+                std::this_thread::yield();
+            }
+
+            uint32_t head = *cq_head_;
+            const uint32_t tail =
+                std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire);
+            bool stop = false;
+            for (; head != tail; ++head)
+            {
+                const auto& cqe = cqes_[head & cq_mask_];
+                auto* read      = reinterpret_cast<request*>(cqe.user_data);
+                if (read)
+                {
+                    complete(read, cqe.res);
+                }
+                else
+                {
+                    stop = true;
+                }
+            }
+            std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+            if (stop)
+            {
+                return;
+            }
+        }
+    }
+
+    void complete(request* read, int result)
+    {
+        if (result < 0)
+        {
+            fail(*read,
+                 fmt::format("failed to read file: {}: {}",
+                             read->file_path.string(),
+                             std::strerror(-result)));
+        }
+        else if (read->offset += static_cast<size_t>(result);
+                 read->offset < read->content.size())
+        {
+            if (result > 0)
+            {
+                // short read, queue the rest
+                queue_read(read);
+                return;
+            }
+            fail(*read,
+                 fmt::format("failed to read file: {}: file shrank",
+                             read->file_path.string()));
+        }
+        else
+        {
+            ::close(read->fd);
+            read->on_loaded(std::move(read->content), nullptr);
+        }
+        delete read;
+    }
+
+    static void fail(request& read, const std::string& message)
+    {
+        if (read.fd >= 0)
+        {
+            ::close(read.fd);
+        }
+        read.on_loaded(
+            {}, std::make_exception_ptr(std::runtime_error(message)));
+    }
+
+    int ring_fd_         = -1;
+    void* sq_ring_       = nullptr;
+    void* cq_ring_       = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_  = nullptr;
+    size_t sqes_size_    = 0;
+    uint32_t* sq_tail_   = nullptr;
+    uint32_t sq_mask_    = 0;
+    uint32_t* cq_head_   = nullptr;
+    uint32_t* cq_tail_   = nullptr;
+    uint32_t cq_mask_    = 0;
+    io_uring_cqe* cqes_  = nullptr;
+    std::mutex submit_mutex_;
+    std::thread completion_thread_;
+};
+#endif
+} // namespace
+
+async_loader::async_loader(unsigned queue_depth, async_backend requested)
+    : backend_type_{requested}, queue_depth_{std::max(queue_depth, 1u)}
+{
+#ifdef __linux__
+    if (requested != async_backend::thread_pool)
+    {
+        try
+        {
+            backend_      = std::make_unique<io_uring_backend>(queue_depth_);
+            backend_type_ = async_backend::io_uring;
+            return;
+        }
+        catch (const std::system_error&)
+        {
+            // e.g. kernels before 5.1 or io_uring disabled by a sandbox
+            if (requested == async_backend::io_uring)
+            {
+                throw;
+            }
+        }
+    }
+#else
+    if (requested == async_backend::io_uring)
+    {
+        throw std::runtime_error("io_uring is not available");
+    }
+#endif
+    // blocking reads want more threads than there are cores
+    const auto threads = std::max(std::thread::hardware_concurrency(), 2u) * 2;
+    backend_ =
+        std::make_unique<thread_pool_backend>(std::min(queue_depth_, threads));
+    backend_type_ = async_backend::thread_pool;
+}
+
+async_loader::~async_loader()
+{
+    wait();
+}
+
+void async_loader::load(const std::filesystem::path& file_path,
+                        callback on_loaded)
+{
+    {
+        std::unique_lock lock{mutex_};
+        if (slot_to_hand_over == this)
+        {
+            // queued from a callback, which is the only thread that could
+            // free a slot if this waited for one
+            slot_to_hand_over = nullptr;
+        }
+        else
+        {
+            pending_changed_.wait(
+                lock, [this] { return in_flight_ < queue_depth_; });
+            ++in_flight_;
+        }
+        ++pending_;
+    }
+    backend_->submit(
+        file_path,
+        [this, on_loaded = std::move(on_loaded)](
+            std::pmr::vector<std::byte> content, std::exception_ptr error) {
+            // a load that fails to open calls back on the thread queuing
+            // it, which may be running a callback of its own
+            const auto* outer_slot = std::exchange(slot_to_hand_over, this);
+            on_loaded(std::move(content), error);
+            const bool slot_kept = slot_to_hand_over == this;
+            slot_to_hand_over    = outer_slot;
+            {
+                std::lock_guard lock{mutex_};
+                if (slot_kept)
+                {
+                    --in_flight_;
+                }
+                --pending_;
+            }
+            pending_changed_.notify_all();
+        });
+}
+
+std::future<std::pmr::vector<std::byte>> async_loader::load(
+    const std::filesystem::path& file_path)
+{
+    // std::function needs a copyable callback
+    auto promise =
+        std::make_shared<std::promise<std::pmr::vector<std::byte>>>();
+    auto loaded = promise->get_future();
+    load(file_path,
+         [promise](std::pmr::vector<std::byte> content,
+                   std::exception_ptr error) {
+             if (error)
+             {
+                 promise->set_exception(error);
+             }
+             else
+             {
+                 promise->set_value(std::move(content));
+             }
+         });
+    return loaded;
+}
+
+void async_loader::wait()
+{
+    std::unique_lock lock{mutex_};
+    pending_changed_.wait(lock, [this] { return pending_ == 0; });
+}
+} // namespace lve::file
@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <cassert>
+#include <file/chunked_reader.hpp>
+#include <fmt/format.h>
+#include <stdexcept>
+
+namespace lve::file
+{
+chunked_reader::chunked_reader(const std::filesystem::path& file_path,
+                               size_t chunk_size)
+    : file_{file_path, std::ios::binary}, buffer_(chunk_size)
+{
+    assert(chunk_size > 0 && "Chunk size must not be zero");
+    if (!file_.is_open())
+    {
+        const auto path = std::filesystem::absolute(file_path);
+        throw std::runtime_error(
+            fmt::format("failed to open file: {}", path.string()));
+    }
+    size_ = std::filesystem::file_size(file_path);
+}
+
+std::span<const std::byte> chunked_reader::next()
+{
+    const auto count = std::min(buffer_.size(), size_ - offset_);
+    if (count == 0)
+    {
+        return {};
+    }
+    file_.read(reinterpret_cast<char*>(buffer_.data()),
+               static_cast<std::streamsize>(count));
+    if (static_cast<size_t>(file_.gcount()) != count)
+    {
+        throw std::runtime_error(
+            fmt::format("failed to read file at offset {}", offset_));
+    }
+    offset_ += count;
+    return {buffer_.data(), count};
+}
+} // namespace lve::file
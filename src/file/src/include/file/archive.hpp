@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <file/mapped_file.hpp>
+#include <filesystem>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace lve::file
+{
+// Many assets packed into one file, so loading them costs a lookup instead
+// of an open and stat each.
+//
+// layout: archive_header, entry_count archive_entry sorted by name hash,
+//         the names, then the entry data, each entry 4 KiB aligned
+// A compressed entry starts with the compressed size of each of its chunks
+// as uint32_t, followed by the chunks. Every chunk but the last expands to
+// chunk_size bytes and is compressed on its own, so they can be expanded in
+// parallel.
+inline constexpr char archive_magic[4] = {'L', 'V', 'E', 'A'};
+inline constexpr uint32_t archive_version   = 1;
+inline constexpr uint64_t archive_alignment = 4096;
+
+enum class compression : uint32_t
+{
+    stored,
+    lz4,
+};
+
+struct archive_header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t chunk_size;
+};
+
+struct archive_entry
+{
+    uint64_t name_hash;
+    uint64_t offset;
+    // bytes in the archive, the chunk sizes included
+    uint64_t size;
+    uint64_t original_size;
+    // into the names that follow the entries
+    uint32_t name_offset;
+    uint32_t name_size;
+    compression method;
+    uint32_t chunk_count;
+};
+
+static_assert(sizeof(archive_header) == 16);
+static_assert(sizeof(archive_entry) == 48);
+
+// FNV-1a of the entry name, a path relative to the packed directory with
+// '/' separators
+constexpr uint64_t archive_hash(std::string_view name)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const char c : name)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// Reads an archive through a memory mapping. Stored entries are handed out
+// as views of the mapping, compressed ones are expanded on load.
+class archive
+{
+  public:
+    // Throws std::runtime_error for files that aren't archives of this
+    // version or whose table of contents points outside the file
+    explicit archive(const std::filesystem::path& file_path);
+
+    // nullptr when there is no entry of that name
+    const archive_entry* find(std::string_view name) const;
+
+    bool contains(std::string_view name) const
+    {
+        return find(name) != nullptr;
+    }
+
+    std::string_view name(const archive_entry& entry) const;
+
+    // The entry as it is in the archive, for stored entries its content
+    // without a copy. Valid as long as the archive.
+    std::span<const std::byte> view(const archive_entry& entry) const;
+
+    // The content of the entry, decompressed on as many threads as it has
+    // chunks, up to the hardware threads, when it is large. Throws
+    // std::runtime_error for unknown names and corrupt entries.
+    std::pmr::vector<std::byte> load(std::string_view name) const;
+    std::pmr::vector<std::byte> load(const archive_entry& entry) const;
+
+    std::span<const archive_entry> entries() const
+    {
+        return entries_;
+    }
+
+  private:
+    mapped_file file_;
+    const archive_header* header_ = nullptr;
+    std::span<const archive_entry> entries_;
+    std::string_view names_;
+};
+} // namespace lve::file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace lve::file
+{
+enum class async_backend
+{
+    // io_uring where the kernel offers it, the thread pool otherwise
+    automatic,
+    // Linux only, reads are queued to the kernel without a thread per read
+    io_uring,
+    // blocking loads on a pool of threads, works everywhere
+    thread_pool,
+};
+
+class loader_backend;
+
+// Loads whole files in the background with many of them in flight at once,
+// so the latency of each read overlaps with the others instead of adding up
+class async_loader
+{
+  public:
+    // Called once per load with the content, or with error set when the
+    // file couldn't be opened or read. Runs on an I/O thread, or on the
+    // calling thread when opening fails right away. Must not throw. The
+    // first load it queues takes over the queue slot of the load calling
+    // back, so it never waits. Further loads wait for a slot like any other.
+    using callback = std::function<void(std::pmr::vector<std::byte> content,
+                                        std::exception_ptr error)>;
+
+    static constexpr unsigned default_queue_depth = 256;
+
+    // Throws std::runtime_error when io_uring is asked for but unavailable
+    explicit async_loader(unsigned queue_depth    = default_queue_depth,
+                          async_backend requested = async_backend::automatic);
+    // Waits for the loads in flight
+    ~async_loader();
+
+    async_loader(const async_loader&) = delete;
+    async_loader& operator=(const async_loader&) = delete;
+
+    // Queues a load, blocks while queue_depth loads are in flight unless
+    // called from a callback, see above
+    void load(const std::filesystem::path& file_path, callback on_loaded);
+    std::future<std::pmr::vector<std::byte>> load(
+        const std::filesystem::path& file_path);
+
+    // Blocks until every queued load has called back
+    void wait();
+
+    async_backend backend() const
+    {
+        return backend_type_;
+    }
+
+  private:
+    async_backend backend_type_;
+    unsigned queue_depth_;
+    std::mutex mutex_;
+    std::condition_variable pending_changed_;
+    // loads holding a queue slot, released once they called back unless the
+    // callback queued a load taking it over
+    unsigned in_flight_ = 0;
+    // loads that haven't returned from their callback yet
+    unsigned pending_ = 0;
+    // last, so its threads are joined before the members they call back into
+    // are gone
+    std::unique_ptr<loader_backend> backend_;
+};
+} // namespace lve::file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace lve::file
+{
+// Reads a file front to back in fixed size chunks through one reused
+// buffer, so streaming a file of any size costs a single chunk of memory
+class chunked_reader
+{
+  public:
+    static constexpr size_t default_chunk_size = 1 << 20;
+
+    explicit chunked_reader(const std::filesystem::path& file_path,
+                            size_t chunk_size = default_chunk_size);
+
+    // The next chunk, empty once the whole file was read. The span is valid
+    // until the following call.
+    std::span<const std::byte> next();
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    // bytes handed out so far
+    size_t offset() const
+    {
+        return offset_;
+    }
+
+  private:
+    std::ifstream file_;
+    std::pmr::vector<std::byte> buffer_;
+    size_t size_   = 0;
+    size_t offset_ = 0;
+};
+} // namespace lve::file
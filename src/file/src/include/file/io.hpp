@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <filesystem>
+#include <memory_resource>
 #include <vector>
 
 namespace lve::file
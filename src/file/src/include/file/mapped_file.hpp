@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace lve::file
+{
+// How a mapping is going to be read, passed on to the OS read ahead
+enum class access_pattern
+{
+    normal,
+    sequential,
+    random,
+};
+
+// Read only mapping of a whole file. Pages are read in by the OS on first
+// access, so only the parts that are actually touched cost I/O and memory,
+// and parsing straight from the mapping needs no copy of the file.
+class mapped_file
+{
+  public:
+    explicit mapped_file(const std::filesystem::path& file_path,
+                         access_pattern pattern = access_pattern::normal);
+    ~mapped_file();
+
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    const std::byte* data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    std::span<const std::byte> bytes() const
+    {
+        return {data_, size_};
+    }
+
+    // Asks the OS to start reading the range in before it is accessed
+    void prefetch(size_t offset, size_t count) const;
+    // Drops the pages fully inside the range from memory, touching them
+    // again reads them back from the file. Lets a single pass over a file
+    // larger than memory keep its resident size bounded.
+    void release(size_t offset, size_t count) const;
+
+  private:
+    void close();
+
+    const std::byte* data_ = nullptr;
+    size_t size_           = 0;
+#ifdef _WIN32
+    void* file_    = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+} // namespace lve::file
@@ -6,7 +6,7 @@ namespace lve::file
 {
 std::pmr::vector<std::byte> load(const std::filesystem::path& file_path)
 {
-    std::basic_ifstream<std::byte> file(file_path, std::ios::binary);
+    std::ifstream file(file_path, std::ios::binary);
     if (!file.is_open())
     {
         const auto path        = std::filesystem::absolute(file_path);
@@ -17,7 +17,8 @@ std::pmr::vector<std::byte> load(const std::filesystem::path& file_path)
 
     std::pmr::vector<std::byte> content_buffer(
         std::filesystem::file_size(file_path));
-    file.read(content_buffer.data(), content_buffer.size());
+    file.read(reinterpret_cast<char*>(content_buffer.data()),
+              static_cast<std::streamsize>(content_buffer.size()));
     return content_buffer;
 }
 } // namespace lve::file
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <file/mapped_file.hpp>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace lve::file
+{
+namespace
+{
+[[noreturn]] void throw_map_error(const std::filesystem::path& file_path)
+{
+    const auto path = std::filesystem::absolute(file_path);
+    throw std::runtime_error(
+        fmt::format("failed to map file: {}", path.string()));
+}
+
+// [offset, offset + count) clamped to a mapping of the given size
+std::pair<size_t, size_t> clamp_range(size_t offset,
+                                      size_t count,
+                                      size_t size)
+{
+    offset = std::min(offset, size);
+    return {offset, offset + std::min(count, size - offset)};
+}
+} // namespace
+
+#ifdef _WIN32
+mapped_file::mapped_file(const std::filesystem::path& file_path,
+                         access_pattern pattern)
+{
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (pattern == access_pattern::sequential)
+    {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    }
+    else if (pattern == access_pattern::random)
+    {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+    file_ = CreateFileW(file_path.c_str(),
+                        GENERIC_READ,
+                        FILE_SHARE_READ,
+                        nullptr,
+                        OPEN_EXISTING,
+                        flags,
+                        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        file_ = nullptr;
+        throw_map_error(file_path);
+    }
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file_, &size);
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0)
+    {
+        return;
+    }
+    mapping_ =
+        CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_)
+    {
+        data_ = static_cast<const std::byte*>(
+            MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data_)
+    {
+        close();
+        throw_map_error(file_path);
+    }
+}
+
+void mapped_file::close()
+{
+    if (data_)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_)
+    {
+        CloseHandle(mapping_);
+    }
+    if (file_)
+    {
+        CloseHandle(file_);
+    }
+    data_    = nullptr;
+    size_    = 0;
+    mapping_ = nullptr;
+    file_    = nullptr;
+}
+
+void mapped_file::prefetch(size_t offset, size_t count) const
+{
+    const auto [begin, end] = clamp_range(offset, count, size_);
+    if (begin == end)
+    {
+        return;
+    }
+    WIN32_MEMORY_RANGE_ENTRY range{
+        const_cast<std::byte*>(data_ + begin), end - begin};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void mapped_file::release(size_t offset, size_t count) const
+{
+    const auto [begin, end] = clamp_range(offset, count, size_);
+    if (begin == end)
+    {
+        return;
+    }
+    // unlocking pages that were never locked trims them from the working set
+    VirtualUnlock(const_cast<std::byte*>(data_ + begin), end - begin);
+}
+#else
+mapped_file::mapped_file(const std::filesystem::path& file_path,
+                         access_pattern pattern)
+{
+    const int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw_map_error(file_path);
+    }
+    size_ = static_cast<size_t>(::lseek(fd, 0, SEEK_END));
+    if (size_ == 0)
+    {
+        ::close(fd);
+        return;
+    }
+    // the mapping keeps its own reference to the file
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        size_ = 0;
+        throw_map_error(file_path);
+    }
+    data_ = static_cast<const std::byte*>(data);
+
+    if (pattern == access_pattern::sequential)
+    {
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    else if (pattern == access_pattern::random)
+    {
+        ::madvise(data, size_, MADV_RANDOM);
+    }
+}
+
+void mapped_file::close()
+{
+    if (data_)
+    {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// hints are best effort, a failing madvise leaves the mapping as it was
+void mapped_file::prefetch(size_t offset, size_t count) const
+{
+    const auto [begin, end] = clamp_range(offset, count, size_);
+    if (begin == end)
+    {
+        return;
+    }
+    // madvise wants a page aligned start, widen the range to whole pages
+    const auto page  = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const auto first = begin / page * page;
+    ::madvise(
+        const_cast<std::byte*>(data_ + first), end - first, MADV_WILLNEED);
+}
+
+void mapped_file::release(size_t offset, size_t count) const
+{
+    const auto [begin, end] = clamp_range(offset, count, size_);
+    // only pages entirely inside the range, neighbours may still be in use
+    const auto page  = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const auto first = (begin + page - 1) / page * page;
+    const auto last  = end == size_ ? end : end / page * page;
+    if (first >= last)
+    {
+        return;
+    }
+    ::madvise(
+        const_cast<std::byte*>(data_ + first), last - first, MADV_DONTNEED);
+}
+#endif
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)}
+#ifdef _WIN32
+      ,
+      file_{std::exchange(other.file_, nullptr)},
+      mapping_{std::exchange(other.mapping_, nullptr)}
+#endif
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+        file_    = std::exchange(other.file_, nullptr);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+    }
+    return *this;
+}
+} // namespace lve::file
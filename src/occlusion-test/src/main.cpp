@@ -0,0 +1,116 @@
+// Checks OcclusionCuller against its own occluders: a box drawn into the
+// depth buffer must never hide itself, whatever float error its
+// interpolated depth picks up, and it must still hide a box behind it.
+//
+// usage: occlusion-test
+
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <glm/glm.hpp>
+#include <tutorial/bounds.hpp>
+#include <tutorial/camera.hpp>
+#include <tutorial/job_system.hpp>
+#include <tutorial/occlusion_culler.hpp>
+
+namespace
+{
+constexpr float ASPECT = 800.f / 600.f;
+// unit cubes in front of the camera, on a grid across the view
+constexpr float MIN_X    = -1.5f;
+constexpr float MAX_X    = 1.5f;
+constexpr float MIN_Z    = 1.2f;
+constexpr float MAX_Z    = 6.f;
+constexpr uint32_t STEPS = 60;
+
+uint32_t failures = 0;
+
+lve::BoundingBox unit_cube(glm::vec3 center)
+{
+    return {center - glm::vec3{0.5f}, center + glm::vec3{0.5f}};
+}
+
+void test_occluder_does_not_hide_itself(lve::OcclusionCuller& culler,
+                                        const glm::mat4& projection_view)
+{
+    const auto mesh = lve::OccluderMesh::from_box(unit_cube(glm::vec3{0.f}));
+    uint32_t hidden = 0;
+    uint32_t tested = 0;
+    for (uint32_t i = 0; i <= STEPS; ++i)
+    {
+        for (uint32_t j = 0; j <= STEPS; ++j)
+        {
+            const glm::vec3 center{MIN_X + (MAX_X - MIN_X) * i / STEPS,
+                                   0.f,
+                                   MIN_Z + (MAX_Z - MIN_Z) * j / STEPS};
+            culler.begin_frame(projection_view);
+            culler.add_occluder(mesh,
+                                glm::mat4{glm::vec4{1.f, 0.f, 0.f, 0.f},
+                                          glm::vec4{0.f, 1.f, 0.f, 0.f},
+                                          glm::vec4{0.f, 0.f, 1.f, 0.f},
+                                          glm::vec4{center, 1.f}});
+            culler.rasterize();
+            ++tested;
+            if (!culler.is_visible(unit_cube(center)))
+            {
+                if (hidden == 0)
+                {
+                    fmt::print(stderr,
+                               "cube at x={:.2f}, z={:.2f} hides itself\n",
+                               center.x,
+                               center.z);
+                }
+                ++hidden;
+            }
+        }
+    }
+    if (hidden != 0)
+    {
+        fmt::print(stderr,
+                   "{} of {} occluders hide themselves\n",
+                   hidden,
+                   tested);
+        ++failures;
+    }
+}
+
+void test_occluder_hides_box_behind(lve::OcclusionCuller& culler,
+                                    const glm::mat4& projection_view)
+{
+    // a wall across the view with a small box well behind it
+    const auto wall = lve::OccluderMesh::from_box(
+        {glm::vec3{-4.f, -4.f, 2.f}, glm::vec3{4.f, 4.f, 2.5f}});
+    culler.begin_frame(projection_view);
+    culler.add_occluder(wall, glm::mat4{1.f});
+    culler.rasterize();
+    if (culler.is_visible(unit_cube(glm::vec3{0.f, 0.f, 5.f})))
+    {
+        fmt::print(stderr, "box behind the wall is not culled\n");
+        ++failures;
+    }
+    if (!culler.is_visible(unit_cube(glm::vec3{0.f, 0.f, 1.f})))
+    {
+        fmt::print(stderr, "box in front of the wall is culled\n");
+        ++failures;
+    }
+}
+} // namespace
+
+int main()
+{
+    lve::JobSystem job_system;
+    lve::OcclusionCuller culler{job_system};
+    lve::LveCamera camera;
+    camera.set_perspective_projection(glm::radians(50.f), ASPECT, 0.1f, 100.f);
+    const auto projection_view = camera.get_projection() * camera.get_view();
+
+    test_occluder_does_not_hide_itself(culler, projection_view);
+    test_occluder_hides_box_behind(culler, projection_view);
+    if (failures != 0)
+    {
+        fmt::print(stderr, "{} checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    fmt::print("occlusion culling checks passed\n");
+    return EXIT_SUCCESS;
+}
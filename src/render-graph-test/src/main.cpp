@@ -0,0 +1,245 @@
+// Checks the render graph's planning without a device: culling, the
+// barriers between passes and the memory blocks transient images share.
+// Transient images get made up memory requirements in place of the ones
+// LveRenderGraph reads from the images it creates.
+//
+// usage: render-graph-test
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <memory_resource>
+#include <source_location>
+#include <string_view>
+#include <tutorial/render_graph_plan.hpp>
+#include <vector>
+
+namespace
+{
+constexpr VkExtent2D EXTENT{640, 480};
+constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+uint32_t failures = 0;
+
+void check(bool condition,
+           std::string_view what,
+           std::source_location location = std::source_location::current())
+{
+    if (!condition)
+    {
+        fmt::print(stderr,
+                   "{}:{}: {}\n",
+                   location.file_name(),
+                   location.line(),
+                   what);
+        ++failures;
+    }
+}
+
+// The planning steps LveRenderGraph::compile() runs, minus creating and
+// recording anything
+class TestPlan : public lve::RenderGraphPlan
+{
+  public:
+    void plan()
+    {
+        cull_passes();
+        order_passes();
+        set_.keys = transient_keys(false);
+        set_.images.assign(set_.keys.size(), {});
+        for (size_t i = 0; i < set_.keys.size(); ++i)
+        {
+            const auto extent = set_.keys[i].extent;
+            set_.images[i].requirements = {
+                .size = VkDeviceSize{extent.width} * extent.height * 4,
+                .alignment      = 256,
+                .memoryTypeBits = 0b11};
+        }
+        plan_memory_blocks(set_);
+        use_transient_set(set_);
+        plan_barriers(static_cast<uint32_t>(set_.blocks.size()));
+        choose_store_ops();
+    }
+
+    size_t block_count() const
+    {
+        return set_.blocks.size();
+    }
+
+    VkAttachmentStoreOp store_op(uint32_t pass, uint32_t attachment) const
+    {
+        return passes_[pass].attachments[attachment].store_op;
+    }
+
+  private:
+    TransientSet set_;
+};
+
+lve::RenderGraphImage import_swap_chain(TestPlan& graph)
+{
+    return graph.import_image(
+        "swap chain",
+        {.image   = VK_NULL_HANDLE,
+         .view    = VK_NULL_HANDLE,
+         .format  = COLOR_FORMAT,
+         .extent  = EXTENT,
+         .initial = {.layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                     .stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+         .final   = {.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                     .stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT}});
+}
+
+// the barrier of the pass for the image, nullptr without one
+const TestPlan::Barrier* find_barrier(const TestPlan& graph,
+                                      uint32_t pass,
+                                      lve::RenderGraphImage image)
+{
+    const auto barriers = graph.get_barriers(pass);
+    const auto barrier  = std::find_if(
+        barriers.begin(), barriers.end(), [&](const auto& barrier) {
+            return barrier.image && barrier.resource == image.index;
+        });
+    return barrier != barriers.end() ? &*barrier : nullptr;
+}
+
+void test_unread_pass_is_culled()
+{
+    TestPlan graph;
+    const auto swap_chain = import_swap_chain(graph);
+    const auto debug = graph.create_image("debug", {COLOR_FORMAT, EXTENT});
+    graph.add_pass(
+        "debug",
+        [&](TestPlan::PassBuilder& pass) {
+            pass.color_attachment(debug, VK_ATTACHMENT_LOAD_OP_CLEAR);
+        },
+        nullptr);
+    graph.add_pass(
+        "scene",
+        [&](TestPlan::PassBuilder& pass) {
+            pass.color_attachment(swap_chain, VK_ATTACHMENT_LOAD_OP_CLEAR);
+        },
+        nullptr);
+    graph.plan();
+
+    check(graph.is_culled(0), "pass nothing reads is not culled");
+    check(!graph.is_culled(1), "pass writing an imported image is culled");
+    const auto order = graph.get_pass_order();
+    check(order.size() == 1 && order[0] == 1, "culled pass is ordered");
+    check(graph.get_memory_block(debug) == UINT32_MAX,
+          "image of a culled pass has memory");
+    check(graph.block_count() == 0, "memory planned for no image");
+}
+
+void test_read_after_write_barrier()
+{
+    TestPlan graph;
+    const auto swap_chain = import_swap_chain(graph);
+    const auto color      = graph.create_image("color", {COLOR_FORMAT, EXTENT});
+    graph.add_pass(
+        "scene",
+        [&](TestPlan::PassBuilder& pass) {
+            pass.color_attachment(color, VK_ATTACHMENT_LOAD_OP_CLEAR);
+        },
+        nullptr);
+    graph.add_pass(
+        "post",
+        [&](TestPlan::PassBuilder& pass) {
+            pass.sampled(color);
+            pass.color_attachment(swap_chain, VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+        },
+        nullptr);
+    graph.plan();
+
+    const auto order = graph.get_pass_order();
+    check(order.size() == 2 && order[0] == 0 && order[1] == 1,
+          "reader ordered before the writer");
+    // the first use of a transient image transitions it from undefined
+    const auto* first = find_barrier(graph, 0, color);
+    check(first && first->old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
+              first->new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+          "no transition to the attachment layout");
+
+    const auto* barrier = find_barrier(graph, 1, color);
+    check(barrier != nullptr, "no barrier between the write and the read");
+    if (barrier)
+    {
+        check(barrier->old_layout ==
+                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL &&
+                  barrier->new_layout ==
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+              "read not transitioned to the shader read layout");
+        check(barrier->src_stages ==
+                      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT &&
+                  barrier->src_access == VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+              "read doesn't wait for the attachment write");
+        check(barrier->dst_stages == VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT &&
+                  barrier->dst_access == VK_ACCESS_SHADER_READ_BIT,
+              "barrier doesn't cover the fragment shader read");
+    }
+    check(graph.store_op(0, 0) == VK_ATTACHMENT_STORE_OP_STORE,
+          "attachment read later is not stored");
+
+    const auto final = graph.get_final_barriers();
+    check(final.size() == 1 && final[0].resource == swap_chain.index &&
+              final[0].new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+          "swap chain image not brought to the present layout");
+}
+
+void test_disjoint_transients_share_memory()
+{
+    // first and second are used by passes 0-1 and 2-3, middle by 1-2
+    TestPlan graph;
+    const auto swap_chain = import_swap_chain(graph);
+    const auto first  = graph.create_image("first", {COLOR_FORMAT, EXTENT});
+    const auto middle = graph.create_image("middle", {COLOR_FORMAT, EXTENT});
+    const auto second = graph.create_image("second", {COLOR_FORMAT, EXTENT});
+    const auto chain  = [&](lve::RenderGraphImage input,
+                           lve::RenderGraphImage output) {
+        graph.add_pass(
+            "chain",
+            [&](TestPlan::PassBuilder& pass) {
+                if (input.index != UINT32_MAX)
+                {
+                    pass.sampled(input);
+                }
+                pass.color_attachment(output, VK_ATTACHMENT_LOAD_OP_CLEAR);
+            },
+            nullptr);
+    };
+    chain({}, first);
+    chain(first, middle);
+    chain(middle, second);
+    chain(second, swap_chain);
+    graph.plan();
+
+    check(graph.get_pass_order().size() == 4, "chained pass culled");
+    check(graph.block_count() == 2, "transients not packed into two blocks");
+    check(graph.get_memory_block(first) == graph.get_memory_block(second),
+          "transients with disjoint lifetimes don't share a block");
+    check(graph.get_memory_block(middle) != graph.get_memory_block(first),
+          "transients with overlapping lifetimes share a block");
+
+    // taking over the block waits for the previous image's last read
+    const auto* takeover = find_barrier(graph, 2, second);
+    check(takeover &&
+              (takeover->src_stages &
+               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) != 0 &&
+              takeover->old_layout == VK_IMAGE_LAYOUT_UNDEFINED,
+          "image taking over a block doesn't wait for its previous user");
+}
+} // namespace
+
+int main()
+{
+    test_unread_pass_is_culled();
+    test_read_after_write_barrier();
+    test_disjoint_transients_share_memory();
+    if (failures != 0)
+    {
+        fmt::print(stderr, "{} checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    fmt::print("render graph planning checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+# Writes a header with the given SPIR-V modules as constexpr uint32_t arrays
+# and a table to look them up by file name.
+#
+#   cmake -DOUTPUT=<header> -DINPUTS=<a.spv,b.spv,...> -P embed_spirv.cmake
+#
+# INPUTS is comma separated because a list would be split into several
+# arguments on the custom command line.
+
+string(REPLACE "," ";" INPUTS "${INPUTS}")
+
+set(ARRAYS "")
+set(ENTRIES "")
+set(COUNT 0)
+foreach(INPUT IN LISTS INPUTS)
+    get_filename_component(
+        FILENAME
+        ${INPUT}
+        NAME)
+    string(MAKE_C_IDENTIFIER ${FILENAME} IDENTIFIER)
+
+    file(SIZE ${INPUT} SIZE)
+    math(EXPR REMAINDER "${SIZE} % 4")
+    if(SIZE EQUAL 0 OR NOT REMAINDER EQUAL 0)
+        message(FATAL_ERROR "${INPUT} is not a SPIR-V module")
+    endif()
+
+    # SPIR-V words are little endian on every target we build for
+    file(READ ${INPUT} HEX HEX)
+    string(
+        REGEX
+        REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])"
+                "0x\\4\\3\\2\\1u, "
+                WORDS
+                ${HEX})
+    # eight words per line, CMake regexes have no {n} repetition
+    set(WORD "0x[0-9a-f]+u, ")
+    string(
+        REGEX
+        REPLACE "(${WORD}${WORD}${WORD}${WORD}${WORD}${WORD}${WORD}${WORD})"
+                "\\1\n    "
+                WORDS
+                ${WORDS})
+    string(REPLACE " \n" "\n" WORDS "${WORDS}")
+    string(STRIP "${WORDS}" WORDS)
+    string(REGEX REPLACE ",$" "" WORDS "${WORDS}")
+
+    string(APPEND ARRAYS
+           "alignas(4) inline constexpr std::uint32_t ${IDENTIFIER}[] = {\n"
+           "    ${WORDS}};\n\n")
+    string(APPEND ENTRIES "    EmbeddedShader{\"${FILENAME}\", ${IDENTIFIER}},\n")
+    math(EXPR COUNT "${COUNT} + 1")
+endforeach()
+
+set(CONTENT
+    "// Generated by embed_spirv.cmake from the shaders target, do not edit.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace lve::shaders
+{
+${ARRAYS}struct EmbeddedShader
+{
+    std::string_view name;
+    std::span<const std::uint32_t> code;
+};
+
+inline constexpr std::array<EmbeddedShader, ${COUNT}> EMBEDDED_SHADERS{
+${ENTRIES}};
+
+// Code of the compiled shader with the given file name, empty if there is
+// no such shader
+constexpr std::span<const std::uint32_t> find_embedded(std::string_view name)
+{
+    for (const auto& shader : EMBEDDED_SHADERS)
+    {
+        if (shader.name == name)
+        {
+            return shader.code;
+        }
+    }
+    return {};
+}
+} // namespace lve::shaders
+")
+
+file(WRITE ${OUTPUT} "${CONTENT}")
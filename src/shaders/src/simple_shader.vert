@@ -4,12 +4,22 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 0) out vec3 frag_color;
 
-layout(push_constant) uniform Push {
-    mat4 transform;
-    vec3 color;
-} push;
+// specialization constants, mirrored by SimpleRenderSystem
+layout(constant_id = 0) const bool OBJECT_COLOR = false;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    float time;
+} global_ubo;
+
+layout(set = 1, binding = 0) uniform ObjectUbo {
+    mat4 model;
+    vec4 color;
+} object_ubo;
 
 void main() {
-    gl_Position = push.transform * vec4(position, 1.0);
-    frag_color = color;
+    gl_Position = global_ubo.projection * global_ubo.view * object_ubo.model *
+                  vec4(position, 1.0);
+    frag_color = OBJECT_COLOR ? object_ubo.color.rgb : color;
 }
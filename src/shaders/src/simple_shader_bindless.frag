@@ -0,0 +1,28 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 frag_color;
+layout(location = 1) in vec3 frag_position;
+layout(location = 2) flat in uint frag_texture;
+layout(location = 0) out vec4 out_color;
+
+// mirrors LveTextureStreamer::INVALID_SLOT, objects without a resident
+// texture keep their color
+const uint NO_TEXTURE = 0xffffffffu;
+
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+void main() {
+    if (frag_texture == NO_TEXTURE) {
+        out_color = vec4(frag_color, 1);
+        return;
+    }
+    // the models have no texture coordinates, the unit cube's faces are
+    // mapped by dropping the axis they face
+    vec3 side = abs(frag_position);
+    vec2 uv = side.x >= side.y && side.x >= side.z ? frag_position.zy
+            : side.y >= side.z                     ? frag_position.xz
+                                                   : frag_position.xy;
+    out_color = vec4(frag_color, 1) *
+                texture(textures[nonuniformEXT(frag_texture)], uv + 0.5);
+}
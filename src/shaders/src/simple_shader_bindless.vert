@@ -0,0 +1,41 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 0) out vec3 frag_color;
+layout(location = 1) out vec3 frag_position;
+layout(location = 2) flat out uint frag_texture;
+
+// specialization constants, mirrored by SimpleRenderSystem
+layout(constant_id = 0) const bool OBJECT_COLOR = false;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    float time;
+} global_ubo;
+
+struct ObjectUbo {
+    mat4 model;
+    vec4 color;
+    uint texture;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectUbo objects[];
+} object_buffers[];
+
+layout(push_constant) uniform Push {
+    uint object_buffer;
+} push;
+
+void main() {
+    ObjectUbo object =
+        object_buffers[push.object_buffer].objects[gl_InstanceIndex];
+    gl_Position = global_ubo.projection * global_ubo.view * object.model *
+                  vec4(position, 1.0);
+    frag_color = OBJECT_COLOR ? object.color.rgb : color;
+    frag_position = position;
+    frag_texture = object.texture;
+}
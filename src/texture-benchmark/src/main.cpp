@@ -0,0 +1,429 @@
+// Compares loading a texture from KTX2 with decoding it from PNG. The KTX2
+// file holds the whole mip chain in the format the GPU samples, so loading
+// it is a copy of each level out of a file mapping into the staging memory
+// the streamer uploads from. The PNG has to be decoded and its mip chain
+// generated before the same upload. Both files are written from one image,
+// a generated one unless a PNG is given, and are left in the output
+// directory, so the app can stream the KTX2 one with --texture. On Linux the
+// files are dropped from the page cache before each pass, so the passes
+// include reading the disk.
+//
+// usage: texture-benchmark [--image <file.png>] [--output <directory>]
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tutorial/ktx2_texture.hpp>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr double MiB                 = 1 << 20;
+constexpr uint32_t REPEATS           = 5;
+constexpr uint32_t GENERATED_SIZE    = 2048;
+constexpr uint32_t GENERATED_CHECKER = 64;
+constexpr VkFormat FORMAT            = VK_FORMAT_R8G8B8A8_SRGB;
+constexpr uint32_t BYTES_PER_PIXEL   = 4;
+constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER{
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+struct Image
+{
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    std::pmr::vector<uint8_t> pixels;
+};
+
+// Levels packed one after another from the largest, as the streamer stages
+// them
+struct MipChain
+{
+    std::pmr::vector<size_t> offsets;
+    std::pmr::vector<std::byte> bytes;
+};
+
+template <typename Function>
+double time_ms(const Function& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Evicts the file from the page cache so the next read comes from the disk
+void drop_cached(const std::filesystem::path& path)
+{
+#ifdef __linux__
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#endif
+}
+
+// a checker board over color gradients, which compresses about as well as
+// a texture with some detail
+Image generate_image()
+{
+    Image image{GENERATED_SIZE, GENERATED_SIZE, {}};
+    image.pixels.resize(size_t{GENERATED_SIZE} * GENERATED_SIZE *
+                        BYTES_PER_PIXEL);
+    for (uint32_t y = 0; y < GENERATED_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < GENERATED_SIZE; ++x)
+        {
+            const bool dark =
+                (x / GENERATED_CHECKER + y / GENERATED_CHECKER) % 2 != 0;
+            auto* pixel = &image.pixels[(size_t{y} * GENERATED_SIZE + x) *
+                                        BYTES_PER_PIXEL];
+            pixel[0] = static_cast<uint8_t>(x * 255 / GENERATED_SIZE);
+            pixel[1] = static_cast<uint8_t>(y * 255 / GENERATED_SIZE);
+            pixel[2] = dark ? 64 : 224;
+            pixel[3] = 255;
+        }
+    }
+    return image;
+}
+
+Image load_png(const std::filesystem::path& path)
+{
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+    auto* pixels = stbi_load(
+        path.string().c_str(), &width, &height, &channels, BYTES_PER_PIXEL);
+    if (!pixels)
+    {
+        throw std::runtime_error(fmt::format("Failed to load {}: {}",
+                                             path.string(),
+                                             stbi_failure_reason()));
+    }
+    Image image{static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                {}};
+    image.pixels.assign(
+        pixels, pixels + size_t{image.width} * image.height * BYTES_PER_PIXEL);
+    stbi_image_free(pixels);
+    return image;
+}
+
+// Box filters each level from the one before it, in sRGB space like a
+// loader without color management would
+MipChain generate_mips(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    const auto levels = static_cast<uint32_t>(
+        std::bit_width(std::max(width, height)));
+    MipChain chain;
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        chain.offsets.push_back(size);
+        size += size_t{std::max(width >> level, 1u)} *
+                std::max(height >> level, 1u) * BYTES_PER_PIXEL;
+    }
+    chain.bytes.resize(size);
+    std::memcpy(chain.bytes.data(),
+                pixels,
+                size_t{width} * height * BYTES_PER_PIXEL);
+
+    for (uint32_t level = 1; level < levels; ++level)
+    {
+        const auto source_width  = std::max(width >> (level - 1), 1u);
+        const auto source_height = std::max(height >> (level - 1), 1u);
+        const auto target_width  = std::max(width >> level, 1u);
+        const auto target_height = std::max(height >> level, 1u);
+        const auto* source       = reinterpret_cast<const uint8_t*>(
+            chain.bytes.data() + chain.offsets[level - 1]);
+        auto* target = reinterpret_cast<uint8_t*>(chain.bytes.data() +
+                                                  chain.offsets[level]);
+        for (uint32_t y = 0; y < target_height; ++y)
+        {
+            const auto y0 = std::min(y * 2, source_height - 1);
+            const auto y1 = std::min(y * 2 + 1, source_height - 1);
+            for (uint32_t x = 0; x < target_width; ++x)
+            {
+                const auto x0 = std::min(x * 2, source_width - 1);
+                const auto x1 = std::min(x * 2 + 1, source_width - 1);
+                for (uint32_t c = 0; c < BYTES_PER_PIXEL; ++c)
+                {
+                    auto at = [&](uint32_t sx, uint32_t sy) {
+                        return uint32_t{
+                            source[(size_t{sy} * source_width + sx) *
+                                       BYTES_PER_PIXEL +
+                                   c]};
+                    };
+                    target[(size_t{y} * target_width + x) * BYTES_PER_PIXEL +
+                           c] = static_cast<uint8_t>(
+                        (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) +
+                         2) /
+                        4);
+                }
+            }
+        }
+    }
+    return chain;
+}
+
+template <typename T>
+void append(std::pmr::vector<std::byte>& bytes, const T& value)
+{
+    const auto* begin = reinterpret_cast<const std::byte*>(&value);
+    bytes.insert(bytes.end(), begin, begin + sizeof(T));
+}
+
+// A KTX2 file of the chain's levels, smallest first as the format wants
+// them, with the basic data format descriptor of 8-bit sRGB RGBA
+void write_ktx2(const std::filesystem::path& path,
+                uint32_t width,
+                uint32_t height,
+                const MipChain& chain)
+{
+    const auto levels = static_cast<uint32_t>(chain.offsets.size());
+    constexpr uint32_t SAMPLE_COUNT   = 4;
+    constexpr uint32_t DFD_BLOCK_SIZE = 24 + 16 * SAMPLE_COUNT;
+    constexpr uint32_t DFD_SIZE       = 4 + DFD_BLOCK_SIZE;
+    const uint32_t dfd_offset         = 80 + 24 * levels;
+
+    std::pmr::vector<std::byte> bytes;
+    bytes.insert(bytes.end(),
+                 reinterpret_cast<const std::byte*>(KTX2_IDENTIFIER.data()),
+                 reinterpret_cast<const std::byte*>(KTX2_IDENTIFIER.data()) +
+                     KTX2_IDENTIFIER.size());
+    for (const uint32_t field : {static_cast<uint32_t>(FORMAT),
+                                 1u, // type size
+                                 width,
+                                 height,
+                                 0u, // depth
+                                 0u, // layers
+                                 1u, // faces
+                                 levels,
+                                 0u, // no supercompression
+                                 dfd_offset,
+                                 DFD_SIZE,
+                                 0u, // no key/value data
+                                 0u})
+    {
+        append(bytes, field);
+    }
+    // no supercompression global data
+    append(bytes, uint64_t{0});
+    append(bytes, uint64_t{0});
+
+    auto level_size = [&](uint32_t level) -> uint64_t {
+        const auto end =
+            level + 1 < levels ? chain.offsets[level + 1] : chain.bytes.size();
+        return end - chain.offsets[level];
+    };
+    // RGBA8 levels are 4 byte aligned wherever they start
+    uint64_t data_offset = dfd_offset + DFD_SIZE;
+    std::pmr::vector<uint64_t> level_offsets(levels);
+    for (uint32_t level = levels; level-- > 0;)
+    {
+        level_offsets[level] = data_offset;
+        data_offset += level_size(level);
+    }
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        append(bytes, level_offsets[level]);
+        append(bytes, level_size(level));
+        append(bytes, level_size(level));
+    }
+
+    // Khronos basic descriptor block: RGBSDA color model, BT.709 primaries,
+    // sRGB transfer, 1x1 texel blocks of 4 bytes
+    append(bytes, DFD_SIZE);
+    append(bytes, uint32_t{0});
+    append(bytes, (DFD_BLOCK_SIZE << 16) | 2u);
+    append(bytes, 1u | (1u << 8) | (2u << 16));
+    append(bytes, uint32_t{0});
+    append(bytes, BYTES_PER_PIXEL);
+    append(bytes, uint32_t{0});
+    // red, green, blue and a linear alpha
+    constexpr std::array<uint32_t, SAMPLE_COUNT> CHANNELS{0, 1, 2, 0x1F};
+    for (uint32_t sample = 0; sample < SAMPLE_COUNT; ++sample)
+    {
+        append(bytes, (sample * 8) | (7u << 16) | (CHANNELS[sample] << 24));
+        append(bytes, uint32_t{0});
+        append(bytes, uint32_t{0});
+        append(bytes, uint32_t{255});
+    }
+
+    for (uint32_t level = levels; level-- > 0;)
+    {
+        const auto* begin = chain.bytes.data() + chain.offsets[level];
+        bytes.insert(bytes.end(), begin, begin + level_size(level));
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    if (!file)
+    {
+        throw std::runtime_error(
+            fmt::format("Failed to write {}", path.string()));
+    }
+}
+
+// the chain as the streamer stages it, every level read out of the mapping
+MipChain load_ktx2(const std::filesystem::path& path)
+{
+    const lve::Ktx2Texture texture{path};
+    MipChain chain;
+    size_t size = 0;
+    for (uint32_t level = 0; level < texture.mip_levels(); ++level)
+    {
+        chain.offsets.push_back(size);
+        size += texture.level_size(level);
+    }
+    chain.bytes.resize(size);
+    for (uint32_t level = 0; level < texture.mip_levels(); ++level)
+    {
+        texture.load_level(level,
+                           std::span{chain.bytes}.subspan(
+                               chain.offsets[level],
+                               texture.level_size(level)));
+    }
+    return chain;
+}
+
+// the chain a PNG loader stages, decoding to 8-bit RGBA first
+MipChain decode_png(const std::filesystem::path& path)
+{
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+    auto* pixels = stbi_load(
+        path.string().c_str(), &width, &height, &channels, BYTES_PER_PIXEL);
+    if (!pixels)
+    {
+        throw std::runtime_error(fmt::format("Failed to decode {}: {}",
+                                             path.string(),
+                                             stbi_failure_reason()));
+    }
+    auto chain = generate_mips(pixels,
+                               static_cast<uint32_t>(width),
+                               static_cast<uint32_t>(height));
+    stbi_image_free(pixels);
+    return chain;
+}
+
+template <typename Load>
+MipChain run(std::string_view name,
+             const std::filesystem::path& path,
+             size_t extra_bytes,
+             const Load& load)
+{
+    MipChain chain;
+    double best = 0.0;
+    for (uint32_t i = 0; i < REPEATS; ++i)
+    {
+        drop_cached(path);
+        const auto ms = time_ms([&] { chain = load(path); });
+        best          = i == 0 ? ms : std::min(best, ms);
+    }
+    fmt::print("{:<5} {:8.2f} ms  {:7.2f} MiB on disk  {:7.2f} MiB staged  "
+               "{:7.2f} MiB decoded besides\n",
+               name,
+               best,
+               static_cast<double>(std::filesystem::file_size(path)) / MiB,
+               static_cast<double>(chain.bytes.size()) / MiB,
+               static_cast<double>(extra_bytes) / MiB);
+    return chain;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path image_path;
+    auto output = std::filesystem::temp_directory_path() / "texture-benchmark";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--image" && i + 1 < argc)
+        {
+            image_path = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            fmt::print(
+                stderr,
+                "usage: {} [--image <file.png>] [--output <directory>]\n",
+                argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    try
+    {
+        const auto image =
+            image_path.empty() ? generate_image() : load_png(image_path);
+        std::filesystem::create_directories(output);
+        const auto png_path  = output / "texture.png";
+        const auto ktx2_path = output / "texture.ktx2";
+        if (!stbi_write_png(png_path.string().c_str(),
+                            static_cast<int>(image.width),
+                            static_cast<int>(image.height),
+                            BYTES_PER_PIXEL,
+                            image.pixels.data(),
+                            static_cast<int>(image.width * BYTES_PER_PIXEL)))
+        {
+            throw std::runtime_error(
+                fmt::format("Failed to write {}", png_path.string()));
+        }
+        write_ktx2(
+            ktx2_path,
+            image.width,
+            image.height,
+            generate_mips(image.pixels.data(), image.width, image.height));
+        fmt::print("{}x{} RGBA, {} and {}, best of {}\n",
+                   image.width,
+                   image.height,
+                   png_path.string(),
+                   ktx2_path.string(),
+                   REPEATS);
+
+        const auto from_ktx2 = run("ktx2", ktx2_path, 0, load_ktx2);
+        const auto from_png  = run(
+            "png", png_path, image.pixels.size(), decode_png);
+        // the same levels either way, only the work to get them differs
+        if (from_ktx2.bytes != from_png.bytes)
+        {
+            fmt::print(stderr, "KTX2 and PNG levels differ\n");
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        fmt::print(stderr, "{}\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
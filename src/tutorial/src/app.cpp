@@ -1,52 +1,672 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
+#include <fmt/format.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <string>
 #include <tutorial/app.hpp>
+#include <tutorial/buffer.hpp>
 #include <tutorial/camera.hpp>
+#include <tutorial/ktx2_texture.hpp>
+#include <tutorial/shader_reloader.hpp>
 #include <tutorial/simple_render_system.hpp>
 
 namespace lve
 {
-FirstApp::FirstApp()
+FirstApp::FirstApp(AppOptions options)
+    : renderer_{window_,
+                device_,
+                job_system_.thread_count(),
+                std::move(options.swap_chain)},
+      resolution_scaler_{options.resolution}
 {
-    load_game_objects();
+    if (options.resize_test)
+    {
+        resize_test_.emplace();
+    }
+    // parallel_for runs no more ranges than the job system has threads
+    for (const auto count : options.record_threads)
+    {
+        record_threads_.push_back(
+            std::clamp(count, 1u, job_system_.thread_count()));
+    }
+    if (!record_threads_.empty())
+    {
+        record_ms_.resize(record_threads_.size());
+        renderer_.set_recording_thread_count(record_threads_.front());
+    }
+    global_pool_ =
+        LveDescriptorPool::Builder(device_)
+            .set_max_sets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .add_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                           LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .build();
+    if (device_.featureSupport().descriptorIndexing)
+    {
+        bindless_table_ =
+            std::make_unique<LveBindlessTable>(device_, layout_cache_);
+    }
+    texture_streamer_ =
+        std::make_unique<LveTextureStreamer>(device_, bindless_table_.get());
+    load_game_objects(options.objects);
+    if (!options.texture.empty())
+    {
+        load_texture(options.texture);
+    }
+    report_depth_memory();
 }
 
 void FirstApp::run()
 {
+    // ring of one GlobalUbo per frame in flight, mapped for the lifetime of
+    // the loop, each frame writes and reads only its own slot
+    LveBuffer global_ubo_ring{
+        device_,
+        sizeof(GlobalUbo),
+        LveSwapChain::MAX_FRAMES_IN_FLIGHT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        device_.properties.limits.minUniformBufferOffsetAlignment};
+    global_ubo_ring.map();
+
+    auto global_set_layout =
+        LveDescriptorSetLayout::Builder(device_)
+            .add_binding(0,
+                         VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                         VK_SHADER_STAGE_VERTEX_BIT |
+                             VK_SHADER_STAGE_FRAGMENT_BIT)
+            .set_cache(layout_cache_)
+            .build();
+    std::array<VkDescriptorSet, LveSwapChain::MAX_FRAMES_IN_FLIGHT>
+        global_descriptor_sets{};
+    for (uint32_t i = 0; i < global_descriptor_sets.size(); ++i)
+    {
+        auto buffer_info = global_ubo_ring.descriptor_info_for_index(i);
+        LveDescriptorWriter(*global_set_layout, *global_pool_)
+            .write_buffer(0, &buffer_info)
+            .build(global_descriptor_sets[i]);
+    }
+
+    // declared first so it outlives the render systems watching it
+    LveShaderReloader shader_reloader{SHADERS_DIRECTORY};
     SimpleRenderSystem simple_render_system(
-        device_, renderer_.get_swap_chain_render_pass());
+        device_,
+        renderer_.get_render_target(),
+        *global_set_layout,
+        layout_cache_,
+        pipeline_layout_cache_,
+        pipeline_library_cache_,
+        bindless_table_.get());
+    simple_render_system.watch_shaders(shader_reloader);
+    simple_render_system.set_texture_streamer(texture_streamer_.get());
     LveCamera camera{};
     // camera.set_view_direction(glm::vec3{0.f}, glm::vec3{0.5f, 0.f, 1.f});
     camera.set_view_target(glm::vec3{-1.f, -2.f, 2.f},
                            glm::vec3{0.f, 0.f, 2.5f});
 
+    const auto start_time = std::chrono::steady_clock::now();
+    auto current_time     = start_time;
     while (!window_.should_close())
     {
+        // waits here with low latency pacing, so the input read next is as
+        // recent as the GPU allows
+        renderer_.wait_for_frame();
         glfwPollEvents();
 
+        const auto new_time = std::chrono::steady_clock::now();
+        const float frame_time =
+            std::chrono::duration<float>(new_time - current_time).count();
+        const float elapsed_time =
+            std::chrono::duration<float>(new_time - start_time).count();
+        current_time = new_time;
+        if (resize_test_)
+        {
+            step_resize_test(frame_time);
+        }
+
         const auto aspect = renderer_.get_aspect_ratio();
 
         // camera.set_orthographic_projection(-aspect, aspect, -1, 1, -1, 1);
         camera.set_perspective_projection(
             glm::radians(50.f), aspect, 0.1f, 100.f);
 
-        if (auto command_buffer = renderer_.begin_frame())
+        if (auto command_buffer = renderer_.begin_frame(new_time))
         {
-            renderer_.begin_swap_chain_render_pass(command_buffer);
-            simple_render_system.render_game_objects(
-                command_buffer, game_objects_, camera);
-            renderer_.end_swap_chain_render_pass(command_buffer);
+            shader_reloader.apply_reloads();
+            const int frame_index = renderer_.get_frame_index();
+            FrameInfo frame_info{frame_index,
+                                 frame_time,
+                                 command_buffer,
+                                 camera,
+                                 global_descriptor_sets[frame_index],
+                                 renderer_.get_frame_descriptor_allocator()};
+
+            const GlobalUbo ubo{.projection = camera.get_projection(),
+                                .view       = camera.get_view(),
+                                .time       = elapsed_time};
+            global_ubo_ring.write_to_index(&ubo, frame_index);
+
+            FrameStats stats{};
+            stats.pacing.frame_ms     = frame_time * 1000.0;
+            stats.pacing.max_frame_ms = stats.pacing.frame_ms;
+            update_game_objects();
+            cull_game_objects(camera, stats);
+            stream_textures(camera, stats);
+
+            // the GPU time measured is of a frame rendered frames in flight
+            // ago, the scaler waits for changes to show before the next one
+            const auto full_extent = renderer_.get_swap_chain_extent();
+            resolution_scaler_.update(renderer_.supports_upscaling()
+                                          ? renderer_.get_gpu_frame_ms()
+                                          : std::nullopt);
+            const auto render_extent =
+                resolution_scaler_.scale_extent(full_extent);
+            // with dynamic resolution the scene always renders to its own
+            // image and is blitted to the swap chain, 1:1 at full scale, so
+            // a change of scale never changes the graph
+            const bool upscale = renderer_.supports_upscaling() &&
+                                 resolution_scaler_.is_enabled();
+            renderer_.set_render_extent(render_extent);
+            stats.resolution = resolution_scaler_.get_stats(full_extent);
+
+            // transient images are kept per frame in flight
+            render_graph_.reset(frame_index);
+            const auto swap_chain_image =
+                renderer_.import_swap_chain_image(render_graph_);
+            // full size, so a new scale only changes the area rendered to
+            // rather than the images
+            const auto scene_color =
+                upscale ? render_graph_.create_image(
+                              "scene color",
+                              {renderer_.get_swap_chain_image_format(),
+                               full_extent})
+                        : swap_chain_image;
+            const auto depth = render_graph_.create_image(
+                "depth", {renderer_.get_depth_format(), full_extent});
+            render_graph_.add_pass(
+                "scene",
+                [&](LveRenderGraph::PassBuilder& pass) {
+                    pass.color_attachment(scene_color,
+                                          VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                          {{0.1f, 0.1f, 0.1f, 1.0f}});
+                    pass.depth_attachment(depth, VK_ATTACHMENT_LOAD_OP_CLEAR);
+                    pass.render_area(render_extent);
+                    pass.secondary_command_buffers();
+                },
+                [&](VkCommandBuffer) {
+                    simple_render_system.render_game_objects_parallel(
+                        renderer_,
+                        job_system_,
+                        frame_info,
+                        game_objects_,
+                        visible_objects_,
+                        stats);
+                });
+            if (upscale)
+            {
+                render_graph_.add_pass(
+                    "upscale",
+                    [&](LveRenderGraph::PassBuilder& pass) {
+                        pass.transfer_source(scene_color);
+                        pass.transfer_destination(swap_chain_image);
+                    },
+                    [&](VkCommandBuffer command_buffer) {
+                        record_upscale(
+                            command_buffer,
+                            render_graph_.get_image(scene_color),
+                            render_extent,
+                            render_graph_.get_image(swap_chain_image),
+                            full_extent);
+                    });
+            }
+            render_graph_.compile();
+            render_graph_.execute(command_buffer);
+            stats.render_graph = render_graph_.get_stats();
             renderer_.end_frame();
+            renderer_.collect_latency(stats.latency);
+            report_stats(stats);
         }
     }
 
     vkDeviceWaitIdle(device_.device());
 }
 
+void FirstApp::update_game_objects()
+{
+    object_bounds_.resize(game_objects_.size());
+    job_system_.parallel_for(
+        game_objects_.size(),
+        MIN_OBJECTS_PER_UPDATE_RANGE,
+        [this](size_t begin, size_t end, uint32_t) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto& obj = game_objects_[i];
+                obj.transform.rotation = glm::mod(
+                    obj.transform.rotation + glm::vec3{0.01f, 0.02f, 0.02f},
+                    glm::two_pi<float>());
+                object_bounds_[i] = obj.model->get_bounds().transformed(
+                    obj.transform.mat4());
+            }
+        });
+}
+
+void FirstApp::cull_game_objects(const LveCamera& camera, FrameStats& stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    if (scene_bvh_.object_count() != object_bounds_.size())
+    {
+        scene_bvh_.build(object_bounds_);
+        stats.culling.rebuilt = true;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < object_bounds_.size(); ++i)
+        {
+            scene_bvh_.update(i, object_bounds_[i]);
+        }
+        scene_bvh_.refit();
+        if (scene_bvh_.needs_rebuild())
+        {
+            scene_bvh_.build(object_bounds_);
+            stats.culling.rebuilt = true;
+        }
+    }
+
+    visible_objects_.clear();
+    const auto frustum =
+        Frustum::from_matrix(camera.get_projection() * camera.get_view());
+    stats.culling.nodes_visited = scene_bvh_.query(frustum, visible_objects_);
+    // keep submission order stable regardless of tree layout
+    std::sort(visible_objects_.begin(), visible_objects_.end());
+
+    stats.culling.cpu_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    stats.culling.objects = static_cast<uint32_t>(object_bounds_.size());
+    stats.culling.visible = static_cast<uint32_t>(visible_objects_.size());
+
+    occlude_game_objects(camera, stats);
+}
+
+void FirstApp::occlude_game_objects(const LveCamera& camera, FrameStats& stats)
+{
+    const auto start           = std::chrono::steady_clock::now();
+    const auto projection_view = camera.get_projection() * camera.get_view();
+
+    // nearest occluders hide the most, order them by clip space w. They
+    // are kept by their position in visible_objects_.
+    std::pmr::vector<std::pair<float, uint32_t>> occluders;
+    for (uint32_t i = 0; i < visible_objects_.size(); ++i)
+    {
+        const auto index = visible_objects_[i];
+        if (game_objects_[index].occluder)
+        {
+            const auto center = object_bounds_[index].center();
+            const auto w      = (projection_view * glm::vec4{center, 1.f}).w;
+            occluders.emplace_back(w, i);
+        }
+    }
+    const auto occluder_count = std::min(occluders.size(), MAX_OCCLUDERS);
+    std::partial_sort(occluders.begin(),
+                      occluders.begin() + occluder_count,
+                      occluders.end());
+
+    // objects drawn as occluders are never tested, they would be tested
+    // against their own depth
+    std::pmr::vector<uint8_t> drawn(visible_objects_.size(), 0);
+    occlusion_culler_.begin_frame(projection_view);
+    for (size_t i = 0; i < occluder_count; ++i)
+    {
+        const auto position = occluders[i].second;
+        auto& obj           = game_objects_[visible_objects_[position]];
+        occlusion_culler_.add_occluder(*obj.occluder, obj.transform.mat4());
+        drawn[position] = 1;
+    }
+    occlusion_culler_.rasterize();
+
+    std::pmr::vector<uint8_t> occluded(visible_objects_.size(), 0);
+    job_system_.parallel_for(
+        visible_objects_.size(),
+        MIN_OBJECTS_PER_OCCLUSION_RANGE,
+        [&](size_t begin, size_t end, uint32_t) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const auto& bounds = object_bounds_[visible_objects_[i]];
+                occluded[i] =
+                    !drawn[i] && !occlusion_culler_.is_visible(bounds);
+            }
+        });
+    size_t kept = 0;
+    for (size_t i = 0; i < visible_objects_.size(); ++i)
+    {
+        if (!occluded[i])
+        {
+            visible_objects_[kept++] = visible_objects_[i];
+        }
+    }
+
+    stats.occlusion.cpu_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+    stats.occlusion.occluders = occlusion_culler_.occluder_count();
+    stats.occlusion.triangles = occlusion_culler_.triangle_count();
+    stats.occlusion.tested    = static_cast<uint32_t>(visible_objects_.size());
+    stats.occlusion.culled =
+        static_cast<uint32_t>(visible_objects_.size() - kept);
+    visible_objects_.resize(kept);
+}
+
+void FirstApp::stream_textures(const LveCamera& camera, FrameStats& stats)
+{
+    const auto projection_view = camera.get_projection() * camera.get_view();
+    // pixels per unit of view space size at distance 1
+    const auto height = static_cast<float>(window_.get_extent().height);
+    const auto pixels_per_unit = camera.get_projection()[1][1] * 0.5f * height;
+    job_system_.parallel_for(
+        visible_objects_.size(),
+        MIN_OBJECTS_PER_OCCLUSION_RANGE,
+        [&](size_t begin, size_t end, uint32_t) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const auto index = visible_objects_[i];
+                const auto& obj  = game_objects_[index];
+                if (obj.texture == INVALID_TEXTURE_ID)
+                {
+                    continue;
+                }
+                const auto& bounds = object_bounds_[index];
+                const auto extent  = bounds.extent();
+                const auto w =
+                    (projection_view * glm::vec4{bounds.center(), 1.f}).w;
+                const auto size = std::max({extent.x, extent.y, extent.z});
+                texture_streamer_->mark_visible(
+                    obj.texture, size * pixels_per_unit / std::max(w, 1e-3f));
+            }
+        });
+    texture_streamer_->update(stats.streaming);
+    renderer_.wait_for_transfer(texture_streamer_->get_transfer_wait_value());
+}
+
+void FirstApp::report_stats(const FrameStats& stats)
+{
+    auto& total = accumulated_stats_;
+    total.pacing.frame_ms += stats.pacing.frame_ms;
+    total.pacing.max_frame_ms =
+        std::max(total.pacing.max_frame_ms, stats.pacing.max_frame_ms);
+    total.recording.cpu_ms += stats.recording.cpu_ms;
+    total.recording.threads           = stats.recording.threads;
+    total.recording.secondary_buffers = stats.recording.secondary_buffers;
+    total.culling.cpu_ms += stats.culling.cpu_ms;
+    total.culling.objects = stats.culling.objects;
+    total.culling.visible += stats.culling.visible;
+    total.culling.nodes_visited += stats.culling.nodes_visited;
+    total.culling.rebuilt = total.culling.rebuilt || stats.culling.rebuilt;
+    total.occlusion.cpu_ms += stats.occlusion.cpu_ms;
+    total.occlusion.occluders += stats.occlusion.occluders;
+    total.occlusion.triangles += stats.occlusion.triangles;
+    total.occlusion.tested += stats.occlusion.tested;
+    total.occlusion.culled += stats.occlusion.culled;
+    total.sorting.cpu_ms += stats.sorting.cpu_ms;
+    total.sorting.draws += stats.sorting.draws;
+    total.sorting.state_changes += stats.sorting.state_changes;
+    total.sorting.state_changes_saved += stats.sorting.state_changes_saved;
+    total.streaming.cpu_ms += stats.streaming.cpu_ms;
+    total.streaming.textures = stats.streaming.textures;
+    total.streaming.resident = stats.streaming.resident;
+    total.streaming.pending  = stats.streaming.pending;
+    total.streaming.uploads += stats.streaming.uploads;
+    total.streaming.evictions += stats.streaming.evictions;
+    total.streaming.uploaded_bytes += stats.streaming.uploaded_bytes;
+    total.streaming.resident_bytes = stats.streaming.resident_bytes;
+    total.streaming.budget_bytes   = stats.streaming.budget_bytes;
+    total.render_graph.cpu_ms += stats.render_graph.cpu_ms;
+    total.render_graph.passes += stats.render_graph.passes;
+    total.render_graph.culled += stats.render_graph.culled;
+    total.render_graph.barriers += stats.render_graph.barriers;
+    total.render_graph.transient_images = stats.render_graph.transient_images;
+    total.render_graph.memory_blocks    = stats.render_graph.memory_blocks;
+    total.render_graph.transient_bytes  = stats.render_graph.transient_bytes;
+    total.render_graph.aliased_bytes    = stats.render_graph.aliased_bytes;
+    total.render_graph.lazy_bytes       = stats.render_graph.lazy_bytes;
+    total.resolution.gpu_ms += stats.resolution.gpu_ms;
+    total.resolution.scale += stats.resolution.scale;
+    total.resolution.target_ms = stats.resolution.target_ms;
+    total.resolution.width     = stats.resolution.width;
+    total.resolution.height    = stats.resolution.height;
+    total.resolution.min_scale =
+        accumulated_frames_ == 0
+            ? stats.resolution.min_scale
+            : std::min(total.resolution.min_scale, stats.resolution.min_scale);
+    total.resolution.max_scale =
+        accumulated_frames_ == 0
+            ? stats.resolution.max_scale
+            : std::max(total.resolution.max_scale, stats.resolution.max_scale);
+    total.resolution.drops += stats.resolution.drops;
+    total.resolution.raises += stats.resolution.raises;
+    total.latency.frames += stats.latency.frames;
+    total.latency.total_ms += stats.latency.total_ms;
+    total.latency.max_ms = std::max(total.latency.max_ms, stats.latency.max_ms);
+    total.latency.to_present = stats.latency.to_present;
+
+    if (++accumulated_frames_ < STATS_REPORT_INTERVAL)
+    {
+        return;
+    }
+    const auto frames = static_cast<double>(accumulated_frames_);
+    fmt::print("frame: {:.2f} ms average, {:.2f} ms max, {} swap chains "
+               "created\n",
+               total.pacing.frame_ms / frames,
+               total.pacing.max_frame_ms,
+               renderer_.get_swap_chain_recreations());
+    fmt::print("record: {:.3f} ms/frame, {} objects, {} secondary buffers "
+               "({} recording threads)\n",
+               total.recording.cpu_ms / frames,
+               game_objects_.size(),
+               total.recording.secondary_buffers,
+               total.recording.threads);
+    step_record_threads(total.recording.cpu_ms / frames);
+    fmt::print("sort: {:.3f} ms/frame, {:.1f} draws, {:.1f} state changes, "
+               "{:.1f} saved by sorting\n",
+               total.sorting.cpu_ms / frames,
+               total.sorting.draws / frames,
+               total.sorting.state_changes / frames,
+               total.sorting.state_changes_saved / frames);
+    fmt::print("cull: {:.3f} ms/frame, {:.1f} of {} objects visible, {:.1f} "
+               "nodes visited{}\n",
+               total.culling.cpu_ms / frames,
+               total.culling.visible / frames,
+               total.culling.objects,
+               total.culling.nodes_visited / frames,
+               total.culling.rebuilt ? ", bvh rebuilt" : "");
+    fmt::print("occlusion: {:.3f} ms/frame, {:.1f} of {:.1f} tested objects "
+               "culled by {:.1f} occluders ({:.1f} triangles)\n",
+               total.occlusion.cpu_ms / frames,
+               total.occlusion.culled / frames,
+               total.occlusion.tested / frames,
+               total.occlusion.occluders / frames,
+               total.occlusion.triangles / frames);
+    constexpr double MIB = 1024.0 * 1024.0;
+    fmt::print("stream: {:.3f} ms/frame, {} of {} textures resident ({} "
+               "pending), {:.1f} of {:.1f} MiB, {} uploads ({:.1f} MiB), {} "
+               "evictions\n",
+               total.streaming.cpu_ms / frames,
+               total.streaming.resident,
+               total.streaming.textures,
+               total.streaming.pending,
+               total.streaming.resident_bytes / MIB,
+               total.streaming.budget_bytes / MIB,
+               total.streaming.uploads,
+               total.streaming.uploaded_bytes / MIB,
+               total.streaming.evictions);
+    fmt::print("graph: {:.3f} ms/frame, {:.1f} passes ({:.1f} culled), {:.1f} "
+               "barriers, {} transient images in {} blocks, {:.1f} MiB ({:.1f} "
+               "MiB lazily allocated, {:.1f} MiB saved by aliasing)\n",
+               total.render_graph.cpu_ms / frames,
+               total.render_graph.passes / frames,
+               total.render_graph.culled / frames,
+               total.render_graph.barriers / frames,
+               total.render_graph.transient_images,
+               total.render_graph.memory_blocks,
+               total.render_graph.transient_bytes / MIB,
+               total.render_graph.lazy_bytes / MIB,
+               total.render_graph.aliased_bytes / MIB);
+    fmt::print("resolution: {:.2f} ms GPU against a {:.2f} ms budget, "
+               "scale {:.2f} average ({:.2f} to {:.2f}), {} drops, {} "
+               "raises, {}x{} last\n",
+               total.resolution.gpu_ms / frames,
+               total.resolution.target_ms,
+               total.resolution.scale / frames,
+               total.resolution.min_scale,
+               total.resolution.max_scale,
+               total.resolution.drops,
+               total.resolution.raises,
+               total.resolution.width,
+               total.resolution.height);
+    if (total.latency.frames > 0)
+    {
+        fmt::print("latency: {:.2f} ms average, {:.2f} ms max from input to "
+                   "{} ({}, {} frames in flight{})\n",
+                   total.latency.total_ms / total.latency.frames,
+                   total.latency.max_ms,
+                   total.latency.to_present ? "screen" : "GPU done",
+                   presentModeName(renderer_.get_present_mode()),
+                   renderer_.get_frames_in_flight(),
+                   renderer_.get_swap_chain_config().lowLatency
+                       ? ", low latency"
+                       : "");
+    }
+    accumulated_stats_  = {};
+    accumulated_frames_ = 0;
+}
+
+void FirstApp::step_record_threads(double record_ms)
+{
+    if (record_threads_.size() < 2)
+    {
+        return;
+    }
+    record_ms_[record_thread_index_] = record_ms;
+    if (++record_thread_index_ == record_threads_.size())
+    {
+        std::string comparison;
+        for (size_t i = 0; i < record_threads_.size(); ++i)
+        {
+            comparison += fmt::format("{}{} threads {:.3f} ms",
+                                      i == 0 ? "" : ", ",
+                                      record_threads_[i],
+                                      record_ms_[i]);
+        }
+        fmt::print("record by threads: {}\n", comparison);
+        record_thread_index_ = 0;
+    }
+    renderer_.set_recording_thread_count(
+        record_threads_[record_thread_index_]);
+}
+
+void FirstApp::record_upscale(VkCommandBuffer command_buffer,
+                              VkImage source,
+                              VkExtent2D source_extent,
+                              VkImage destination,
+                              VkExtent2D destination_extent)
+{
+    const auto corner = [](VkExtent2D extent) {
+        return VkOffset3D{static_cast<int32_t>(extent.width),
+                          static_cast<int32_t>(extent.height),
+                          1};
+    };
+    const VkImageBlit region{
+        .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .srcOffsets     = {{0, 0, 0}, corner(source_extent)},
+        .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .dstOffsets     = {{0, 0, 0}, corner(destination_extent)}};
+    // at full scale every texel is copied as is
+    const bool same_size = source_extent.width == destination_extent.width &&
+                           source_extent.height == destination_extent.height;
+    vkCmdBlitImage(command_buffer,
+                   source,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   destination,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1,
+                   &region,
+                   same_size ? VK_FILTER_NEAREST : VK_FILTER_LINEAR);
+}
+
+void FirstApp::report_depth_memory()
+{
+    // depth used to be an image per swap chain image, the render graph
+    // keeps one per frame in flight
+    const auto texel_bytes = [&]() -> uint64_t {
+        switch (renderer_.get_depth_format())
+        {
+        case VK_FORMAT_D16_UNORM:
+            return 2;
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return 8;
+        default:
+            return 4;
+        }
+    }();
+    constexpr uint64_t TEXELS_4K = 3840 * 2160;
+    constexpr double MIB         = 1024.0 * 1024.0;
+    const auto image_bytes       = TEXELS_4K * texel_bytes;
+
+    const uint64_t images = renderer_.get_swap_chain_image_count();
+    const uint64_t frames = renderer_.get_frames_in_flight();
+    const auto saved = images > frames ? (images - frames) * image_bytes : 0;
+    const bool lazy =
+        device_.findMemoryTypes(VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+    fmt::print("depth at 3840x2160: {:.1f} MiB for {} frames in flight "
+               "instead of {:.1f} MiB for {} swap chain images, {:.1f} MiB "
+               "saved{}\n",
+               frames * image_bytes / MIB,
+               frames,
+               images * image_bytes / MIB,
+               images,
+               saved / MIB,
+               lazy ? ", lazily allocated so tilers may not back it at all"
+                    : "");
+}
+
+void FirstApp::step_resize_test(float frame_time)
+{
+    auto& test = *resize_test_;
+    // the first frame has no previous one to be timed against
+    if (test.frames++ > 0)
+    {
+        const double frame_ms = frame_time * 1000.0;
+        test.total_frame_ms += frame_ms;
+        test.max_frame_ms = std::max(test.max_frame_ms, frame_ms);
+    }
+    if (test.frames % RESIZE_TEST_FRAMES_PER_SIZE != 0)
+    {
+        return;
+    }
+
+    const uint32_t resizes = test.frames / RESIZE_TEST_FRAMES_PER_SIZE;
+    if (resizes > RESIZE_TEST_SIZES.size() * RESIZE_TEST_ROUNDS)
+    {
+        fmt::print("resize test: {} resizes in {} frames, {:.2f} ms average, "
+                   "{:.2f} ms max frame time, {} swap chains created\n",
+                   resizes - 1,
+                   test.frames,
+                   test.total_frame_ms / (test.frames - 1),
+                   test.max_frame_ms,
+                   renderer_.get_swap_chain_recreations());
+        window_.close();
+        return;
+    }
+    const auto size = RESIZE_TEST_SIZES[resizes % RESIZE_TEST_SIZES.size()];
+    window_.set_size(static_cast<int>(size.width),
+                     static_cast<int>(size.height));
+}
+
 std::unique_ptr<LveModel> create_cube_model(LveDevice& device, glm::vec3 offset)
 {
     std::pmr::vector<LveModel::Vertex> vertices{
@@ -107,14 +727,51 @@ std::unique_ptr<LveModel> create_cube_model(LveDevice& device, glm::vec3 offset)
     return std::make_unique<LveModel>(device, vertices);
 }
 
-void FirstApp::load_game_objects()
+void FirstApp::load_game_objects(uint32_t object_count)
 {
     std::shared_ptr<LveModel> model =
         create_cube_model(device_, {.0f, .0f, .0f});
-    auto cube                  = LveGameObject::create_game_object();
-    cube.model                 = model;
-    cube.transform.translation = {.0f, .0f, 2.5f};
-    cube.transform.scale       = {.5f, .5f, .5f};
-    game_objects_.push_back(std::move(cube));
+    if (object_count == 0)
+    {
+        auto cube                  = LveGameObject::create_game_object();
+        cube.model                 = model;
+        cube.transform.translation = {.0f, .0f, 2.5f};
+        cube.transform.scale       = {.5f, .5f, .5f};
+        cube.occluder              = std::make_shared<const OccluderMesh>(
+            OccluderMesh::from_box(model->get_bounds()));
+        game_objects_.push_back(std::move(cube));
+        return;
+    }
+
+    // cubes filling a cube in front of the camera, none of them occluders,
+    // so every one in view is drawn and the record time scales with them
+    const auto side = static_cast<uint32_t>(
+        std::ceil(std::cbrt(static_cast<double>(object_count))));
+    const auto spacing = OBJECT_GRID_EXTENT / static_cast<float>(side);
+    const auto first   = glm::vec3{.0f, .0f, 2.5f} -
+                       0.5f * spacing * static_cast<float>(side - 1);
+    game_objects_.reserve(object_count);
+    for (uint32_t i = 0; i < object_count; ++i)
+    {
+        const glm::vec3 cell{static_cast<float>(i % side),
+                             static_cast<float>(i / side % side),
+                             static_cast<float>(i / (side * side))};
+        auto cube                  = LveGameObject::create_game_object();
+        cube.model                 = model;
+        cube.transform.translation = first + cell * spacing;
+        cube.transform.scale       = glm::vec3{0.5f * spacing};
+        game_objects_.push_back(std::move(cube));
+    }
+}
+
+void FirstApp::load_texture(const std::filesystem::path& texture_path)
+{
+    // the streamer reads the levels from the file mapping as they are needed
+    const auto texture = texture_streamer_->add_texture(
+        std::make_shared<const Ktx2Texture>(texture_path));
+    for (auto& obj : game_objects_)
+    {
+        obj.texture = texture;
+    }
 }
 } // namespace lve
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <tutorial/bindless.hpp>
+
+namespace lve
+{
+namespace
+{
+// slots may be written while the set is bound and left empty
+constexpr VkDescriptorBindingFlags BINDLESS_BINDING_FLAGS =
+    VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+// left per stage for the other sets of the pipeline layouts
+constexpr uint32_t RESERVED_DESCRIPTORS = 16;
+
+uint32_t without_reserve(uint32_t limit)
+{
+    return limit > RESERVED_DESCRIPTORS ? limit - RESERVED_DESCRIPTORS : 0;
+}
+} // namespace
+
+LveBindlessTable::LveBindlessTable(LveDevice& device,
+                                   LveDescriptorLayoutCache& layout_cache)
+{
+    const auto& features = device.featureSupport();
+    assert(features.descriptorIndexing &&
+           "Bindless table requires descriptor indexing");
+    buffer_slots_.capacity =
+        std::min(MAX_BUFFERS,
+                 without_reserve(features.maxUpdateAfterBindStorageBuffers));
+    image_slots_.capacity =
+        std::min(MAX_IMAGES,
+                 without_reserve(features.maxUpdateAfterBindSampledImages));
+    // buffers are fewer and each object needs one, images give way first
+    const auto resources =
+        without_reserve(features.maxUpdateAfterBindResources);
+    buffer_slots_.capacity = std::min(buffer_slots_.capacity, resources);
+    image_slots_.capacity  = std::min(image_slots_.capacity,
+                                     resources - buffer_slots_.capacity);
+    if (buffer_slots_.capacity == 0 || image_slots_.capacity == 0)
+    {
+        throw std::runtime_error(
+            "Failed to fit the bindless table in the descriptor limits.");
+    }
+    layout_ =
+        LveDescriptorSetLayout::Builder(device)
+            .add_binding(BUFFER_BINDING,
+                         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                         VK_SHADER_STAGE_ALL_GRAPHICS,
+                         buffer_slots_.capacity,
+                         BINDLESS_BINDING_FLAGS)
+            .add_binding(IMAGE_BINDING,
+                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                         VK_SHADER_STAGE_ALL_GRAPHICS,
+                         image_slots_.capacity,
+                         BINDLESS_BINDING_FLAGS)
+            .set_layout_flags(
+                VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+            .set_cache(layout_cache)
+            .build();
+    pool_ = LveDescriptorPool::Builder(device)
+                .set_max_sets(1)
+                .set_pool_flags(
+                    VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+                .add_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                               buffer_slots_.capacity)
+                .add_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                               image_slots_.capacity)
+                .build();
+    if (!pool_->allocate_descriptor(layout_->get_descriptor_set_layout(),
+                                    descriptor_set_))
+    {
+        throw std::runtime_error("Failed to allocate bindless descriptor set.");
+    }
+}
+
+uint32_t LveBindlessTable::add_buffer(
+    const VkDescriptorBufferInfo& buffer_info)
+{
+    std::lock_guard lock{mutex_};
+    const auto index = acquire_slot(buffer_slots_);
+    LveDescriptorWriter{*layout_}
+        .write_buffer(BUFFER_BINDING, &buffer_info, index)
+        .overwrite(descriptor_set_);
+    return index;
+}
+
+uint32_t LveBindlessTable::add_image(const VkDescriptorImageInfo& image_info)
+{
+    std::lock_guard lock{mutex_};
+    const auto index = acquire_slot(image_slots_);
+    LveDescriptorWriter{*layout_}
+        .write_image(IMAGE_BINDING, &image_info, index)
+        .overwrite(descriptor_set_);
+    return index;
+}
+
+void LveBindlessTable::remove_buffer(uint32_t index)
+{
+    std::lock_guard lock{mutex_};
+    release_slot(buffer_slots_, index);
+}
+
+void LveBindlessTable::remove_image(uint32_t index)
+{
+    std::lock_guard lock{mutex_};
+    release_slot(image_slots_, index);
+}
+
+uint32_t LveBindlessTable::acquire_slot(Slots& slots)
+{
+    if (!slots.free.empty())
+    {
+        const auto index = slots.free.back();
+        slots.free.pop_back();
+        return index;
+    }
+    if (slots.next == slots.capacity)
+    {
+        throw std::runtime_error("Bindless descriptor table is full.");
+    }
+    return slots.next++;
+}
+
+void LveBindlessTable::release_slot(Slots& slots, uint32_t index)
+{
+    assert(index < slots.next && "Releasing a slot that was never acquired");
+    // partially bound slots may keep a stale descriptor, nothing reads them
+    slots.free.push_back(index);
+}
+} // namespace lve
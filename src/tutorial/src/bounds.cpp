@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <tutorial/bounds.hpp>
+
+namespace lve
+{
+BoundingBox BoundingBox::transformed(const glm::mat4& transform) const
+{
+    if (is_empty())
+    {
+        return {};
+    }
+    // Arvo: each output axis is the translation plus the min/max of the
+    // products of the matrix rows with the box corners
+    BoundingBox result;
+    for (int row = 0; row < 3; ++row)
+    {
+        float low  = transform[3][row];
+        float high = transform[3][row];
+        for (int column = 0; column < 3; ++column)
+        {
+            const float a = transform[column][row] * min[column];
+            const float b = transform[column][row] * max[column];
+            low += std::min(a, b);
+            high += std::max(a, b);
+        }
+        result.min[row] = low;
+        result.max[row] = high;
+    }
+    return result;
+}
+
+float Ray::intersect(const BoundingBox& box, float max_distance) const
+{
+    float near = 0.f;
+    float far  = max_distance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float inverse = 1.f / direction[axis];
+        float t0            = (box.min[axis] - origin[axis]) * inverse;
+        float t1            = (box.max[axis] - origin[axis]) * inverse;
+        if (inverse < 0.f)
+        {
+            std::swap(t0, t1);
+        }
+        near = std::max(near, t0);
+        far  = std::min(far, t1);
+        if (far < near)
+        {
+            return -1.f;
+        }
+    }
+    return near;
+}
+
+Frustum Frustum::from_matrix(const glm::mat4& m)
+{
+    auto row = [&m](int i) {
+        return glm::vec4{m[0][i], m[1][i], m[2][i], m[3][i]};
+    };
+    Frustum frustum;
+    frustum.planes_[0] = row(3) + row(0); // left
+    frustum.planes_[1] = row(3) - row(0); // right
+    frustum.planes_[2] = row(3) + row(1); // top, y points down
+    frustum.planes_[3] = row(3) - row(1); // bottom
+    frustum.planes_[4] = row(2);          // near, depth starts at 0
+    frustum.planes_[5] = row(3) - row(2); // far
+    for (auto& plane : frustum.planes_)
+    {
+        plane /= glm::length(glm::vec3{plane.x, plane.y, plane.z});
+    }
+    return frustum;
+}
+
+Frustum::Containment Frustum::test(const BoundingBox& box) const
+{
+    auto result = Containment::inside;
+    for (const auto& plane : planes_)
+    {
+        const glm::vec3 normal{plane.x, plane.y, plane.z};
+        // corner furthest along the plane normal and the one opposite to it
+        const glm::vec3 positive{normal.x >= 0.f ? box.max.x : box.min.x,
+                                 normal.y >= 0.f ? box.max.y : box.min.y,
+                                 normal.z >= 0.f ? box.max.z : box.min.z};
+        const glm::vec3 negative{normal.x >= 0.f ? box.min.x : box.max.x,
+                                 normal.y >= 0.f ? box.min.y : box.max.y,
+                                 normal.z >= 0.f ? box.min.z : box.max.z};
+        if (glm::dot(normal, positive) + plane.w < 0.f)
+        {
+            return Containment::outside;
+        }
+        if (glm::dot(normal, negative) + plane.w < 0.f)
+        {
+            result = Containment::intersecting;
+        }
+    }
+    return result;
+}
+} // namespace lve
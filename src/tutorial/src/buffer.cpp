@@ -0,0 +1,108 @@
+#include <cassert>
+#include <cstring>
+#include <tutorial/buffer.hpp>
+
+namespace lve
+{
+VkDeviceSize LveBuffer::get_alignment(VkDeviceSize instance_size,
+                                      VkDeviceSize min_offset_alignment)
+{
+    if (min_offset_alignment > 0)
+    {
+        return (instance_size + min_offset_alignment - 1) &
+               ~(min_offset_alignment - 1);
+    }
+    return instance_size;
+}
+
+LveBuffer::LveBuffer(LveDevice& device,
+                     VkDeviceSize instance_size,
+                     uint32_t instance_count,
+                     VkBufferUsageFlags usage_flags,
+                     VkMemoryPropertyFlags memory_property_flags,
+                     VkDeviceSize min_offset_alignment)
+    : device_{device}, instance_count_{instance_count},
+      instance_size_{instance_size},
+      alignment_size_{get_alignment(instance_size, min_offset_alignment)},
+      usage_flags_{usage_flags}, memory_property_flags_{memory_property_flags}
+{
+    buffer_size_ = alignment_size_ * instance_count_;
+    device_.createBuffer(
+        buffer_size_, usage_flags_, memory_property_flags_, buffer_, memory_);
+}
+
+LveBuffer::~LveBuffer()
+{
+    unmap();
+    device_.deletionQueue().push(
+        [device = device_.device(), buffer = buffer_, memory = memory_] {
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+        });
+}
+
+VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset)
+{
+    assert(buffer_ && memory_ && "Called map on buffer before create");
+    return vkMapMemory(device_.device(), memory_, offset, size, 0, &mapped_);
+}
+
+void LveBuffer::unmap()
+{
+    if (mapped_)
+    {
+        vkUnmapMemory(device_.device(), memory_);
+        mapped_ = nullptr;
+    }
+}
+
+void LveBuffer::write_to_buffer(const void* data,
+                                VkDeviceSize size,
+                                VkDeviceSize offset)
+{
+    assert(mapped_ && "Cannot copy to unmapped buffer");
+
+    if (size == VK_WHOLE_SIZE)
+    {
+        std::memcpy(mapped_, data, buffer_size_);
+    }
+    else
+    {
+        auto* memory_offset = static_cast<char*>(mapped_) + offset;
+        std::memcpy(memory_offset, data, size);
+    }
+}
+
+VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset)
+{
+    VkMappedMemoryRange mapped_range{
+        .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = memory_,
+        .offset = offset,
+        .size   = size};
+    return vkFlushMappedMemoryRanges(device_.device(), 1, &mapped_range);
+}
+
+VkDescriptorBufferInfo LveBuffer::descriptor_info(VkDeviceSize size,
+                                                  VkDeviceSize offset) const
+{
+    return VkDescriptorBufferInfo{
+        .buffer = buffer_, .offset = offset, .range = size};
+}
+
+void LveBuffer::write_to_index(const void* data, uint32_t index)
+{
+    write_to_buffer(data, instance_size_, index * alignment_size_);
+}
+
+VkResult LveBuffer::flush_index(uint32_t index)
+{
+    return flush(alignment_size_, index * alignment_size_);
+}
+
+VkDescriptorBufferInfo LveBuffer::descriptor_info_for_index(
+    uint32_t index) const
+{
+    return descriptor_info(alignment_size_, index * alignment_size_);
+}
+} // namespace lve
@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <tutorial/bvh.hpp>
+
+namespace lve
+{
+namespace
+{
+// SAH weights of a node visit and of a single object box test
+constexpr float TRAVERSAL_COST    = 1.f;
+constexpr float INTERSECTION_COST = 1.f;
+// leaves may exceed MAX_LEAF_SIZE when no split beats testing every object,
+// but never this
+constexpr uint32_t MAX_UNSPLIT_LEAF_SIZE = 32;
+
+uint32_t bin_index(float centroid, float min, float scale)
+{
+    const auto bin = static_cast<int64_t>((centroid - min) * scale);
+    return static_cast<uint32_t>(
+        std::clamp<int64_t>(bin, 0, Bvh::BIN_COUNT - 1));
+}
+
+float node_weight(const Bvh::Node& node)
+{
+    return node.is_leaf() ? INTERSECTION_COST * node.count : TRAVERSAL_COST;
+}
+} // namespace
+
+void Bvh::build(const std::pmr::vector<BoundingBox>& object_bounds)
+{
+    object_bounds_   = object_bounds;
+    const auto count = static_cast<uint32_t>(object_bounds_.size());
+    object_indices_.resize(count);
+    std::iota(object_indices_.begin(), object_indices_.end(), 0u);
+    object_leaves_.assign(count, INVALID_INDEX);
+    dirty_leaves_.clear();
+    nodes_.clear();
+    build_cost_ = 0.f;
+    cost_       = 0.f;
+    if (count == 0)
+    {
+        return;
+    }
+
+    nodes_.reserve(2 * static_cast<size_t>(count) - 1);
+    nodes_.push_back({.first = 0, .count = count});
+    subdivide(0);
+    build_cost_ = compute_cost();
+    cost_       = build_cost_;
+}
+
+BoundingBox Bvh::centroid_bounds(uint32_t first, uint32_t count) const
+{
+    auto measure = [this](size_t begin, size_t end) {
+        BoundingBox centroids;
+        for (size_t i = begin; i < end; ++i)
+        {
+            centroids.expand(object_bounds_[object_indices_[i]].center());
+        }
+        return centroids;
+    };
+    if (job_system_ == nullptr || count <= PARALLEL_BINNING_THRESHOLD)
+    {
+        return measure(first, first + count);
+    }
+
+    std::pmr::vector<BoundingBox> partial(job_system_->thread_count());
+    job_system_->parallel_for(
+        count,
+        PARALLEL_BINNING_THRESHOLD / 4,
+        [&](size_t begin, size_t end, uint32_t range) {
+            partial[range] = measure(first + begin, first + end);
+        });
+    BoundingBox centroids;
+    for (const auto& box : partial)
+    {
+        centroids.expand(box);
+    }
+    return centroids;
+}
+
+Bvh::Bins Bvh::bin_objects(uint32_t first,
+                           uint32_t count,
+                           const BoundingBox& centroids) const
+{
+    const auto extent = centroids.extent();
+    auto accumulate   = [&](size_t begin, size_t end, Bins& bins) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const auto& box   = object_bounds_[object_indices_[i]];
+            const auto center = box.center();
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (extent[axis] <= 0.f)
+                {
+                    continue;
+                }
+                auto& bin = bins[axis][bin_index(center[axis],
+                                                 centroids.min[axis],
+                                                 BIN_COUNT / extent[axis])];
+                bin.bounds.expand(box);
+                ++bin.count;
+            }
+        }
+    };
+
+    Bins bins{};
+    if (job_system_ == nullptr || count <= PARALLEL_BINNING_THRESHOLD)
+    {
+        accumulate(first, first + count, bins);
+        return bins;
+    }
+
+    std::pmr::vector<Bins> partial(job_system_->thread_count());
+    job_system_->parallel_for(
+        count,
+        PARALLEL_BINNING_THRESHOLD / 4,
+        [&](size_t begin, size_t end, uint32_t range) {
+            accumulate(first + begin, first + end, partial[range]);
+        });
+    for (const auto& range_bins : partial)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (uint32_t b = 0; b < BIN_COUNT; ++b)
+            {
+                bins[axis][b].bounds.expand(range_bins[axis][b].bounds);
+                bins[axis][b].count += range_bins[axis][b].count;
+            }
+        }
+    }
+    return bins;
+}
+
+void Bvh::subdivide(uint32_t root_index)
+{
+    // explicit stack, a degenerate scene must not overflow the call stack
+    std::pmr::vector<uint32_t> stack{root_index};
+    while (!stack.empty())
+    {
+        const auto node_index = stack.back();
+        stack.pop_back();
+        const uint32_t first = nodes_[node_index].first;
+        const uint32_t count = nodes_[node_index].count;
+
+        BoundingBox bounds;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            bounds.expand(object_bounds_[object_indices_[i]]);
+        }
+        nodes_[node_index].bounds = bounds;
+
+        auto make_leaf = [&] {
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                object_leaves_[object_indices_[i]] = node_index;
+            }
+        };
+        if (count <= MAX_LEAF_SIZE)
+        {
+            make_leaf();
+            continue;
+        }
+
+        const auto centroids = centroid_bounds(first, count);
+        const auto extent    = centroids.extent();
+        const auto bins      = bin_objects(first, count, centroids);
+
+        // sweep the bins from both sides to evaluate every split plane
+        Split best;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (extent[axis] <= 0.f)
+            {
+                continue;
+            }
+            std::array<float, BIN_COUNT - 1> left_cost{};
+            std::array<uint32_t, BIN_COUNT - 1> left_counts{};
+            BoundingBox left_bounds;
+            uint32_t left_count = 0;
+            for (uint32_t b = 0; b < BIN_COUNT - 1; ++b)
+            {
+                left_bounds.expand(bins[axis][b].bounds);
+                left_count += bins[axis][b].count;
+                left_cost[b]   = left_bounds.surface_area() * left_count;
+                left_counts[b] = left_count;
+            }
+            BoundingBox right_bounds;
+            uint32_t right_count = 0;
+            for (uint32_t b = BIN_COUNT - 1; b > 0; --b)
+            {
+                right_bounds.expand(bins[axis][b].bounds);
+                right_count += bins[axis][b].count;
+                if (left_counts[b - 1] == 0 || right_count == 0)
+                {
+                    continue;
+                }
+                const float cost = left_cost[b - 1] +
+                                   right_bounds.surface_area() * right_count;
+                if (cost < best.cost)
+                {
+                    best = {.axis = axis, .bin = b, .cost = cost};
+                }
+            }
+        }
+
+        uint32_t left_count = 0;
+        if (best.axis >= 0)
+        {
+            const float split_cost =
+                TRAVERSAL_COST +
+                INTERSECTION_COST * best.cost / bounds.surface_area();
+            if (split_cost >= INTERSECTION_COST * count &&
+                count <= MAX_UNSPLIT_LEAF_SIZE)
+            {
+                make_leaf();
+                continue;
+            }
+            const auto axis  = best.axis;
+            const auto scale = BIN_COUNT / extent[axis];
+            const auto begin = object_indices_.begin() + first;
+            const auto middle =
+                std::partition(begin, begin + count, [&](uint32_t object) {
+                    const auto center = object_bounds_[object].center();
+                    return bin_index(center[axis],
+                                     centroids.min[axis],
+                                     scale) < best.bin;
+                });
+            left_count = static_cast<uint32_t>(middle - begin);
+        }
+        if (left_count == 0 || left_count == count)
+        {
+            // every centroid in one spot, halve the list instead
+            left_count = count / 2;
+        }
+
+        const auto left = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(
+            {.first = first, .count = left_count, .parent = node_index});
+        nodes_.push_back({.first  = first + left_count,
+                          .count  = count - left_count,
+                          .parent = node_index});
+        nodes_[node_index].first = left;
+        nodes_[node_index].count = 0;
+        stack.push_back(left + 1);
+        stack.push_back(left);
+    }
+}
+
+void Bvh::update(uint32_t object, const BoundingBox& bounds)
+{
+    assert(object < object_bounds_.size() && "Unknown BVH object");
+    if (object_bounds_[object] == bounds)
+    {
+        return;
+    }
+    object_bounds_[object] = bounds;
+    dirty_leaves_.push_back(object_leaves_[object]);
+}
+
+void Bvh::refit()
+{
+    if (dirty_leaves_.empty())
+    {
+        return;
+    }
+
+    auto recompute = [this](Node& node) {
+        BoundingBox bounds;
+        if (node.is_leaf())
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                bounds.expand(object_bounds_[object_indices_[i]]);
+            }
+        }
+        else
+        {
+            bounds = nodes_[node.first].bounds;
+            bounds.expand(nodes_[node.first + 1].bounds);
+        }
+        const bool changed = !(bounds == node.bounds);
+        node.bounds        = bounds;
+        return changed;
+    };
+
+    if (dirty_leaves_.size() * 4 > nodes_.size())
+    {
+        // children are always stored after their parent, so a reverse sweep
+        // visits them first
+        for (auto node = nodes_.rbegin(); node != nodes_.rend(); ++node)
+        {
+            recompute(*node);
+        }
+    }
+    else
+    {
+        std::sort(dirty_leaves_.begin(), dirty_leaves_.end());
+        dirty_leaves_.erase(
+            std::unique(dirty_leaves_.begin(), dirty_leaves_.end()),
+            dirty_leaves_.end());
+        for (auto node_index : dirty_leaves_)
+        {
+            // an unchanged node leaves its ancestors unchanged as well
+            while (node_index != INVALID_INDEX &&
+                   recompute(nodes_[node_index]))
+            {
+                node_index = nodes_[node_index].parent;
+            }
+        }
+    }
+    dirty_leaves_.clear();
+    cost_ = compute_cost();
+}
+
+float Bvh::compute_cost() const
+{
+    const float root_area =
+        nodes_.empty() ? 0.f : nodes_[0].bounds.surface_area();
+    if (root_area <= 0.f)
+    {
+        return 0.f;
+    }
+    float cost = 0.f;
+    for (const auto& node : nodes_)
+    {
+        cost += node.bounds.surface_area() * node_weight(node);
+    }
+    return cost / root_area;
+}
+
+void Bvh::collect(uint32_t node_index, std::pmr::vector<uint32_t>& out) const
+{
+    std::pmr::vector<uint32_t> stack{node_index};
+    while (!stack.empty())
+    {
+        const auto& node = nodes_[stack.back()];
+        stack.pop_back();
+        if (node.is_leaf())
+        {
+            out.insert(out.end(),
+                       object_indices_.begin() + node.first,
+                       object_indices_.begin() + node.first + node.count);
+        }
+        else
+        {
+            stack.push_back(node.first);
+            stack.push_back(node.first + 1);
+        }
+    }
+}
+
+uint32_t Bvh::query(const Frustum& frustum,
+                    std::pmr::vector<uint32_t>& visible) const
+{
+    if (nodes_.empty())
+    {
+        return 0;
+    }
+    uint32_t visited = 0;
+    std::pmr::vector<uint32_t> stack{0u};
+    while (!stack.empty())
+    {
+        const auto node_index = stack.back();
+        const auto& node      = nodes_[node_index];
+        stack.pop_back();
+        ++visited;
+
+        const auto containment = frustum.test(node.bounds);
+        if (containment == Frustum::Containment::outside)
+        {
+            continue;
+        }
+        if (containment == Frustum::Containment::inside)
+        {
+            collect(node_index, visible);
+            continue;
+        }
+        if (!node.is_leaf())
+        {
+            stack.push_back(node.first);
+            stack.push_back(node.first + 1);
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            const auto object = object_indices_[i];
+            if (frustum.test(object_bounds_[object]) !=
+                Frustum::Containment::outside)
+            {
+                visible.push_back(object);
+            }
+        }
+    }
+    return visited;
+}
+
+std::optional<Bvh::RayHit> Bvh::raycast(const Ray& ray,
+                                        float max_distance) const
+{
+    if (nodes_.empty() || ray.intersect(nodes_[0].bounds, max_distance) < 0.f)
+    {
+        return std::nullopt;
+    }
+    std::optional<RayHit> closest;
+    float limit = max_distance;
+    std::pmr::vector<uint32_t> stack{0u};
+    while (!stack.empty())
+    {
+        const auto& node = nodes_[stack.back()];
+        stack.pop_back();
+        // a closer hit may have been found since the node was pushed
+        if (ray.intersect(node.bounds, limit) < 0.f)
+        {
+            continue;
+        }
+        if (node.is_leaf())
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                const auto object = object_indices_[i];
+                const auto distance =
+                    ray.intersect(object_bounds_[object], limit);
+                if (distance >= 0.f)
+                {
+                    limit   = distance;
+                    closest = RayHit{.object = object, .distance = distance};
+                }
+            }
+            continue;
+        }
+
+        // visit the nearer child first by pushing it last
+        auto near_child    = node.first;
+        auto far_child     = node.first + 1;
+        auto near_distance = ray.intersect(nodes_[near_child].bounds, limit);
+        auto far_distance  = ray.intersect(nodes_[far_child].bounds, limit);
+        if (far_distance >= 0.f &&
+            (near_distance < 0.f || far_distance < near_distance))
+        {
+            std::swap(near_child, far_child);
+            std::swap(near_distance, far_distance);
+        }
+        if (far_distance >= 0.f)
+        {
+            stack.push_back(far_child);
+        }
+        if (near_distance >= 0.f)
+        {
+            stack.push_back(near_child);
+        }
+    }
+    return closest;
+}
+} // namespace lve
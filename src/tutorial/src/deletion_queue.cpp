@@ -0,0 +1,56 @@
+#include <tutorial/deletion_queue.hpp>
+#include <utility>
+
+namespace lve
+{
+LveDeletionQueue::~LveDeletionQueue()
+{
+    flush();
+}
+
+void LveDeletionQueue::push(std::function<void()> deleter)
+{
+    std::lock_guard lock{mutex_};
+    deletions_.push_back({frame_, std::move(deleter)});
+}
+
+void LveDeletionQueue::begin_frame(uint64_t frame)
+{
+    std::lock_guard lock{mutex_};
+    frame_ = frame;
+}
+
+void LveDeletionQueue::collect(uint64_t completed_frame)
+{
+    std::deque<Deletion> ready;
+    {
+        std::lock_guard lock{mutex_};
+        while (!deletions_.empty() &&
+               deletions_.front().frame <= completed_frame)
+        {
+            ready.push_back(std::move(deletions_.front()));
+            deletions_.pop_front();
+        }
+    }
+    // outside the lock, deleters may release objects that push in turn
+    for (auto& deletion : ready)
+    {
+        deletion.deleter();
+    }
+}
+
+void LveDeletionQueue::flush()
+{
+    // deleters may push more, which are run as well
+    while (size() > 0)
+    {
+        collect(UINT64_MAX);
+    }
+}
+
+size_t LveDeletionQueue::size() const
+{
+    std::lock_guard lock{mutex_};
+    return deletions_.size();
+}
+} // namespace lve
@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <stdexcept>
+#include <tutorial/descriptors.hpp>
+
+namespace lve
+{
+namespace
+{
+// Descriptors per set reserved in each allocator pool, by type
+constexpr std::array<std::pair<VkDescriptorType, float>, 5> POOL_RATIOS{{
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+}};
+
+void hash_combine(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+} // namespace
+
+LveDescriptorLayoutCache::~LveDescriptorLayoutCache()
+{
+    for (const auto& [key, layout] : layouts_)
+    {
+        vkDestroyDescriptorSetLayout(device_.device(), layout, nullptr);
+    }
+}
+
+VkDescriptorSetLayout LveDescriptorLayoutCache::create_descriptor_layout(
+    const std::pmr::vector<VkDescriptorSetLayoutBinding>& bindings,
+    VkDescriptorSetLayoutCreateFlags flags,
+    const std::pmr::vector<VkDescriptorBindingFlags>& binding_flags)
+{
+    assert((binding_flags.empty() || binding_flags.size() == bindings.size()) &&
+           "Binding flags must match bindings");
+    LayoutKey key{.flags = flags};
+    key.bindings.reserve(bindings.size());
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        key.bindings.push_back(
+            {bindings[i], binding_flags.empty() ? 0 : binding_flags[i]});
+    }
+    std::sort(key.bindings.begin(),
+              key.bindings.end(),
+              [](const LayoutBinding& a, const LayoutBinding& b) {
+                  return a.binding.binding < b.binding.binding;
+              });
+
+    std::lock_guard lock{mutex_};
+    if (auto it = layouts_.find(key); it != layouts_.end())
+    {
+        return it->second;
+    }
+
+    std::pmr::vector<VkDescriptorSetLayoutBinding> sorted_bindings;
+    std::pmr::vector<VkDescriptorBindingFlags> sorted_flags;
+    for (const auto& binding : key.bindings)
+    {
+        sorted_bindings.push_back(binding.binding);
+        sorted_flags.push_back(binding.flags);
+    }
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{
+        .sType =
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount  = static_cast<uint32_t>(sorted_flags.size()),
+        .pBindingFlags = sorted_flags.data()};
+    VkDescriptorSetLayoutCreateInfo layout_info{
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext        = binding_flags.empty() ? nullptr : &binding_flags_info,
+        .flags        = flags,
+        .bindingCount = static_cast<uint32_t>(sorted_bindings.size()),
+        .pBindings    = sorted_bindings.data()};
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(
+            device_.device(), &layout_info, nullptr, &layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor set layout.");
+    }
+    layouts_.emplace(std::move(key), layout);
+    return layout;
+}
+
+size_t LveDescriptorLayoutCache::size() const
+{
+    std::lock_guard lock{mutex_};
+    return layouts_.size();
+}
+
+bool LveDescriptorLayoutCache::LayoutKey::operator==(
+    const LayoutKey& other) const
+{
+    if (flags != other.flags || bindings.size() != other.bindings.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        const auto& a = bindings[i];
+        const auto& b = other.bindings[i];
+        // immutable samplers are not supported by the cache
+        if (a.binding.binding != b.binding.binding ||
+            a.binding.descriptorType != b.binding.descriptorType ||
+            a.binding.descriptorCount != b.binding.descriptorCount ||
+            a.binding.stageFlags != b.binding.stageFlags ||
+            a.flags != b.flags)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t LveDescriptorLayoutCache::LayoutKeyHash::operator()(
+    const LayoutKey& key) const
+{
+    size_t seed = std::hash<uint32_t>{}(key.flags);
+    for (const auto& [binding, flags] : key.bindings)
+    {
+        // pack the fields of a binding into one word before mixing it in
+        const uint64_t packed = uint64_t{binding.binding} |
+                                uint64_t{binding.descriptorType} << 8 |
+                                uint64_t{binding.stageFlags} << 16 |
+                                uint64_t{binding.descriptorCount} << 32;
+        hash_combine(seed, std::hash<uint64_t>{}(packed));
+        hash_combine(seed, std::hash<uint32_t>{}(flags));
+    }
+    return seed;
+}
+
+LveDescriptorAllocator::LveDescriptorAllocator(LveDevice& device,
+                                               uint32_t sets_per_pool)
+    : device_{device}, sets_per_pool_{sets_per_pool}
+{
+}
+
+LveDescriptorAllocator::~LveDescriptorAllocator()
+{
+    for (auto pool : used_pools_)
+    {
+        vkDestroyDescriptorPool(device_.device(), pool, nullptr);
+    }
+    for (auto pool : free_pools_)
+    {
+        vkDestroyDescriptorPool(device_.device(), pool, nullptr);
+    }
+}
+
+VkDescriptorSet LveDescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+    std::lock_guard lock{mutex_};
+    if (current_pool_ == VK_NULL_HANDLE)
+    {
+        current_pool_ = grab_pool();
+        used_pools_.push_back(current_pool_);
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info{
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = current_pool_,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &layout};
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    auto result = vkAllocateDescriptorSets(device_.device(), &alloc_info, &set);
+    if (result == VK_ERROR_FRAGMENTED_POOL ||
+        result == VK_ERROR_OUT_OF_POOL_MEMORY)
+    {
+        // the current pool is full, retry once with a fresh one
+        current_pool_ = grab_pool();
+        used_pools_.push_back(current_pool_);
+        alloc_info.descriptorPool = current_pool_;
+        result = vkAllocateDescriptorSets(device_.device(), &alloc_info, &set);
+    }
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate descriptor set.");
+    }
+    return set;
+}
+
+void LveDescriptorAllocator::reset_pools()
+{
+    std::lock_guard lock{mutex_};
+    for (auto pool : used_pools_)
+    {
+        vkResetDescriptorPool(device_.device(), pool, 0);
+        free_pools_.push_back(pool);
+    }
+    used_pools_.clear();
+    current_pool_ = VK_NULL_HANDLE;
+}
+
+size_t LveDescriptorAllocator::pool_count() const
+{
+    std::lock_guard lock{mutex_};
+    return used_pools_.size() + free_pools_.size();
+}
+
+VkDescriptorPool LveDescriptorAllocator::grab_pool()
+{
+    if (!free_pools_.empty())
+    {
+        auto pool = free_pools_.back();
+        free_pools_.pop_back();
+        return pool;
+    }
+
+    std::array<VkDescriptorPoolSize, POOL_RATIOS.size()> pool_sizes;
+    for (size_t i = 0; i < POOL_RATIOS.size(); ++i)
+    {
+        pool_sizes[i] = {POOL_RATIOS[i].first,
+                         static_cast<uint32_t>(POOL_RATIOS[i].second *
+                                               sets_per_pool_)};
+    }
+    VkDescriptorPoolCreateInfo pool_info{
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags         = 0,
+        .maxSets       = sets_per_pool_,
+        .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+        .pPoolSizes    = pool_sizes.data()};
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(device_.device(), &pool_info, nullptr, &pool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor pool.");
+    }
+    return pool;
+}
+
+LveDescriptorSetLayout::Builder& LveDescriptorSetLayout::Builder::add_binding(
+    uint32_t binding,
+    VkDescriptorType descriptor_type,
+    VkShaderStageFlags stage_flags,
+    uint32_t count,
+    VkDescriptorBindingFlags flags)
+{
+    assert(bindings_.count(binding) == 0 && "Binding already in use");
+    bindings_[binding] = VkDescriptorSetLayoutBinding{
+        .binding         = binding,
+        .descriptorType  = descriptor_type,
+        .descriptorCount = count,
+        .stageFlags      = stage_flags};
+    if (flags != 0)
+    {
+        binding_flags_[binding] = flags;
+    }
+    return *this;
+}
+
+LveDescriptorSetLayout::Builder& LveDescriptorSetLayout::Builder::
+    set_layout_flags(VkDescriptorSetLayoutCreateFlags flags)
+{
+    layout_flags_ = flags;
+    return *this;
+}
+
+LveDescriptorSetLayout::Builder& LveDescriptorSetLayout::Builder::set_cache(
+    LveDescriptorLayoutCache& cache)
+{
+    cache_ = &cache;
+    return *this;
+}
+
+std::unique_ptr<LveDescriptorSetLayout> LveDescriptorSetLayout::Builder::build()
+    const
+{
+    return std::make_unique<LveDescriptorSetLayout>(
+        device_, bindings_, binding_flags_, layout_flags_, cache_);
+}
+
+LveDescriptorSetLayout::LveDescriptorSetLayout(
+    LveDevice& device,
+    std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+    const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& binding_flags,
+    VkDescriptorSetLayoutCreateFlags flags,
+    LveDescriptorLayoutCache* cache)
+    : device_{device}, bindings_{std::move(bindings)},
+      owns_layout_{cache == nullptr}
+{
+    std::pmr::vector<VkDescriptorSetLayoutBinding> set_layout_bindings;
+    std::pmr::vector<VkDescriptorBindingFlags> set_layout_binding_flags;
+    set_layout_bindings.reserve(bindings_.size());
+    for (const auto& [index, binding] : bindings_)
+    {
+        set_layout_bindings.push_back(binding);
+        const auto it = binding_flags.find(index);
+        set_layout_binding_flags.push_back(
+            it != binding_flags.end() ? it->second : 0);
+    }
+    if (binding_flags.empty())
+    {
+        set_layout_binding_flags.clear();
+    }
+
+    if (cache)
+    {
+        descriptor_set_layout_ = cache->create_descriptor_layout(
+            set_layout_bindings, flags, set_layout_binding_flags);
+        return;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{
+        .sType =
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount  = static_cast<uint32_t>(set_layout_binding_flags.size()),
+        .pBindingFlags = set_layout_binding_flags.data()};
+    VkDescriptorSetLayoutCreateInfo layout_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = set_layout_binding_flags.empty() ? nullptr
+                                                  : &binding_flags_info,
+        .flags = flags,
+        .bindingCount = static_cast<uint32_t>(set_layout_bindings.size()),
+        .pBindings    = set_layout_bindings.data()};
+    if (vkCreateDescriptorSetLayout(device_.device(),
+                                    &layout_info,
+                                    nullptr,
+                                    &descriptor_set_layout_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor set layout.");
+    }
+}
+
+LveDescriptorSetLayout::~LveDescriptorSetLayout()
+{
+    if (owns_layout_)
+    {
+        vkDestroyDescriptorSetLayout(
+            device_.device(), descriptor_set_layout_, nullptr);
+    }
+}
+
+std::pmr::vector<VkDescriptorSetLayoutBinding> LveDescriptorSetLayout::
+    get_bindings() const
+{
+    std::pmr::vector<VkDescriptorSetLayoutBinding> bindings;
+    bindings.reserve(bindings_.size());
+    for (const auto& [index, binding] : bindings_)
+    {
+        bindings.push_back(binding);
+    }
+    std::sort(bindings.begin(),
+              bindings.end(),
+              [](const auto& a, const auto& b) {
+                  return a.binding < b.binding;
+              });
+    return bindings;
+}
+
+LveDescriptorPool::Builder& LveDescriptorPool::Builder::add_pool_size(
+    VkDescriptorType descriptor_type,
+    uint32_t count)
+{
+    pool_sizes_.push_back({descriptor_type, count});
+    return *this;
+}
+
+LveDescriptorPool::Builder& LveDescriptorPool::Builder::set_pool_flags(
+    VkDescriptorPoolCreateFlags flags)
+{
+    pool_flags_ = flags;
+    return *this;
+}
+
+LveDescriptorPool::Builder& LveDescriptorPool::Builder::set_max_sets(
+    uint32_t count)
+{
+    max_sets_ = count;
+    return *this;
+}
+
+std::unique_ptr<LveDescriptorPool> LveDescriptorPool::Builder::build() const
+{
+    return std::make_unique<LveDescriptorPool>(
+        device_, max_sets_, pool_flags_, pool_sizes_);
+}
+
+LveDescriptorPool::LveDescriptorPool(
+    LveDevice& device,
+    uint32_t max_sets,
+    VkDescriptorPoolCreateFlags pool_flags,
+    const std::pmr::vector<VkDescriptorPoolSize>& pool_sizes)
+    : device_{device}
+{
+    VkDescriptorPoolCreateInfo pool_info{
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags         = pool_flags,
+        .maxSets       = max_sets,
+        .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+        .pPoolSizes    = pool_sizes.data()};
+    if (vkCreateDescriptorPool(
+            device_.device(), &pool_info, nullptr, &descriptor_pool_) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor pool.");
+    }
+}
+
+LveDescriptorPool::~LveDescriptorPool()
+{
+    vkDestroyDescriptorPool(device_.device(), descriptor_pool_, nullptr);
+}
+
+bool LveDescriptorPool::allocate_descriptor(
+    VkDescriptorSetLayout descriptor_set_layout,
+    VkDescriptorSet& descriptor) const
+{
+    VkDescriptorSetAllocateInfo alloc_info{
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = descriptor_pool_,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &descriptor_set_layout};
+    return vkAllocateDescriptorSets(
+               device_.device(), &alloc_info, &descriptor) == VK_SUCCESS;
+}
+
+void LveDescriptorPool::free_descriptors(
+    std::pmr::vector<VkDescriptorSet>& descriptors) const
+{
+    vkFreeDescriptorSets(device_.device(),
+                         descriptor_pool_,
+                         static_cast<uint32_t>(descriptors.size()),
+                         descriptors.data());
+}
+
+void LveDescriptorPool::reset_pool()
+{
+    vkResetDescriptorPool(device_.device(), descriptor_pool_, 0);
+}
+
+LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout& set_layout)
+    : set_layout_{set_layout}
+{
+}
+
+LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout& set_layout,
+                                         LveDescriptorPool& pool)
+    : set_layout_{set_layout}, pool_{&pool}
+{
+}
+
+LveDescriptorWriter& LveDescriptorWriter::write_buffer(
+    uint32_t binding,
+    const VkDescriptorBufferInfo* buffer_info,
+    uint32_t array_element)
+{
+    assert(set_layout_.bindings_.count(binding) == 1 &&
+           "Layout does not contain specified binding");
+    const auto& description = set_layout_.bindings_[binding];
+    assert(array_element < description.descriptorCount &&
+           "Array element out of binding range");
+    writes_.push_back(VkWriteDescriptorSet{
+        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding      = binding,
+        .dstArrayElement = array_element,
+        .descriptorCount = 1,
+        .descriptorType  = description.descriptorType,
+        .pBufferInfo     = buffer_info});
+    return *this;
+}
+
+LveDescriptorWriter& LveDescriptorWriter::write_image(
+    uint32_t binding,
+    const VkDescriptorImageInfo* image_info,
+    uint32_t array_element)
+{
+    assert(set_layout_.bindings_.count(binding) == 1 &&
+           "Layout does not contain specified binding");
+    const auto& description = set_layout_.bindings_[binding];
+    assert(array_element < description.descriptorCount &&
+           "Array element out of binding range");
+    writes_.push_back(VkWriteDescriptorSet{
+        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding      = binding,
+        .dstArrayElement = array_element,
+        .descriptorCount = 1,
+        .descriptorType  = description.descriptorType,
+        .pImageInfo      = image_info});
+    return *this;
+}
+
+bool LveDescriptorWriter::build(VkDescriptorSet& set)
+{
+    assert(pool_ && "Writer has no pool to allocate from");
+    if (!pool_->allocate_descriptor(set_layout_.get_descriptor_set_layout(),
+                                    set))
+    {
+        return false;
+    }
+    overwrite(set);
+    return true;
+}
+
+VkDescriptorSet LveDescriptorWriter::build(LveDescriptorAllocator& allocator)
+{
+    auto set = allocator.allocate(set_layout_.get_descriptor_set_layout());
+    overwrite(set);
+    return set;
+}
+
+void LveDescriptorWriter::overwrite(VkDescriptorSet& set)
+{
+    for (auto& write : writes_)
+    {
+        write.dstSet = set;
+    }
+    vkUpdateDescriptorSets(set_layout_.device_.device(),
+                           static_cast<uint32_t>(writes_.size()),
+                           writes_.data(),
+                           0,
+                           nullptr);
+}
+} // namespace lve
@@ -1,5 +1,6 @@
 #include <tutorial/device.hpp>
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -59,10 +60,16 @@ LveDevice::LveDevice(LveWindow& window) : window{window}
     pickPhysicalDevice();
     createLogicalDevice();
     createCommandPool();
+    graphicsTimeline_ = std::make_unique<LveTimeline>(device_);
+    transferTimeline_ = std::make_unique<LveTimeline>(device_);
 }
 
 LveDevice::~LveDevice()
 {
+    // objects released after the last frame, the device is idle by now
+    deletionQueue_.flush();
+    graphicsTimeline_.reset();
+    transferTimeline_.reset();
     vkDestroyCommandPool(device_, commandPool, nullptr);
     vkDestroyDevice(device_, nullptr);
 
@@ -89,7 +96,23 @@ void LveDevice::createInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName        = "No Engine";
     appInfo.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion         = VK_API_VERSION_1_0;
+    appInfo.apiVersion         = VK_API_VERSION_1_2;
+
+    // a 1.0 loader lacks vkEnumerateInstanceVersion and rejects any other
+    // apiVersion, devices are only used through a 1.2 instance
+    uint32_t instanceVersion = VK_API_VERSION_1_0;
+    auto enumerateInstanceVersion =
+        reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+            vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+    if (enumerateInstanceVersion)
+    {
+        enumerateInstanceVersion(&instanceVersion);
+    }
+    if (instanceVersion < VK_API_VERSION_1_2)
+    {
+        throw std::runtime_error(
+            "Vulkan 1.2 required, but the instance does not support it!");
+    }
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType                = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -151,6 +174,168 @@ void LveDevice::pickPhysicalDevice()
 
     vkGetPhysicalDeviceProperties(physicalDevice, &properties);
     std::cout << "physical device: " << properties.deviceName << std::endl;
+    queryFeatureSupport();
+}
+
+void LveDevice::queryFeatureSupport()
+{
+    VkPhysicalDeviceFeatures coreFeatures{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &coreFeatures);
+    featureSupport_.textureCompressionBC = coreFeatures.textureCompressionBC;
+
+    // feature structs chained below are core in Vulkan 1.2, descriptor
+    // indexing among them
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexing{};
+    descriptorIndexing.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    // extension feature structs may only be chained when the extension is
+    // there
+    VkPhysicalDevicePresentIdFeaturesKHR presentId{};
+    presentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWait{};
+    presentWait.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    if (isDeviceExtensionAvailable(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        isDeviceExtensionAvailable(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+    {
+        descriptorIndexing.pNext = &presentId;
+        presentId.pNext          = &presentWait;
+    }
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering{};
+    dynamicRendering.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+    if (isDeviceExtensionAvailable(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+    {
+        dynamicRendering.pNext   = descriptorIndexing.pNext;
+        descriptorIndexing.pNext = &dynamicRendering;
+    }
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState{};
+    extendedDynamicState.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    if (isDeviceExtensionAvailable(
+            VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+    {
+        extendedDynamicState.pNext = descriptorIndexing.pNext;
+        descriptorIndexing.pNext   = &extendedDynamicState;
+    }
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2{};
+    extendedDynamicState2.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+    if (isDeviceExtensionAvailable(
+            VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME))
+    {
+        extendedDynamicState2.pNext = descriptorIndexing.pNext;
+        descriptorIndexing.pNext    = &extendedDynamicState2;
+    }
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibrary{};
+    pipelineLibrary.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT
+        pipelineLibraryProperties{};
+    pipelineLibraryProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+    const bool pipelineLibraryAvailable =
+        isDeviceExtensionAvailable(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+        isDeviceExtensionAvailable(
+            VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    VkPhysicalDeviceDescriptorIndexingProperties
+        descriptorIndexingProperties{};
+    descriptorIndexingProperties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    if (pipelineLibraryAvailable)
+    {
+        pipelineLibrary.pNext              = descriptorIndexing.pNext;
+        descriptorIndexing.pNext           = &pipelineLibrary;
+        descriptorIndexingProperties.pNext = &pipelineLibraryProperties;
+    }
+
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &descriptorIndexingProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &descriptorIndexing;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    featureSupport_.descriptorIndexing =
+        descriptorIndexing.runtimeDescriptorArray &&
+        descriptorIndexing.descriptorBindingPartiallyBound &&
+        descriptorIndexing.descriptorBindingUpdateUnusedWhilePending &&
+        descriptorIndexing.descriptorBindingStorageBufferUpdateAfterBind &&
+        descriptorIndexing.descriptorBindingSampledImageUpdateAfterBind &&
+        descriptorIndexing.shaderStorageBufferArrayNonUniformIndexing &&
+        descriptorIndexing.shaderSampledImageArrayNonUniformIndexing;
+    if (featureSupport_.descriptorIndexing)
+    {
+        const auto& limits = descriptorIndexingProperties;
+        featureSupport_.maxUpdateAfterBindStorageBuffers = std::min(
+            limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            limits.maxDescriptorSetUpdateAfterBindStorageBuffers);
+        // a combined image sampler counts as an image and as a sampler
+        featureSupport_.maxUpdateAfterBindSampledImages = std::min(
+            {limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+             limits.maxDescriptorSetUpdateAfterBindSampledImages,
+             limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+             limits.maxDescriptorSetUpdateAfterBindSamplers});
+        featureSupport_.maxUpdateAfterBindResources =
+            limits.maxPerStageUpdateAfterBindResources;
+    }
+    std::cout << "descriptor indexing: "
+              << (featureSupport_.descriptorIndexing ? "yes" : "no")
+              << std::endl;
+
+    featureSupport_.presentWait =
+        presentId.presentId && presentWait.presentWait;
+    std::cout << "present wait: "
+              << (featureSupport_.presentWait ? "yes" : "no") << std::endl;
+
+    featureSupport_.dynamicRendering = dynamicRendering.dynamicRendering;
+    std::cout << "dynamic rendering: "
+              << (featureSupport_.dynamicRendering ? "yes" : "no")
+              << std::endl;
+
+    featureSupport_.extendedDynamicState =
+        extendedDynamicState.extendedDynamicState;
+    featureSupport_.extendedDynamicState2 =
+        extendedDynamicState2.extendedDynamicState2;
+    std::cout << "extended dynamic state: "
+              << (featureSupport_.extendedDynamicState2  ? "2"
+                  : featureSupport_.extendedDynamicState ? "1"
+                                                         : "no")
+              << std::endl;
+
+    // without fast linking a linked pipeline takes as long as a monolithic
+    // one, the libraries would only add work
+    featureSupport_.graphicsPipelineLibrary =
+        pipelineLibrary.graphicsPipelineLibrary &&
+        pipelineLibraryProperties.graphicsPipelineLibraryFastLinking;
+    std::cout << "graphics pipeline library: "
+              << (featureSupport_.graphicsPipelineLibrary ? "yes" : "no")
+              << std::endl;
+}
+
+bool LveDevice::isDeviceExtensionAvailable(const char* extensionName)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(
+        physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        physicalDevice, nullptr, &extensionCount, extensions.data());
+    return std::any_of(extensions.begin(),
+                       extensions.end(),
+                       [&](const VkExtensionProperties& extension) {
+                           return std::strcmp(extension.extensionName,
+                                              extensionName) == 0;
+                       });
 }
 
 void LveDevice::createLogicalDevice()
@@ -158,8 +343,8 @@ void LveDevice::createLogicalDevice()
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily,
-                                              indices.presentFamily};
+    std::set<uint32_t> uniqueQueueFamilies = {
+        indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -175,8 +360,97 @@ void LveDevice::createLogicalDevice()
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy        = VK_TRUE;
 
+    deviceFeatures.textureCompressionBC = featureSupport_.textureCompressionBC;
+
+    // required, isDeviceSuitable() checked for it
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore{};
+    timelineSemaphore.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineSemaphore.timelineSemaphore = VK_TRUE;
+
+    // optional features are chained in only when supported
+    void* featureChain = &timelineSemaphore;
+
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexing{};
+    if (featureSupport_.descriptorIndexing)
+    {
+        descriptorIndexing.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        descriptorIndexing.pNext                  = featureChain;
+        descriptorIndexing.runtimeDescriptorArray = VK_TRUE;
+        descriptorIndexing.descriptorBindingPartiallyBound = VK_TRUE;
+        descriptorIndexing.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        descriptorIndexing.descriptorBindingStorageBufferUpdateAfterBind =
+            VK_TRUE;
+        descriptorIndexing.descriptorBindingSampledImageUpdateAfterBind =
+            VK_TRUE;
+        descriptorIndexing.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        descriptorIndexing.shaderSampledImageArrayNonUniformIndexing  = VK_TRUE;
+        featureChain = &descriptorIndexing;
+    }
+
+    std::vector<const char*> extensions = deviceExtensions;
+    VkPhysicalDevicePresentIdFeaturesKHR presentId{};
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWait{};
+    if (featureSupport_.presentWait)
+    {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        presentId.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentId.pNext     = featureChain;
+        presentId.presentId = VK_TRUE;
+        presentWait.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        presentWait.pNext       = &presentId;
+        presentWait.presentWait = VK_TRUE;
+        featureChain            = &presentWait;
+    }
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering{};
+    if (featureSupport_.dynamicRendering)
+    {
+        extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        dynamicRendering.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        dynamicRendering.pNext            = featureChain;
+        dynamicRendering.dynamicRendering = VK_TRUE;
+        featureChain                      = &dynamicRendering;
+    }
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState{};
+    extendedDynamicState.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    if (featureSupport_.extendedDynamicState)
+    {
+        extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        extendedDynamicState.pNext                = featureChain;
+        extendedDynamicState.extendedDynamicState = VK_TRUE;
+        featureChain                              = &extendedDynamicState;
+    }
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2{};
+    extendedDynamicState2.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+    if (featureSupport_.extendedDynamicState2)
+    {
+        extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+        extendedDynamicState2.pNext                 = featureChain;
+        extendedDynamicState2.extendedDynamicState2 = VK_TRUE;
+        featureChain                                = &extendedDynamicState2;
+    }
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibrary{};
+    pipelineLibrary.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    if (featureSupport_.graphicsPipelineLibrary)
+    {
+        extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        pipelineLibrary.pNext                   = featureChain;
+        pipelineLibrary.graphicsPipelineLibrary = VK_TRUE;
+        featureChain                            = &pipelineLibrary;
+    }
+
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType              = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext              = featureChain;
 
     createInfo.queueCreateInfoCount =
         static_cast<uint32_t>(queueCreateInfos.size());
@@ -184,8 +458,8 @@ void LveDevice::createLogicalDevice()
 
     createInfo.pEnabledFeatures = &deviceFeatures;
     createInfo.enabledExtensionCount =
-        static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     // might not really be necessary anymore because device specific validation
     // layers have been deprecated
@@ -208,6 +482,7 @@ void LveDevice::createLogicalDevice()
 
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+    vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
 }
 
 void LveDevice::createCommandPool()
@@ -250,8 +525,24 @@ bool LveDevice::isDeviceSuitable(VkPhysicalDevice device)
     VkPhysicalDeviceFeatures supportedFeatures;
     vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
+    // frames are synchronised with timeline semaphores, core in Vulkan 1.2
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(device, &deviceProperties);
+    bool timelineSemaphore = false;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+        timelineFeatures.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &timelineFeatures;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+        timelineSemaphore = timelineFeatures.timelineSemaphore;
+    }
+
     return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-           supportedFeatures.samplerAnisotropy;
+           supportedFeatures.samplerAnisotropy && timelineSemaphore;
 }
 
 void LveDevice::populateDebugMessengerCreateInfo(
@@ -415,6 +706,21 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device)
         i++;
     }
 
+    // a dedicated transfer family usually maps to the copy engines, uploads
+    // there run alongside rendering
+    indices.transferFamily = indices.graphicsFamily;
+    for (uint32_t family = 0; family < queueFamilyCount; ++family)
+    {
+        const auto flags = queueFamilies[family].queueFlags;
+        if (queueFamilies[family].queueCount > 0 &&
+            (flags & VK_QUEUE_TRANSFER_BIT) &&
+            !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+        {
+            indices.transferFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -472,6 +778,14 @@ VkFormat LveDevice::findSupportedFormat(const std::vector<VkFormat>& candidates,
     throw std::runtime_error("failed to find supported format!");
 }
 
+bool LveDevice::hasFormatFeatures(VkFormat format,
+                                  VkFormatFeatureFlags features)
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+    return (props.optimalTilingFeatures & features) == features;
+}
+
 uint32_t LveDevice::findMemoryType(uint32_t typeFilter,
                                    VkMemoryPropertyFlags properties)
 {
@@ -490,6 +804,22 @@ uint32_t LveDevice::findMemoryType(uint32_t typeFilter,
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
+uint32_t LveDevice::findMemoryTypes(VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    uint32_t typeBits = 0;
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if ((memProperties.memoryTypes[i].propertyFlags & properties) ==
+            properties)
+        {
+            typeBits |= 1u << i;
+        }
+    }
+    return typeBits;
+}
+
 void LveDevice::createBuffer(VkDeviceSize size,
                              VkBufferUsageFlags usage,
                              VkMemoryPropertyFlags properties,
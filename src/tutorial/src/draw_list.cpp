@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tutorial/draw_list.hpp>
+
+namespace lve
+{
+static_assert(DrawList::DEPTH_BITS + DrawList::MODEL_BITS +
+                      DrawList::PIPELINE_BITS ==
+                  64,
+              "Draw key fields must fill 64 bits");
+
+uint64_t DrawList::make_key(uint32_t pipeline_id,
+                            uint32_t model_id,
+                            float depth)
+{
+    constexpr uint32_t depth_max = (1u << DEPTH_BITS) - 1;
+    const auto depth_bucket      = static_cast<uint64_t>(
+        std::lround(std::clamp(depth, 0.f, 1.f) * depth_max));
+    const auto pipeline =
+        uint64_t{pipeline_id} & ((uint64_t{1} << PIPELINE_BITS) - 1);
+    const auto model = uint64_t{model_id} & ((uint64_t{1} << MODEL_BITS) - 1);
+    return pipeline << (MODEL_BITS + DEPTH_BITS) | model << DEPTH_BITS |
+           depth_bucket;
+}
+
+void DrawList::sort()
+{
+    constexpr uint32_t radix_bits = 8;
+    constexpr uint32_t radix_size = 1u << radix_bits;
+    constexpr uint32_t pass_count = 64 / radix_bits;
+
+    scratch_.resize(items_.size());
+    for (uint32_t pass = 0; pass < pass_count; ++pass)
+    {
+        const uint32_t shift = pass * radix_bits;
+        std::array<uint32_t, radix_size> offsets{};
+        for (const auto& item : items_)
+        {
+            ++offsets[(item.key >> shift) & (radix_size - 1)];
+        }
+        // every key has the same digit, this pass would not move anything
+        if (std::find(offsets.begin(), offsets.end(), items_.size()) !=
+            offsets.end())
+        {
+            continue;
+        }
+
+        uint32_t sum = 0;
+        for (auto& offset : offsets)
+        {
+            const auto count = offset;
+            offset           = sum;
+            sum += count;
+        }
+        for (const auto& item : items_)
+        {
+            scratch_[offsets[(item.key >> shift) & (radix_size - 1)]++] = item;
+        }
+        items_.swap(scratch_);
+    }
+}
+
+uint32_t DrawList::count_state_changes() const
+{
+    constexpr uint64_t model_mask = (uint64_t{1} << MODEL_BITS) - 1;
+    uint32_t changes              = 0;
+    for (size_t i = 1; i < items_.size(); ++i)
+    {
+        const auto changed = items_[i].key ^ items_[i - 1].key;
+        changes += (changed >> (MODEL_BITS + DEPTH_BITS)) != 0;
+        changes += ((changed >> DEPTH_BITS) & model_mask) != 0;
+    }
+    return changes;
+}
+} // namespace lve
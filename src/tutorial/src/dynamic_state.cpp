@@ -0,0 +1,121 @@
+#include <cassert>
+#include <tutorial/dynamic_state.hpp>
+
+namespace lve
+{
+namespace
+{
+template <typename Function>
+Function load(VkDevice device, const char* name)
+{
+    return reinterpret_cast<Function>(vkGetDeviceProcAddr(device, name));
+}
+
+// a dynamic topology has to be of the class the pipeline was created with
+VkPrimitiveTopology topology_class(VkPrimitiveTopology topology)
+{
+    switch (topology)
+    {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+        return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+        return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+        return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+    default:
+        return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    }
+}
+} // namespace
+
+uint32_t PipelineRasterState::pack() const
+{
+    assert(topology < 16 && cull_mode < 4 && depth_compare_op < 8 &&
+           "Raster state doesn't fit its packed bits");
+    return static_cast<uint32_t>(topology) |
+           static_cast<uint32_t>(primitive_restart) << 4 |
+           static_cast<uint32_t>(cull_mode) << 5 |
+           static_cast<uint32_t>(front_face) << 7 |
+           static_cast<uint32_t>(depth_test) << 8 |
+           static_cast<uint32_t>(depth_write) << 9 |
+           static_cast<uint32_t>(depth_compare_op) << 10;
+}
+
+PipelineRasterState PipelineRasterState::unpack(uint32_t packed)
+{
+    PipelineRasterState state;
+    state.topology          = static_cast<VkPrimitiveTopology>(packed & 15);
+    state.primitive_restart = (packed >> 4 & 1) != 0;
+    state.cull_mode         = packed >> 5 & 3;
+    state.front_face        = static_cast<VkFrontFace>(packed >> 7 & 1);
+    state.depth_test        = (packed >> 8 & 1) != 0;
+    state.depth_write       = (packed >> 9 & 1) != 0;
+    state.depth_compare_op  = static_cast<VkCompareOp>(packed >> 10 & 7);
+    return state;
+}
+
+LveDynamicState::LveDynamicState(LveDevice& device)
+{
+    const auto& features = device.featureSupport();
+    if (features.extendedDynamicState)
+    {
+        const auto vk_device = device.device();
+
+        set_primitive_topology_ = load<PFN_vkCmdSetPrimitiveTopologyEXT>(
+            vk_device, "vkCmdSetPrimitiveTopologyEXT");
+        set_cull_mode_          = load<PFN_vkCmdSetCullModeEXT>(
+            vk_device, "vkCmdSetCullModeEXT");
+        set_front_face_         = load<PFN_vkCmdSetFrontFaceEXT>(
+            vk_device, "vkCmdSetFrontFaceEXT");
+        set_depth_test_         = load<PFN_vkCmdSetDepthTestEnableEXT>(
+            vk_device, "vkCmdSetDepthTestEnableEXT");
+        set_depth_write_        = load<PFN_vkCmdSetDepthWriteEnableEXT>(
+            vk_device, "vkCmdSetDepthWriteEnableEXT");
+        set_depth_compare_op_   = load<PFN_vkCmdSetDepthCompareOpEXT>(
+            vk_device, "vkCmdSetDepthCompareOpEXT");
+    }
+    if (features.extendedDynamicState && features.extendedDynamicState2)
+    {
+        set_primitive_restart_ = load<PFN_vkCmdSetPrimitiveRestartEnableEXT>(
+            device.device(), "vkCmdSetPrimitiveRestartEnableEXT");
+    }
+}
+
+PipelineRasterState LveDynamicState::baked(
+    const PipelineRasterState& state) const
+{
+    if (!is_supported())
+    {
+        return state;
+    }
+    PipelineRasterState baked{};
+    baked.topology = topology_class(state.topology);
+    if (!set_primitive_restart_)
+    {
+        baked.primitive_restart = state.primitive_restart;
+    }
+    return baked;
+}
+
+void LveDynamicState::set(VkCommandBuffer command_buffer,
+                          const PipelineRasterState& state) const
+{
+    if (!is_supported())
+    {
+        return;
+    }
+    set_primitive_topology_(command_buffer, state.topology);
+    if (set_primitive_restart_)
+    {
+        set_primitive_restart_(command_buffer, state.primitive_restart);
+    }
+    set_cull_mode_(command_buffer, state.cull_mode);
+    set_front_face_(command_buffer, state.front_face);
+    set_depth_test_(command_buffer, state.depth_test);
+    set_depth_write_(command_buffer, state.depth_write);
+    set_depth_compare_op_(command_buffer, state.depth_compare_op);
+}
+} // namespace lve
@@ -1,15 +1,49 @@
 #pragma once
 
+#include <array>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <tutorial/bindless.hpp>
+#include <tutorial/bounds.hpp>
+#include <tutorial/bvh.hpp>
+#include <tutorial/camera.hpp>
+#include <tutorial/descriptors.hpp>
 #include <tutorial/device.hpp>
+#include <tutorial/frame_stats.hpp>
 #include <tutorial/game_object.hpp>
+#include <tutorial/job_system.hpp>
 #include <tutorial/model.hpp>
+#include <tutorial/occlusion_culler.hpp>
+#include <tutorial/pipeline_layout_cache.hpp>
+#include <tutorial/pipeline_library_cache.hpp>
+#include <tutorial/render_graph.hpp>
 #include <tutorial/renderer.hpp>
+#include <tutorial/resolution_scaler.hpp>
+#include <tutorial/texture_streamer.hpp>
 #include <tutorial/window.hpp>
 #include <vector>
 
 namespace lve
 {
+struct AppOptions
+{
+    SwapChainConfig swap_chain{};
+    ResolutionScalerConfig resolution{};
+    // steps the window through a fixed sequence of sizes, reports the
+    // longest frame and quits
+    bool resize_test = false;
+    // threads recording the scene's draws, every job system thread when
+    // empty. With more than one count the app moves to the next after each
+    // stats report and compares their record times once all were measured.
+    std::pmr::vector<uint32_t> record_threads;
+    // a grid of this many cubes replaces the scene, when not 0
+    uint32_t objects = 0;
+    // KTX2 texture every object streams in and, with bindless descriptors,
+    // samples. None when empty.
+    std::filesystem::path texture;
+};
+
 class FirstApp
 {
   public:
@@ -17,15 +51,102 @@ class FirstApp
     static constexpr int HEIGHT = 600;
     void run();
 
-    FirstApp();
+    explicit FirstApp(AppOptions options = {});
 
   private:
-    void load_game_objects();
+    void load_game_objects(uint32_t object_count);
+    // Throws std::runtime_error when the file is not a supported texture
+    void load_texture(const std::filesystem::path& texture_path);
+    void update_game_objects();
+    void cull_game_objects(const LveCamera& camera, FrameStats& stats);
+    void occlude_game_objects(const LveCamera& camera, FrameStats& stats);
+    void stream_textures(const LveCamera& camera, FrameStats& stats);
+    void report_stats(const FrameStats& stats);
+    // Moves to the next recording thread count once the current one's
+    // record time is reported
+    void step_record_threads(double record_ms);
+    void report_depth_memory();
+    // Blits the top left source_extent of source over the whole of
+    // destination, both in their transfer layouts, 1:1 when the extents
+    // match
+    static void record_upscale(VkCommandBuffer command_buffer,
+                               VkImage source,
+                               VkExtent2D source_extent,
+                               VkImage destination,
+                               VkExtent2D destination_extent);
+    void step_resize_test(float frame_time);
+
+    // smallest number of objects worth a job system range while updating
+    static constexpr size_t MIN_OBJECTS_PER_UPDATE_RANGE = 1024;
+    // nearest visible occluders rasterized into the occlusion buffer
+    static constexpr size_t MAX_OCCLUDERS = 16;
+    // smallest number of boxes worth a job system range while testing them
+    static constexpr size_t MIN_OBJECTS_PER_OCCLUSION_RANGE = 256;
+
+    // frames accumulated before stats are printed
+    static constexpr uint32_t STATS_REPORT_INTERVAL = 240;
+
+    // size of the cube the grid of AppOptions::objects fills
+    static constexpr float OBJECT_GRID_EXTENT = 1.5f;
+
+    // window sizes of the resize test, each shown for a few frames and the
+    // whole sequence repeated
+    static constexpr std::array<VkExtent2D, 8> RESIZE_TEST_SIZES{{
+        {1024, 768},
+        {640, 480},
+        {1280, 720},
+        {400, 300},
+        {1600, 900},
+        {800, 800},
+        {1200, 500},
+        {WIDTH, HEIGHT},
+    }};
+    static constexpr uint32_t RESIZE_TEST_FRAMES_PER_SIZE = 4;
+    static constexpr uint32_t RESIZE_TEST_ROUNDS          = 8;
 
     LveWindow window_{WIDTH, HEIGHT, "Hello Vulkan!"};
     LveDevice device_{window_};
-    LveRenderer renderer_{window_, device_};
+    JobSystem job_system_{};
+    LveRenderer renderer_;
+    // declared anew every frame, keeps its transient images between frames
+    LveRenderGraph render_graph_{device_};
+    // the scene is rendered at its scale of the swap chain extent, then
+    // blitted to the swap chain image when that is smaller
+    LveResolutionScaler resolution_scaler_;
+    LveDescriptorLayoutCache layout_cache_{device_};
+    LvePipelineLayoutCache pipeline_layout_cache_{device_, layout_cache_};
+    // runs the optimised links, destroying it drops those still queued
+    LvePipelineLibraryCache pipeline_library_cache_{device_};
+    std::unique_ptr<LveDescriptorPool> global_pool_{};
+    // only when the device supports descriptor indexing
+    std::unique_ptr<LveBindlessTable> bindless_table_{};
+    // registers its images in bindless_table_, so it is destroyed first
+    std::unique_ptr<LveTextureStreamer> texture_streamer_{};
     std::pmr::vector<LveGameObject> game_objects_;
+
+    // world space boxes indexed like game_objects_, kept in scene_bvh_
+    std::pmr::vector<BoundingBox> object_bounds_;
+    Bvh scene_bvh_{&job_system_};
+    std::pmr::vector<uint32_t> visible_objects_;
+    OcclusionCuller occlusion_culler_{job_system_};
+
+    FrameStats accumulated_stats_{};
+    uint32_t accumulated_frames_ = 0;
+
+    // AppOptions::record_threads and the record time of each, in the order
+    // they are measured
+    std::pmr::vector<uint32_t> record_threads_;
+    std::pmr::vector<double> record_ms_;
+    size_t record_thread_index_ = 0;
+
+    struct ResizeTest
+    {
+        uint32_t frames       = 0;
+        double total_frame_ms = 0.0;
+        double max_frame_ms   = 0.0;
+    };
+    // only with AppOptions::resize_test
+    std::optional<ResizeTest> resize_test_;
 };
 } // namespace lve
 
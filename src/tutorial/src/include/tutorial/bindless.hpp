@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <tutorial/descriptors.hpp>
+#include <tutorial/device.hpp>
+#include <vector>
+
+namespace lve
+{
+// One update-after-bind descriptor set holding large arrays of storage
+// buffers and sampled images. Resources are registered once and addressed by
+// their array index from shaders, so draws need no per object sets. Requires
+// DeviceFeatureSupport::descriptorIndexing.
+class LveBindlessTable
+{
+  public:
+    static constexpr uint32_t BUFFER_BINDING = 0;
+    static constexpr uint32_t IMAGE_BINDING  = 1;
+    // array sizes, lowered to the device's update-after-bind limits
+    static constexpr uint32_t MAX_BUFFERS = 1024;
+    static constexpr uint32_t MAX_IMAGES  = 16384;
+
+    // Throws std::runtime_error when the limits leave no room for the arrays
+    LveBindlessTable(LveDevice& device, LveDescriptorLayoutCache& layout_cache);
+
+    LveBindlessTable(const LveBindlessTable&) = delete;
+    LveBindlessTable& operator=(const LveBindlessTable&) = delete;
+
+    // Return the array index the resource is visible at. Safe to call from
+    // several threads and while the set is bound in pending command buffers,
+    // as long as those do not read the slot being written.
+    uint32_t add_buffer(const VkDescriptorBufferInfo& buffer_info);
+    uint32_t add_image(const VkDescriptorImageInfo& image_info);
+    // The slot is reused by later adds, the caller makes sure the GPU no
+    // longer reads it
+    void remove_buffer(uint32_t index);
+    void remove_image(uint32_t index);
+
+    const LveDescriptorSetLayout& get_layout() const
+    {
+        return *layout_;
+    }
+
+    VkDescriptorSet get_descriptor_set() const
+    {
+        return descriptor_set_;
+    }
+
+    uint32_t get_buffer_capacity() const
+    {
+        return buffer_slots_.capacity;
+    }
+    uint32_t get_image_capacity() const
+    {
+        return image_slots_.capacity;
+    }
+
+  private:
+    struct Slots
+    {
+        uint32_t capacity;
+        uint32_t next = 0;
+        std::pmr::vector<uint32_t> free{};
+    };
+
+    static uint32_t acquire_slot(Slots& slots);
+    static void release_slot(Slots& slots, uint32_t index);
+
+    std::unique_ptr<LveDescriptorSetLayout> layout_;
+    std::unique_ptr<LveDescriptorPool> pool_;
+    VkDescriptorSet descriptor_set_ = VK_NULL_HANDLE;
+
+    std::mutex mutex_;
+    Slots buffer_slots_{};
+    Slots image_slots_{};
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveBindlessTable>);
+static_assert(!std::is_copy_assignable_v<lve::LveBindlessTable>);
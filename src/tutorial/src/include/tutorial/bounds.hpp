@@ -0,0 +1,90 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <array>
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace lve
+{
+struct BoundingBox
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    bool is_empty() const
+    {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 extent() const
+    {
+        return max - min;
+    }
+
+    float surface_area() const
+    {
+        if (is_empty())
+        {
+            return 0.f;
+        }
+        const auto e = extent();
+        return 2.f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    void expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const BoundingBox& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    bool operator==(const BoundingBox& other) const
+    {
+        return min == other.min && max == other.max;
+    }
+
+    // Box enclosing this one after an affine transform
+    BoundingBox transformed(const glm::mat4& transform) const;
+};
+
+struct Ray
+{
+    glm::vec3 origin{};
+    glm::vec3 direction{0.f, 0.f, 1.f};
+
+    // Parametric distance at which the ray enters the box, negative on miss
+    float intersect(const BoundingBox& box, float max_distance) const;
+};
+
+class Frustum
+{
+  public:
+    enum class Containment
+    {
+        outside,
+        intersecting,
+        inside
+    };
+
+    // Planes are taken from a projection * view matrix with a [0, 1] depth
+    // range, pointing inwards
+    static Frustum from_matrix(const glm::mat4& projection_view);
+
+    Containment test(const BoundingBox& box) const;
+
+  private:
+    std::array<glm::vec4, 6> planes_{};
+};
+} // namespace lve
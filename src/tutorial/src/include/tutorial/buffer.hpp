@@ -0,0 +1,87 @@
+#pragma once
+
+#include <tutorial/device.hpp>
+
+namespace lve
+{
+// Buffer of instance_count equally sized instances, each one starting at a
+// multiple of min_offset_alignment so it can be bound on its own
+class LveBuffer
+{
+  public:
+    LveBuffer(LveDevice& device,
+              VkDeviceSize instance_size,
+              uint32_t instance_count,
+              VkBufferUsageFlags usage_flags,
+              VkMemoryPropertyFlags memory_property_flags,
+              VkDeviceSize min_offset_alignment = 1);
+    ~LveBuffer();
+
+    LveBuffer(const LveBuffer&) = delete;
+    LveBuffer& operator=(const LveBuffer&) = delete;
+
+    VkResult map(VkDeviceSize size   = VK_WHOLE_SIZE,
+                 VkDeviceSize offset = 0);
+    void unmap();
+
+    void write_to_buffer(const void* data,
+                         VkDeviceSize size   = VK_WHOLE_SIZE,
+                         VkDeviceSize offset = 0);
+    VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+    VkDescriptorBufferInfo descriptor_info(VkDeviceSize size   = VK_WHOLE_SIZE,
+                                           VkDeviceSize offset = 0) const;
+
+    void write_to_index(const void* data, uint32_t index);
+    VkResult flush_index(uint32_t index);
+    VkDescriptorBufferInfo descriptor_info_for_index(uint32_t index) const;
+
+    VkBuffer get_buffer() const
+    {
+        return buffer_;
+    }
+
+    void* get_mapped_memory() const
+    {
+        return mapped_;
+    }
+
+    uint32_t get_instance_count() const
+    {
+        return instance_count_;
+    }
+
+    VkDeviceSize get_instance_size() const
+    {
+        return instance_size_;
+    }
+
+    VkDeviceSize get_alignment_size() const
+    {
+        return alignment_size_;
+    }
+
+    VkDeviceSize get_buffer_size() const
+    {
+        return buffer_size_;
+    }
+
+    static VkDeviceSize get_alignment(VkDeviceSize instance_size,
+                                      VkDeviceSize min_offset_alignment);
+
+  private:
+    LveDevice& device_;
+    void* mapped_          = nullptr;
+    VkBuffer buffer_       = VK_NULL_HANDLE;
+    VkDeviceMemory memory_ = VK_NULL_HANDLE;
+
+    VkDeviceSize buffer_size_;
+    uint32_t instance_count_;
+    VkDeviceSize instance_size_;
+    VkDeviceSize alignment_size_;
+    VkBufferUsageFlags usage_flags_;
+    VkMemoryPropertyFlags memory_property_flags_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveBuffer>);
+static_assert(!std::is_copy_assignable_v<lve::LveBuffer>);
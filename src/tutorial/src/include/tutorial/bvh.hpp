@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <tutorial/bounds.hpp>
+#include <tutorial/job_system.hpp>
+#include <vector>
+
+namespace lve
+{
+// Bounding volume hierarchy over object boxes. Built top-down with binned
+// SAH, refitted bottom-up when objects move and flagged for rebuild once
+// refitting has degraded its SAH cost too far from the freshly built tree.
+class Bvh
+{
+  public:
+    struct Node
+    {
+        BoundingBox bounds;
+        // interior nodes: index of the left child, right child follows it;
+        // leaves: first entry in the object index list
+        uint32_t first  = 0;
+        uint32_t count  = 0; // 0 for interior nodes
+        uint32_t parent = INVALID_INDEX;
+
+        bool is_leaf() const
+        {
+            return count != 0;
+        }
+    };
+
+    struct RayHit
+    {
+        uint32_t object = INVALID_INDEX;
+        float distance  = 0.f;
+    };
+
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    static constexpr uint32_t BIN_COUNT     = 16;
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;
+    // nodes with more objects than this bin their objects on the job system
+    static constexpr size_t PARALLEL_BINNING_THRESHOLD = 16 * 1024;
+    // refitted tree is rebuilt once its SAH cost grows past this factor
+    static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+    explicit Bvh(JobSystem* job_system = nullptr) : job_system_{job_system}
+    {
+    }
+
+    void build(const std::pmr::vector<BoundingBox>& object_bounds);
+
+    // Records a new box for an object, the tree is brought up to date by the
+    // next refit()
+    void update(uint32_t object, const BoundingBox& bounds);
+    void refit();
+
+    bool needs_rebuild() const
+    {
+        return cost_ > build_cost_ * REBUILD_COST_RATIO;
+    }
+
+    // Appends every object whose box is not outside the frustum, returns the
+    // number of visited nodes
+    uint32_t query(const Frustum& frustum,
+                   std::pmr::vector<uint32_t>& visible) const;
+
+    // Closest object whose box is hit by the ray
+    std::optional<RayHit> raycast(
+        const Ray& ray,
+        float max_distance = std::numeric_limits<float>::max()) const;
+
+    size_t object_count() const
+    {
+        return object_bounds_.size();
+    }
+
+    size_t node_count() const
+    {
+        return nodes_.size();
+    }
+
+    float cost() const
+    {
+        return cost_;
+    }
+
+  private:
+    struct Bin
+    {
+        BoundingBox bounds;
+        uint32_t count = 0;
+    };
+    using Bins = std::array<std::array<Bin, BIN_COUNT>, 3>;
+
+    struct Split
+    {
+        int axis     = -1;
+        uint32_t bin = 0;
+        float cost   = std::numeric_limits<float>::max();
+    };
+
+    void subdivide(uint32_t node_index);
+    BoundingBox centroid_bounds(uint32_t first, uint32_t count) const;
+    Bins bin_objects(uint32_t first,
+                     uint32_t count,
+                     const BoundingBox& centroids) const;
+    void collect(uint32_t node_index, std::pmr::vector<uint32_t>& out) const;
+    float compute_cost() const;
+
+    JobSystem* job_system_ = nullptr;
+    std::pmr::vector<Node> nodes_;
+    std::pmr::vector<uint32_t> object_indices_;
+    std::pmr::vector<uint32_t> object_leaves_;
+    std::pmr::vector<BoundingBox> object_bounds_;
+    std::pmr::vector<uint32_t> dirty_leaves_;
+    float build_cost_ = 0.f;
+    float cost_       = 0.f;
+};
+} // namespace lve
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+
+namespace lve
+{
+// Destroys Vulkan objects once the GPU is done with every frame that may
+// have used them, instead of waiting for the device to go idle. Each
+// deletion is keyed by the frame being recorded when it was pushed and runs
+// when that frame is reported complete.
+//
+// Deleters run on the thread calling collect() and may outlive the object
+// that pushed them, so they capture handles by value and nothing else.
+class LveDeletionQueue
+{
+  public:
+    LveDeletionQueue() = default;
+    // Runs what is left, the device must be idle by then
+    ~LveDeletionQueue();
+
+    LveDeletionQueue(const LveDeletionQueue&) = delete;
+    LveDeletionQueue& operator=(const LveDeletionQueue&) = delete;
+
+    // Safe to call from any thread
+    void push(std::function<void()> deleter);
+
+    // Deletions pushed from now on wait for frame as well
+    void begin_frame(uint64_t frame);
+    // Runs the deletions of frames up to completed_frame, which the GPU has
+    // finished along with all frames before it
+    void collect(uint64_t completed_frame);
+    // Runs every deletion, for when the device is idle
+    void flush();
+
+    size_t size() const;
+
+  private:
+    struct Deletion
+    {
+        uint64_t frame;
+        std::function<void()> deleter;
+    };
+
+    mutable std::mutex mutex_;
+    // in push order, so frames never decrease from front to back
+    std::deque<Deletion> deletions_;
+    uint64_t frame_ = 0;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveDeletionQueue>);
+static_assert(!std::is_copy_assignable_v<lve::LveDeletionQueue>);
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <tutorial/device.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+// Owns descriptor set layouts and hands out the same layout for equal
+// binding descriptions, so render systems can share sets and pipeline layouts
+// stay compatible without passing layouts around
+class LveDescriptorLayoutCache
+{
+  public:
+    explicit LveDescriptorLayoutCache(LveDevice& device) : device_{device}
+    {
+    }
+    ~LveDescriptorLayoutCache();
+
+    LveDescriptorLayoutCache(const LveDescriptorLayoutCache&) = delete;
+    LveDescriptorLayoutCache& operator=(const LveDescriptorLayoutCache&) =
+        delete;
+
+    // Binding flags, when given, are indexed like bindings
+    VkDescriptorSetLayout create_descriptor_layout(
+        const std::pmr::vector<VkDescriptorSetLayoutBinding>& bindings,
+        VkDescriptorSetLayoutCreateFlags flags = 0,
+        const std::pmr::vector<VkDescriptorBindingFlags>& binding_flags = {});
+
+    size_t size() const;
+
+  private:
+    struct LayoutBinding
+    {
+        VkDescriptorSetLayoutBinding binding;
+        VkDescriptorBindingFlags flags;
+    };
+
+    struct LayoutKey
+    {
+        // sorted by binding index
+        std::pmr::vector<LayoutBinding> bindings;
+        VkDescriptorSetLayoutCreateFlags flags;
+
+        bool operator==(const LayoutKey& other) const;
+    };
+
+    struct LayoutKeyHash
+    {
+        size_t operator()(const LayoutKey& key) const;
+    };
+
+    LveDevice& device_;
+    mutable std::mutex mutex_;
+    std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash>
+        layouts_;
+};
+
+// Allocates sets from a list of pools, adding a pool whenever the current
+// one runs out. reset_pools() recycles every pool at once, which suits sets
+// that live for a single frame.
+class LveDescriptorAllocator
+{
+  public:
+    static constexpr uint32_t DEFAULT_SETS_PER_POOL = 256;
+
+    explicit LveDescriptorAllocator(
+        LveDevice& device,
+        uint32_t sets_per_pool = DEFAULT_SETS_PER_POOL);
+    ~LveDescriptorAllocator();
+
+    LveDescriptorAllocator(const LveDescriptorAllocator&) = delete;
+    LveDescriptorAllocator& operator=(const LveDescriptorAllocator&) = delete;
+
+    // Safe to call from several threads
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    void reset_pools();
+
+    size_t pool_count() const;
+
+  private:
+    VkDescriptorPool grab_pool();
+
+    LveDevice& device_;
+    uint32_t sets_per_pool_;
+    mutable std::mutex mutex_;
+    VkDescriptorPool current_pool_ = VK_NULL_HANDLE;
+    std::pmr::vector<VkDescriptorPool> used_pools_;
+    std::pmr::vector<VkDescriptorPool> free_pools_;
+};
+
+class LveDescriptorSetLayout
+{
+  public:
+    class Builder
+    {
+      public:
+        explicit Builder(LveDevice& device) : device_{device}
+        {
+        }
+
+        Builder& add_binding(uint32_t binding,
+                             VkDescriptorType descriptor_type,
+                             VkShaderStageFlags stage_flags,
+                             uint32_t count                 = 1,
+                             VkDescriptorBindingFlags flags = 0);
+        Builder& set_layout_flags(VkDescriptorSetLayoutCreateFlags flags);
+        // Takes the layout from the cache instead of creating its own
+        Builder& set_cache(LveDescriptorLayoutCache& cache);
+        std::unique_ptr<LveDescriptorSetLayout> build() const;
+
+      private:
+        LveDevice& device_;
+        LveDescriptorLayoutCache* cache_ = nullptr;
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings_{};
+        std::unordered_map<uint32_t, VkDescriptorBindingFlags> binding_flags_{};
+        VkDescriptorSetLayoutCreateFlags layout_flags_ = 0;
+    };
+
+    LveDescriptorSetLayout(
+        LveDevice& device,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlags>&
+            binding_flags = {},
+        VkDescriptorSetLayoutCreateFlags flags = 0,
+        LveDescriptorLayoutCache* cache        = nullptr);
+    ~LveDescriptorSetLayout();
+
+    LveDescriptorSetLayout(const LveDescriptorSetLayout&) = delete;
+    LveDescriptorSetLayout& operator=(const LveDescriptorSetLayout&) = delete;
+
+    VkDescriptorSetLayout get_descriptor_set_layout() const
+    {
+        return descriptor_set_layout_;
+    }
+
+    // ordered by binding index
+    std::pmr::vector<VkDescriptorSetLayoutBinding> get_bindings() const;
+
+  private:
+    LveDevice& device_;
+    VkDescriptorSetLayout descriptor_set_layout_;
+    std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings_;
+    // cached layouts are destroyed by the cache
+    bool owns_layout_;
+
+    friend class LveDescriptorWriter;
+};
+
+class LveDescriptorPool
+{
+  public:
+    class Builder
+    {
+      public:
+        explicit Builder(LveDevice& device) : device_{device}
+        {
+        }
+
+        Builder& add_pool_size(VkDescriptorType descriptor_type,
+                               uint32_t count);
+        Builder& set_pool_flags(VkDescriptorPoolCreateFlags flags);
+        Builder& set_max_sets(uint32_t count);
+        std::unique_ptr<LveDescriptorPool> build() const;
+
+      private:
+        LveDevice& device_;
+        std::pmr::vector<VkDescriptorPoolSize> pool_sizes_{};
+        uint32_t max_sets_                      = 1000;
+        VkDescriptorPoolCreateFlags pool_flags_ = 0;
+    };
+
+    LveDescriptorPool(LveDevice& device,
+                      uint32_t max_sets,
+                      VkDescriptorPoolCreateFlags pool_flags,
+                      const std::pmr::vector<VkDescriptorPoolSize>& pool_sizes);
+    ~LveDescriptorPool();
+
+    LveDescriptorPool(const LveDescriptorPool&) = delete;
+    LveDescriptorPool& operator=(const LveDescriptorPool&) = delete;
+
+    bool allocate_descriptor(VkDescriptorSetLayout descriptor_set_layout,
+                             VkDescriptorSet& descriptor) const;
+    void free_descriptors(std::pmr::vector<VkDescriptorSet>& descriptors) const;
+    void reset_pool();
+
+  private:
+    LveDevice& device_;
+    VkDescriptorPool descriptor_pool_;
+
+    friend class LveDescriptorWriter;
+};
+
+// Collects writes for a set of the given layout, then allocates the set from
+// the pool and/or updates it in one vkUpdateDescriptorSets call
+class LveDescriptorWriter
+{
+  public:
+    explicit LveDescriptorWriter(LveDescriptorSetLayout& set_layout);
+    LveDescriptorWriter(LveDescriptorSetLayout& set_layout,
+                        LveDescriptorPool& pool);
+
+    // array_element selects the descriptor of an arrayed binding
+    LveDescriptorWriter& write_buffer(uint32_t binding,
+                                      const VkDescriptorBufferInfo* buffer_info,
+                                      uint32_t array_element = 0);
+    LveDescriptorWriter& write_image(uint32_t binding,
+                                     const VkDescriptorImageInfo* image_info,
+                                     uint32_t array_element = 0);
+
+    bool build(VkDescriptorSet& set);
+    // Allocates the set from a growable allocator instead of the pool
+    VkDescriptorSet build(LveDescriptorAllocator& allocator);
+    void overwrite(VkDescriptorSet& set);
+
+  private:
+    LveDescriptorSetLayout& set_layout_;
+    LveDescriptorPool* pool_ = nullptr;
+    std::pmr::vector<VkWriteDescriptorSet> writes_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveDescriptorLayoutCache>);
+static_assert(!std::is_copy_assignable_v<lve::LveDescriptorLayoutCache>);
+static_assert(!std::is_copy_constructible_v<lve::LveDescriptorAllocator>);
+static_assert(!std::is_copy_assignable_v<lve::LveDescriptorAllocator>);
+static_assert(!std::is_copy_constructible_v<lve::LveDescriptorSetLayout>);
+static_assert(!std::is_copy_assignable_v<lve::LveDescriptorSetLayout>);
+static_assert(!std::is_copy_constructible_v<lve::LveDescriptorPool>);
+static_assert(!std::is_copy_assignable_v<lve::LveDescriptorPool>);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <tutorial/deletion_queue.hpp>
+#include <tutorial/timeline.hpp>
 #include <tutorial/window.hpp>
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,6 +23,9 @@ struct QueueFamilyIndices
 {
     uint32_t graphicsFamily;
     uint32_t presentFamily;
+    // a transfer only family when the device has one, the graphics family
+    // otherwise
+    uint32_t transferFamily;
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue  = false;
     bool isComplete()
@@ -28,6 +34,37 @@ struct QueueFamilyIndices
     }
 };
 
+// Optional device features, enabled at device creation when the physical
+// device supports them
+struct DeviceFeatureSupport
+{
+    // update-after-bind, partially bound, runtime sized descriptor arrays
+    // with non-uniform indexing of sampled images and storage buffers
+    bool descriptorIndexing = false;
+    // update-after-bind descriptors a pipeline layout may hold per stage and
+    // per set, 0 without descriptorIndexing
+    uint32_t maxUpdateAfterBindStorageBuffers = 0;
+    uint32_t maxUpdateAfterBindSampledImages  = 0;
+    // of all types together, per stage
+    uint32_t maxUpdateAfterBindResources = 0;
+    // BC1 to BC7 block compressed formats
+    bool textureCompressionBC = false;
+    // VK_KHR_present_id and VK_KHR_present_wait, to tell when a presented
+    // image reached the screen
+    bool presentWait = false;
+    // VK_KHR_dynamic_rendering, to render without render pass and
+    // framebuffer objects
+    bool dynamicRendering = false;
+    // VK_EXT_extended_dynamic_state, to set cull mode, front face, topology
+    // and depth test per draw instead of baking them into pipelines
+    bool extendedDynamicState = false;
+    // VK_EXT_extended_dynamic_state2, primitive restart as well
+    bool extendedDynamicState2 = false;
+    // VK_EXT_graphics_pipeline_library with fast linking, to link pipelines
+    // from separately created parts without a first use hitch
+    bool graphicsPipelineLibrary = false;
+};
+
 class LveDevice
 {
   public:
@@ -66,6 +103,10 @@ class LveDevice
     {
         return presentQueue_;
     }
+    VkQueue transferQueue()
+    {
+        return transferQueue_;
+    }
 
     SwapChainSupportDetails getSwapChainSupport()
     {
@@ -73,6 +114,8 @@ class LveDevice
     }
     uint32_t findMemoryType(uint32_t typeFilter,
                             VkMemoryPropertyFlags properties);
+    // Bit mask of the memory types with all of properties, 0 when none has
+    uint32_t findMemoryTypes(VkMemoryPropertyFlags properties);
     QueueFamilyIndices findPhysicalQueueFamilies()
     {
         return findQueueFamilies(physicalDevice);
@@ -80,6 +123,8 @@ class LveDevice
     VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates,
                                  VkImageTiling tiling,
                                  VkFormatFeatureFlags features);
+    // Whether optimally tiled images of format have all of features
+    bool hasFormatFeatures(VkFormat format, VkFormatFeatureFlags features);
 
     // Buffer Helper Functions
     void createBuffer(VkDeviceSize size,
@@ -101,6 +146,29 @@ class LveDevice
                              VkImage& image,
                              VkDeviceMemory& imageMemory);
 
+    const DeviceFeatureSupport& featureSupport() const
+    {
+        return featureSupport_;
+    }
+
+    // Objects that frames in flight may still use are destroyed through
+    // here, the renderer reports which frames completed
+    LveDeletionQueue& deletionQueue()
+    {
+        return deletionQueue_;
+    }
+
+    // Signalled by the renderer with the number of each frame it submits
+    LveTimeline& graphicsTimeline()
+    {
+        return *graphicsTimeline_;
+    }
+    // Signalled by texture uploads on the transfer queue
+    LveTimeline& transferTimeline()
+    {
+        return *transferTimeline_;
+    }
+
     VkPhysicalDeviceProperties properties;
 
   private:
@@ -121,6 +189,8 @@ class LveDevice
     void hasGflwRequiredInstanceExtensions();
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+    void queryFeatureSupport();
+    bool isDeviceExtensionAvailable(const char* extensionName);
 
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
@@ -132,6 +202,11 @@ class LveDevice
     VkSurfaceKHR surface_;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
+    VkQueue transferQueue_;
+    DeviceFeatureSupport featureSupport_;
+    LveDeletionQueue deletionQueue_;
+    std::unique_ptr<LveTimeline> graphicsTimeline_;
+    std::unique_ptr<LveTimeline> transferTimeline_;
 
     const std::vector<const char*> validationLayers = {
         "VK_LAYER_KHRONOS_validation"};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+struct DrawItem
+{
+    uint64_t key;
+    uint32_t object;
+};
+
+// Draws ordered by a 64-bit key so that recording them in sequence changes
+// pipeline and vertex buffer state as rarely as possible. From the most
+// significant bits down the key holds the pipeline id, the model id and a
+// depth bucket, which orders draws sharing both front to back.
+class DrawList
+{
+  public:
+    static constexpr uint32_t DEPTH_BITS    = 16;
+    static constexpr uint32_t MODEL_BITS    = 24;
+    static constexpr uint32_t PIPELINE_BITS = 24;
+
+    // depth is expected in [0, 1], values outside are clamped
+    static uint64_t make_key(uint32_t pipeline_id,
+                             uint32_t model_id,
+                             float depth);
+
+    void clear()
+    {
+        items_.clear();
+    }
+
+    void resize(size_t count)
+    {
+        items_.resize(count);
+    }
+
+    DrawItem& operator[](size_t index)
+    {
+        return items_[index];
+    }
+
+    const std::pmr::vector<DrawItem>& items() const
+    {
+        return items_;
+    }
+
+    size_t size() const
+    {
+        return items_.size();
+    }
+
+    // LSD radix sort on the key, passes over bytes all keys share are skipped
+    void sort();
+
+    // Pipeline and model binds needed to record the draws in current order,
+    // not counting the ones the first draw needs
+    uint32_t count_state_changes() const;
+
+  private:
+    std::pmr::vector<DrawItem> items_;
+    std::pmr::vector<DrawItem> scratch_;
+};
+} // namespace lve
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <tutorial/device.hpp>
+#include <type_traits>
+
+namespace lve
+{
+// Rasterization and depth state of a draw. Where the device has
+// VK_EXT_extended_dynamic_state pipelines leave it to the command buffer,
+// otherwise every combination in use is a pipeline of its own.
+struct PipelineRasterState
+{
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    // dynamic with VK_EXT_extended_dynamic_state2 only
+    bool primitive_restart       = false;
+    VkCullModeFlags cull_mode    = VK_CULL_MODE_NONE;
+    VkFrontFace front_face       = VK_FRONT_FACE_CLOCKWISE;
+    bool depth_test              = true;
+    bool depth_write             = true;
+    VkCompareOp depth_compare_op = VK_COMPARE_OP_LESS;
+
+    bool operator==(const PipelineRasterState&) const = default;
+
+    // In a single word, for keying pipelines baked with the state
+    uint32_t pack() const;
+    static PipelineRasterState unpack(uint32_t packed);
+};
+
+// The extended dynamic state commands of a device, loaded when it has the
+// extensions
+class LveDynamicState
+{
+  public:
+    explicit LveDynamicState(LveDevice& device);
+
+    LveDynamicState(const LveDynamicState&) = delete;
+    LveDynamicState& operator=(const LveDynamicState&) = delete;
+
+    // Whether pipelines from default_pipeline_config_info() of the device
+    // leave the raster state to set()
+    bool is_supported() const
+    {
+        return set_cull_mode_ != nullptr;
+    }
+
+    // The part of state pipelines are created with, set() records the rest.
+    // A pipeline created for it draws with any state baked the same.
+    PipelineRasterState baked(const PipelineRasterState& state) const;
+
+    // Records the state pipelines left dynamic, nothing when unsupported.
+    // Dynamic state isn't inherited, each command buffer binding such a
+    // pipeline sets it before drawing.
+    void set(VkCommandBuffer command_buffer,
+             const PipelineRasterState& state) const;
+
+  private:
+    PFN_vkCmdSetPrimitiveTopologyEXT set_primitive_topology_     = nullptr;
+    PFN_vkCmdSetPrimitiveRestartEnableEXT set_primitive_restart_ = nullptr;
+    PFN_vkCmdSetCullModeEXT set_cull_mode_                       = nullptr;
+    PFN_vkCmdSetFrontFaceEXT set_front_face_                     = nullptr;
+    PFN_vkCmdSetDepthTestEnableEXT set_depth_test_               = nullptr;
+    PFN_vkCmdSetDepthWriteEnableEXT set_depth_write_             = nullptr;
+    PFN_vkCmdSetDepthCompareOpEXT set_depth_compare_op_          = nullptr;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveDynamicState>);
+static_assert(!std::is_copy_assignable_v<lve::LveDynamicState>);
@@ -0,0 +1,30 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <tutorial/camera.hpp>
+#include <tutorial/descriptors.hpp>
+#include <vulkan/vulkan.h>
+
+namespace lve
+{
+// Per frame data shared by all draws, mirrors GlobalUbo in the shaders
+struct GlobalUbo
+{
+    glm::mat4 projection{1.f};
+    glm::mat4 view{1.f};
+    float time = 0.f;
+};
+
+struct FrameInfo
+{
+    int frame_index;
+    float frame_time;
+    VkCommandBuffer command_buffer;
+    const LveCamera& camera;
+    VkDescriptorSet global_descriptor_set;
+    // sets allocated here live until the frame index comes around again
+    LveDescriptorAllocator& descriptor_allocator;
+};
+} // namespace lve
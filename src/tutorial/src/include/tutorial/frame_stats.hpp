@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lve
+{
+struct FrameStats
+{
+    struct Pacing
+    {
+        // since the previous frame
+        double frame_ms     = 0.0;
+        double max_frame_ms = 0.0;
+    };
+
+    struct Recording
+    {
+        double cpu_ms              = 0.0;
+        uint32_t threads           = 0;
+        uint32_t secondary_buffers = 0;
+    };
+
+    struct Culling
+    {
+        double cpu_ms          = 0.0;
+        uint32_t objects       = 0;
+        uint32_t visible       = 0;
+        uint32_t nodes_visited = 0;
+        bool rebuilt           = false;
+    };
+
+    struct Occlusion
+    {
+        double cpu_ms      = 0.0;
+        uint32_t occluders = 0;
+        uint32_t triangles = 0;
+        uint32_t tested    = 0;
+        uint32_t culled    = 0;
+    };
+
+    struct Sorting
+    {
+        double cpu_ms                = 0.0;
+        uint32_t draws               = 0;
+        uint32_t state_changes       = 0;
+        uint32_t state_changes_saved = 0;
+    };
+
+    struct Streaming
+    {
+        double cpu_ms           = 0.0;
+        uint32_t textures       = 0;
+        // textures with at least their mip tail in device memory
+        uint32_t resident       = 0;
+        // mip chains being loaded or copied
+        uint32_t pending        = 0;
+        // mip chains that finished uploading this frame
+        uint32_t uploads        = 0;
+        uint32_t evictions      = 0;
+        uint64_t uploaded_bytes = 0;
+        uint64_t resident_bytes = 0;
+        uint64_t budget_bytes   = 0;
+    };
+
+    struct RenderGraph
+    {
+        double cpu_ms     = 0.0;
+        uint32_t passes   = 0;
+        uint32_t culled   = 0;
+        uint32_t barriers = 0;
+        // transient images of every frame slot and the memory blocks they
+        // were packed into
+        uint32_t transient_images = 0;
+        uint32_t memory_blocks    = 0;
+        uint64_t transient_bytes  = 0;
+        // of transient_bytes, in lazily allocated memory
+        uint64_t lazy_bytes = 0;
+        // saved by sharing blocks, compared to an allocation per image
+        uint64_t aliased_bytes = 0;
+    };
+
+    struct Resolution
+    {
+        enum class Decision
+        {
+            hold,
+            drop,
+            raise
+        };
+
+        // of the latest frame that finished, 0 while unknown
+        double gpu_ms     = 0.0;
+        double target_ms  = 0.0;
+        float scale       = 1.f;
+        uint32_t width    = 0;
+        uint32_t height   = 0;
+        Decision decision = Decision::hold;
+        // when accumulated, the range of scales and how often they changed
+        float min_scale = 1.f;
+        float max_scale = 1.f;
+        uint32_t drops  = 0;
+        uint32_t raises = 0;
+    };
+
+    // input to screen when the device supports present wait, input to the
+    // end of the frame on the GPU otherwise
+    struct Latency
+    {
+        // frames that finished since the previous frame's stats
+        uint32_t frames = 0;
+        double total_ms = 0.0;
+        double max_ms   = 0.0;
+        bool to_present = false;
+    };
+
+    Pacing pacing;
+    Recording recording;
+    Culling culling;
+    Occlusion occlusion;
+    Sorting sorting;
+    Streaming streaming;
+    RenderGraph render_graph;
+    Resolution resolution;
+    Latency latency;
+};
+} // namespace lve
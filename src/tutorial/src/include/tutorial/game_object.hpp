@@ -3,6 +3,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <memory>
 #include <tutorial/model.hpp>
+#include <tutorial/occlusion_culler.hpp>
+#include <tutorial/texture.hpp>
 
 namespace lve
 {
@@ -67,6 +69,10 @@ class LveGameObject
     LveGameObject& operator=(LveGameObject&&) = default;
 
     std::shared_ptr<LveModel> model{};
+    // set on objects large enough to hide others behind them
+    std::shared_ptr<const OccluderMesh> occluder{};
+    // streamed by the app's texture streamer while the object is visible
+    TextureId texture = INVALID_TEXTURE_ID;
     glm::vec3 color{};
     TransformComponent transform;
 
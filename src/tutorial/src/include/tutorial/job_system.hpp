@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+class JobSystem
+{
+  public:
+    using range_job = std::function<void(size_t begin, size_t end, uint32_t)>;
+
+    // worker_count == 0 spawns one worker per hardware thread except the
+    // calling one
+    explicit JobSystem(uint32_t worker_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads taking part in parallel_for, including the calling thread
+    uint32_t thread_count() const
+    {
+        return static_cast<uint32_t>(workers_.size()) + 1;
+    }
+
+    // Splits [0, count) into contiguous ranges of at least min_range elements
+    // (at most max_ranges of them) and calls job(begin, end, range_index) for
+    // each. The calling thread runs range 0 and helps with queued work until
+    // every range is done. range_index < max_ranges, so callers can use it to
+    // pick per-thread resources without locking.
+    void parallel_for(size_t count,
+                      size_t min_range,
+                      uint32_t max_ranges,
+                      const range_job& job);
+
+    void parallel_for(size_t count, size_t min_range, const range_job& job)
+    {
+        parallel_for(count, min_range, thread_count(), job);
+    }
+
+  private:
+    void worker_loop();
+    bool try_run_pending_job();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable job_available_;
+    std::condition_variable job_done_;
+    bool stopping_ = false;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::JobSystem>);
+static_assert(!std::is_copy_assignable_v<lve::JobSystem>);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <file/mapped_file.hpp>
+#include <filesystem>
+#include <memory_resource>
+#include <tutorial/texture.hpp>
+#include <vector>
+
+namespace lve
+{
+// 2D texture stored in a KTX2 container, read through a file mapping. Levels
+// are copied to the GPU exactly as stored, so only formats the GPU samples
+// directly are accepted: BC1, BC3, BC5, BC7 and 8-bit RGBA, RG and R, with no
+// supercompression.
+class Ktx2Texture : public TextureSource
+{
+  public:
+    // Throws std::runtime_error when the file is not a KTX2 container this
+    // loader supports or its level index does not match the image
+    explicit Ktx2Texture(const std::filesystem::path& file_path);
+
+    VkFormat format() const override
+    {
+        return format_;
+    }
+
+    VkExtent2D extent() const override
+    {
+        return extent_;
+    }
+
+    uint32_t mip_levels() const override
+    {
+        return static_cast<uint32_t>(levels_.size());
+    }
+
+    size_t level_size(uint32_t level) const override
+    {
+        return static_cast<size_t>(levels_[level].size);
+    }
+
+    void load_level(uint32_t level,
+                    std::span<std::byte> destination) const override;
+
+  private:
+    struct Level
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    file::mapped_file file_;
+    VkFormat format_;
+    VkExtent2D extent_;
+    std::pmr::vector<Level> levels_;
+};
+} // namespace lve
@@ -1,4 +1,5 @@
 #pragma once
+#include <tutorial/bounds.hpp>
 #include <tutorial/device.hpp>
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -26,13 +27,28 @@ class LveModel
     LveModel& operator=(const LveModel&) = delete;
 
     void bind(VkCommandBuffer command_buffer);
-    void draw(VkCommandBuffer command_buffer);
+    // first_instance is visible to shaders through gl_InstanceIndex
+    void draw(VkCommandBuffer command_buffer, uint32_t first_instance = 0);
+
+    // Process unique id, used to order draws by vertex buffer
+    uint32_t get_id() const
+    {
+        return id_;
+    }
+
+    // Model space box around all vertex positions
+    const BoundingBox& get_bounds() const
+    {
+        return bounds_;
+    }
 
   private:
     void create_vertex_buffers(const std::pmr::vector<Vertex>& vertices);
     LveDevice& device_;
+    uint32_t id_;
     VkBuffer vertex_buffer_;
     VkDeviceMemory vertex_buffer_memory_;
     uint32_t vertex_count_;
+    BoundingBox bounds_;
 };
 } // namespace lve
@@ -0,0 +1,97 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <array>
+#include <glm/glm.hpp>
+#include <memory_resource>
+#include <tutorial/bounds.hpp>
+#include <tutorial/job_system.hpp>
+#include <vector>
+
+namespace lve
+{
+// Model space triangle list drawn into the occlusion buffer in place of the
+// full mesh, it must not extend past the mesh it stands for
+struct OccluderMesh
+{
+    std::pmr::vector<glm::vec3> triangles;
+
+    static OccluderMesh from_box(const BoundingBox& box);
+};
+
+// Low resolution CPU depth buffer in the spirit of masked occlusion culling.
+// A handful of occluders is rasterized into it each frame, in horizontal
+// bands on the job system, and object boxes are then tested against the
+// farthest depth of 8x8 pixel tiles, falling back to the pixels under the box
+// only for tiles that are not fully in front of it.
+class OcclusionCuller
+{
+  public:
+    static constexpr uint32_t DEFAULT_WIDTH  = 320;
+    static constexpr uint32_t DEFAULT_HEIGHT = 192;
+    static constexpr uint32_t TILE_SIZE      = 8;
+
+    explicit OcclusionCuller(JobSystem& job_system,
+                             uint32_t width  = DEFAULT_WIDTH,
+                             uint32_t height = DEFAULT_HEIGHT);
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // Clears the buffer and drops occluders of the previous frame
+    void begin_frame(const glm::mat4& projection_view);
+    void add_occluder(const OccluderMesh& mesh, const glm::mat4& transform);
+    // Rasterizes all added occluders and builds the tile level from them
+    void rasterize();
+
+    // False only when the box is certainly hidden behind the occluders, by
+    // more than a small depth bias. Don't test an occluder's own box, the
+    // bias only covers float error.
+    bool is_visible(const BoundingBox& box) const;
+
+    uint32_t occluder_count() const
+    {
+        return occluder_count_;
+    }
+
+    uint32_t triangle_count() const
+    {
+        return static_cast<uint32_t>(triangles_.size());
+    }
+
+  private:
+    // Screen space triangle set up for rasterization, edge functions and the
+    // depth plane are evaluated as a * x + b * y + c at pixel centers
+    struct Triangle
+    {
+        std::array<float, 3> edge_a;
+        std::array<float, 3> edge_b;
+        std::array<float, 3> edge_c;
+        float depth_a;
+        float depth_b;
+        float depth_c;
+        uint32_t min_x;
+        uint32_t min_y;
+        uint32_t max_x; // exclusive
+        uint32_t max_y; // exclusive
+    };
+
+    void rasterize_rows(uint32_t begin, uint32_t end);
+    void build_tiles(uint32_t begin, uint32_t end);
+
+    JobSystem& job_system_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t tiles_x_;
+    uint32_t tiles_y_;
+    glm::mat4 projection_view_{1.f};
+    std::pmr::vector<Triangle> triangles_;
+    std::pmr::vector<float> depth_;
+    std::pmr::vector<float> tile_depth_;
+    uint32_t occluder_count_ = 0;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::OcclusionCuller>);
+static_assert(!std::is_copy_assignable_v<lve::OcclusionCuller>);
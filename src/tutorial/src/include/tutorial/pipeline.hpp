@@ -1,12 +1,30 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <tutorial/device.hpp>
+#include <tutorial/dynamic_state.hpp>
+#include <tutorial/pipeline_library_cache.hpp>
 #include <vector>
 
 namespace lve
 {
+// What a pipeline renders into: a subpass of a render pass, or with
+// dynamic rendering no render pass and the formats of the attachments
+struct PipelineRenderTarget
+{
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    uint32_t subpass         = 0;
+    VkFormat color_format    = VK_FORMAT_UNDEFINED;
+    VkFormat depth_format    = VK_FORMAT_UNDEFINED;
+    VkFormat stencil_format  = VK_FORMAT_UNDEFINED;
+};
+
 struct PipelineConfigInfo
 {
     PipelineConfigInfo()                          = default;
@@ -23,32 +41,87 @@ struct PipelineConfigInfo
     std::vector<VkDynamicState> dynamic_state_enables;
     VkPipelineDynamicStateCreateInfo dynamic_state_info;
     VkPipelineLayout pipeline_layout = nullptr;
-    VkRenderPass render_pass         = nullptr;
-    uint32_t subpass                 = 0;
+    PipelineRenderTarget render_target{};
+    // where graphics pipeline libraries come from, pipelines without one
+    // are created monolithically
+    LvePipelineLibraryCache* library_cache = nullptr;
 };
 
+// Specialization constants are given as 32-bit values, constant_id i of
+// both shaders takes specialization_constants[i]. Ids a shader doesn't
+// declare are ignored for it.
+//
+// With graphics pipeline libraries the vertex input, pre-rasterization,
+// fragment shader and fragment output parts come from the config's library
+// cache, which only creates the parts no other pipeline had yet. They are
+// linked without optimisation, which is quick enough for first use. The
+// cache's optimizer thread then links them with link time optimisation and
+// the result replaces the fast linked pipeline, bind() picks up whichever
+// is current. Other devices, and configs without a cache, create one
+// monolithic pipeline.
 class LvePipeline
 {
   public:
     LvePipeline(LveDevice& device,
                 const std::filesystem::path& vertex_path,
                 const std::filesystem::path& fragment_path,
-                const PipelineConfigInfo& config);
+                const PipelineConfigInfo& config,
+                std::span<const uint32_t> specialization_constants = {});
+    // From SPIR-V already in memory, such as the embedded shaders
+    LvePipeline(LveDevice& device,
+                std::span<const uint32_t> vertex_code,
+                std::span<const uint32_t> fragment_code,
+                const PipelineConfigInfo& config,
+                std::span<const uint32_t> specialization_constants = {});
     ~LvePipeline();
     void bind(VkCommandBuffer command_buffer);
-    static void default_pipeline_config_info(PipelineConfigInfo& config_info);
+    // Leaves the raster state dynamic where the device has extended dynamic
+    // state, draws set it with LveDynamicState::set() then
+    static void default_pipeline_config_info(
+        PipelineConfigInfo& config_info,
+        const DeviceFeatureSupport& features = {});
+    // Bakes state into the config, parts left dynamic are only defaults
+    static void set_raster_state(PipelineConfigInfo& config_info,
+                                 const PipelineRasterState& state);
+
+    // Process unique id, used to order draws by pipeline
+    uint32_t get_id() const
+    {
+        return id_;
+    }
 
   private:
-    void create_graphics_pipeline(const std::filesystem::path& vertex_path,
-                                  const std::filesystem::path& fragment_path,
-                                  const PipelineConfigInfo& config);
+    void create_graphics_pipeline(
+        std::span<const uint32_t> vertex_code,
+        std::span<const uint32_t> fragment_code,
+        const PipelineConfigInfo& config,
+        std::span<const uint32_t> specialization_constants);
 
-    void create_shader_module(const std::pmr::vector<std::byte>& code,
+    void create_shader_module(std::span<const uint32_t> code,
                               VkShaderModule* shade_module);
 
+    // What bind() uses, shared with the optimised link queued on the
+    // library cache, which may only run once the LvePipeline is gone
+    struct Linked
+    {
+        std::atomic<VkPipeline> pipeline{VK_NULL_HANDLE};
+        // held to swap the pipeline in and to destroy it, never to link
+        std::mutex mutex;
+        bool destroyed = false;
+    };
+
+    // Runs on the cache's optimizer thread, swaps the optimised pipeline in
+    // unless the LvePipeline was destroyed meanwhile
+    static void optimize_libraries(LveDevice& device,
+                                   Linked& linked,
+                                   const std::array<VkPipeline, 4>& libraries,
+                                   VkPipelineLayout layout,
+                                   uint32_t id);
+
     LveDevice& device_;
-    VkPipeline graphics_pipeline_;
-    VkShaderModule vert_shader_module_;
-    VkShaderModule frag_shader_module_;
+    uint32_t id_;
+    VkShaderModule vert_shader_module_ = VK_NULL_HANDLE;
+    VkShaderModule frag_shader_module_ = VK_NULL_HANDLE;
+    std::shared_ptr<Linked> linked_    = std::make_shared<Linked>();
 };
 } // namespace lve
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <mutex>
+#include <span>
+#include <tutorial/descriptors.hpp>
+#include <tutorial/device.hpp>
+#include <tutorial/spirv_reflection.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+// Builds pipeline layouts from reflected shaders instead of hand written
+// descriptions and hands out the same layout for pipelines with equal
+// interfaces, which keeps descriptor sets bound across their pipelines
+class LvePipelineLayoutCache
+{
+  public:
+    // A set layout created elsewhere, e.g. a global or bindless set, with the
+    // bindings it was created from
+    struct SetLayout
+    {
+        uint32_t set;
+        VkDescriptorSetLayout layout;
+        std::pmr::vector<VkDescriptorSetLayoutBinding> bindings;
+    };
+
+    LvePipelineLayoutCache(LveDevice& device,
+                           LveDescriptorLayoutCache& descriptor_layout_cache)
+        : device_{device}, descriptor_layout_cache_{descriptor_layout_cache}
+    {
+    }
+    ~LvePipelineLayoutCache();
+
+    LvePipelineLayoutCache(const LvePipelineLayoutCache&) = delete;
+    LvePipelineLayoutCache& operator=(const LvePipelineLayoutCache&) = delete;
+
+    // Layout for a pipeline made of the reflected stages. Given set layouts
+    // are checked against the shaders and used as they are, the other sets
+    // get layouts from the reflected bindings. The push constant blocks of
+    // all stages share one range. Throws std::runtime_error when the stages
+    // disagree on a binding or don't fit a given set layout.
+    VkPipelineLayout get_pipeline_layout(
+        std::span<const ShaderReflection> stages,
+        std::span<const SetLayout> set_layouts = {});
+
+    size_t size() const;
+
+    static SetLayout describe(uint32_t set,
+                              const LveDescriptorSetLayout& set_layout)
+    {
+        return {set,
+                set_layout.get_descriptor_set_layout(),
+                set_layout.get_bindings()};
+    }
+
+  private:
+    struct LayoutKey
+    {
+        std::pmr::vector<VkDescriptorSetLayout> set_layouts;
+        VkPushConstantRange push_constant_range;
+
+        bool operator==(const LayoutKey& other) const;
+    };
+
+    struct LayoutKeyHash
+    {
+        size_t operator()(const LayoutKey& key) const;
+    };
+
+    LveDevice& device_;
+    LveDescriptorLayoutCache& descriptor_layout_cache_;
+    mutable std::mutex mutex_;
+    std::unordered_map<LayoutKey, VkPipelineLayout, LayoutKeyHash> layouts_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LvePipelineLayoutCache>);
+static_assert(!std::is_copy_assignable_v<lve::LvePipelineLayoutCache>);
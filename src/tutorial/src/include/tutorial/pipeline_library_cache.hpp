@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <tutorial/device.hpp>
+#include <vector>
+
+namespace lve
+{
+// Graphics pipeline library parts shared between pipelines. Each part is
+// keyed by the state of the complete create info it is created from, the
+// shader parts by their code and specialization constants as well, so
+// pipelines that only differ in some parts create those and link the rest
+// from the cache. Render passes and layouts named by the keys must live as
+// long as the cache.
+// The cache also runs the optimised links of its pipelines on a thread of
+// its own, so destroying a pipeline never waits for one.
+class LvePipelineLibraryCache
+{
+  public:
+    explicit LvePipelineLibraryCache(LveDevice& device);
+    // Drops the links that haven't started and waits for the running one
+    ~LvePipelineLibraryCache();
+
+    LvePipelineLibraryCache(const LvePipelineLibraryCache&) = delete;
+    LvePipelineLibraryCache& operator=(const LvePipelineLibraryCache&) = delete;
+
+    // The library for one part of complete, created on first use. Shader
+    // stages are given as code, a VkShaderModuleCreateInfo chained to the
+    // stage in place of a module. Safe to call from several threads, throws
+    // std::runtime_error when creating the library fails.
+    VkPipeline get_library(const VkGraphicsPipelineCreateInfo& complete,
+                           VkGraphicsPipelineLibraryFlagsEXT part);
+
+    // Runs link on the optimizer thread after the links queued before it.
+    // It is dropped if the cache is destroyed first.
+    void optimize_later(std::function<void()> link);
+
+    size_t size() const;
+
+  private:
+    // the part, then the state it reads from the complete create info
+    using Key = std::pmr::vector<uint32_t>;
+
+    static Key make_key(const VkGraphicsPipelineCreateInfo& complete,
+                        VkGraphicsPipelineLibraryFlagsEXT part);
+    VkPipeline create_library(const VkGraphicsPipelineCreateInfo& complete,
+                              VkGraphicsPipelineLibraryFlagsEXT part);
+    void optimizer_loop();
+
+    LveDevice& device_;
+    mutable std::mutex mutex_;
+    std::map<Key, VkPipeline> libraries_;
+
+    std::mutex optimizer_mutex_;
+    std::condition_variable optimizer_wakeup_;
+    std::deque<std::function<void()>> link_queue_;
+    bool stopping_ = false;
+    std::thread optimizer_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LvePipelineLibraryCache>);
+static_assert(!std::is_copy_assignable_v<lve::LvePipelineLibraryCache>);
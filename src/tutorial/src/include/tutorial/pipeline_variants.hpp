@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <span>
+#include <tutorial/pipeline.hpp>
+#include <tutorial/shader_reloader.hpp>
+#include <vector>
+
+namespace lve
+{
+// Pipelines of one shader pair specialised for different values of its
+// specialization constants. A variant is created the first time its values
+// are asked for and cached from then on, so a render system can keep one
+// ubershader in source and let the driver strip the branches each variant
+// doesn't take. Fixed function state the device can't set dynamically is
+// part of a variant too, as a word the render system packs it into.
+class LvePipelineVariants
+{
+  public:
+    // Creates the pipeline for the given constant values and baked state.
+    // from_files asks for the shaders on disk instead of the embedded ones,
+    // it is set once the shaders have been reloaded.
+    using Factory = std::function<std::unique_ptr<LvePipeline>(
+        std::span<const uint32_t> specialization_constants,
+        uint32_t baked_state,
+        bool from_files)>;
+
+    LvePipelineVariants(uint32_t constant_count, Factory factory);
+    ~LvePipelineVariants();
+
+    LvePipelineVariants(const LvePipelineVariants&) = delete;
+    LvePipelineVariants& operator=(const LvePipelineVariants&) = delete;
+
+    // Rebuilds every variant, including ones created later, when one of the
+    // shaders changes. The reloader must outlive the variants.
+    void watch_shaders(LveShaderReloader& shader_reloader,
+                       const std::pmr::vector<std::filesystem::path>& shaders);
+
+    // The variant for the given values, created on first use. Call on the
+    // render thread, the reference is valid until the next apply_reloads()
+    // of a watching reloader.
+    LvePipeline& get(std::span<const uint32_t> specialization_constants,
+                     uint32_t baked_state = 0);
+
+    size_t size() const
+    {
+        return variants_.size();
+    }
+
+  private:
+    // the constants, then the baked state
+    using Key = std::pmr::vector<uint32_t>;
+
+    void watch_variant(const Key& key, std::unique_ptr<LvePipeline>& variant);
+
+    uint32_t constant_count_;
+    Factory factory_;
+    // map nodes stay in place, the reloader swaps variants through them
+    std::map<Key, std::unique_ptr<LvePipeline>> variants_;
+
+    LveShaderReloader* shader_reloader_ = nullptr;
+    std::pmr::vector<std::filesystem::path> shaders_;
+    // set by the first rebuild on the reloader's thread
+    std::atomic<bool> reloaded_{false};
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LvePipelineVariants>);
+static_assert(!std::is_copy_assignable_v<lve::LvePipelineVariants>);
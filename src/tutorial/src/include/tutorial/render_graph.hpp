@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <tutorial/device.hpp>
+#include <tutorial/frame_stats.hpp>
+#include <tutorial/render_graph_plan.hpp>
+#include <type_traits>
+#include <vector>
+
+namespace lve
+{
+// A frame declared as passes reading and writing images and buffers. Each
+// frame the graph is reset, declared and compiled: passes whose results
+// nothing uses are culled, the rest are ordered, and the barriers and layout
+// transitions between them are derived from what they declared. Transient
+// images are created by the graph, those whose passes don't overlap share
+// memory, and they are kept as long as later frames declare the same ones.
+// Each frame slot has its own transient images, so a frame never waits for
+// the one before it to be done with them.
+//
+// Passes with attachments run inside a render pass the graph begins, with
+// color attachments first and depth last in the order they were declared.
+// On devices with dynamic rendering the graph begins rendering to the
+// attachments instead and creates no render passes or framebuffers.
+class LveRenderGraph : public RenderGraphPlan
+{
+  public:
+    explicit LveRenderGraph(LveDevice& device);
+    // Hands the transient images and cached objects to the deletion queue
+    ~LveRenderGraph();
+
+    LveRenderGraph(const LveRenderGraph&) = delete;
+    LveRenderGraph& operator=(const LveRenderGraph&) = delete;
+
+    // Forgets the declared passes and resources, the transient images stay
+    // until a compile finds they are no longer declared. The frame is
+    // recorded for frame_slot, whose previous frame the GPU must have
+    // finished, as LveRenderer::begin_frame() ensures for its frame index.
+    void reset(uint32_t frame_slot = 0);
+
+    // Plans the declared frame and creates what it needs. Throws
+    // std::runtime_error when transient images can't be created.
+    void compile();
+    // Records the compiled passes with their barriers, then brings imported
+    // resources to their final state
+    void execute(VkCommandBuffer command_buffer);
+
+    const FrameStats::RenderGraph& get_stats() const
+    {
+        return stats_;
+    }
+
+  private:
+    // compiles a cached framebuffer may go unused before it is destroyed
+    static constexpr uint64_t FRAMEBUFFER_MAX_IDLE_COMPILES = 16;
+
+    struct CachedRenderPass
+    {
+        // format, load and store op and layout of each attachment
+        std::pmr::vector<uint32_t> key;
+        VkRenderPass render_pass;
+    };
+
+    struct CachedFramebuffer
+    {
+        VkRenderPass render_pass;
+        std::pmr::vector<VkImageView> views;
+        // of each view, handles alone may be reused by recreated views
+        std::pmr::vector<uint64_t> generations;
+        VkExtent2D extent;
+        VkFramebuffer framebuffer;
+        uint64_t last_used;
+    };
+
+    void realize_transient_images();
+    void prepare_render_passes();
+    void retire_transient_images(TransientSet& set);
+    void retire_framebuffers(bool all);
+    VkRenderPass get_render_pass(const Pass& pass);
+    VkFramebuffer get_framebuffer(const Pass& pass);
+    void record_barriers(VkCommandBuffer command_buffer,
+                         std::span<const Barrier> barriers);
+    void begin_rendering(VkCommandBuffer command_buffer, const Pass& pass);
+
+    LveDevice& device_;
+
+    // set when the device renders dynamically
+    PFN_vkCmdBeginRenderingKHR begin_rendering_ = nullptr;
+    PFN_vkCmdEndRenderingKHR end_rendering_     = nullptr;
+    // memory types with VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+    uint32_t lazy_memory_types_ = 0;
+    uint32_t frame_slot_        = 0;
+    std::pmr::vector<TransientSet> transient_sets_;
+    std::pmr::vector<CachedRenderPass> render_passes_;
+    std::pmr::vector<CachedFramebuffer> framebuffers_;
+    uint64_t compile_count_ = 0;
+    bool compiled_          = false;
+    FrameStats::RenderGraph stats_{};
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveRenderGraph>);
+static_assert(!std::is_copy_assignable_v<lve::LveRenderGraph>);
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace lve
+{
+// Handles of the graph being declared, valid until the next reset()
+struct RenderGraphImage
+{
+    uint32_t index = UINT32_MAX;
+};
+
+struct RenderGraphBuffer
+{
+    uint32_t index = UINT32_MAX;
+};
+
+// How an imported resource is handed to the graph and back. Stages and
+// access are those of the last use before the graph runs, or of the first
+// use after it, the layout is ignored for buffers.
+struct RenderGraphState
+{
+    VkImageLayout layout        = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags stages = 0;
+    VkAccessFlags access        = 0;
+};
+
+// An image the graph allocates and may alias with others whose passes
+// don't overlap. Its usage flags follow from the passes using it. Images
+// only used as attachments that nothing reads are placed in lazily
+// allocated memory where the device has it, which tile based GPUs may never
+// back with memory at all.
+struct RenderGraphImageDesc
+{
+    VkFormat format;
+    VkExtent2D extent;
+};
+
+// An image owned elsewhere, such as a swap chain image
+struct RenderGraphImportedImage
+{
+    VkImage image;
+    VkImageView view;
+    VkFormat format;
+    VkExtent2D extent;
+    RenderGraphState initial{};
+    RenderGraphState final{};
+    // changed by the owner whenever it recreates the view, so a new view
+    // that reuses the handle of a destroyed one gets its own framebuffers
+    uint64_t generation = 0;
+};
+
+// The declarations of a render graph and the plan made from them: which
+// passes run in which order, the barriers between them and which transient
+// images share memory. Planning only looks at what was declared, creating
+// and recording is left to LveRenderGraph.
+class RenderGraphPlan
+{
+  public:
+    class PassBuilder
+    {
+      public:
+        // Stored unless nothing after the pass reads the image
+        void color_attachment(RenderGraphImage image,
+                              VkAttachmentLoadOp load_op,
+                              VkClearColorValue clear = {});
+        void depth_attachment(RenderGraphImage image,
+                              VkAttachmentLoadOp load_op,
+                              VkClearDepthStencilValue clear = {1.f, 0});
+        void sampled(RenderGraphImage image,
+                     VkPipelineStageFlags stages =
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        void storage_read(RenderGraphImage image, VkPipelineStageFlags stages);
+        void storage_write(RenderGraphImage image, VkPipelineStageFlags stages);
+        void transfer_source(RenderGraphImage image);
+        void transfer_destination(RenderGraphImage image);
+
+        void read(RenderGraphBuffer buffer,
+                  VkPipelineStageFlags stages,
+                  VkAccessFlags access);
+        void write(RenderGraphBuffer buffer,
+                   VkPipelineStageFlags stages,
+                   VkAccessFlags access);
+
+        // Renders to the top left extent of the attachments only, the whole
+        // of them by default
+        void render_area(VkExtent2D extent);
+        // Keeps the pass even when nothing uses what it writes
+        void side_effect();
+        // The pass records its render pass contents into secondary command
+        // buffers, it may only execute them then
+        void secondary_command_buffers();
+
+      private:
+        friend class RenderGraphPlan;
+
+        PassBuilder(RenderGraphPlan& graph, uint32_t pass)
+            : graph_{graph}, pass_{pass}
+        {
+        }
+
+        void use_image(RenderGraphImage image,
+                       VkImageLayout layout,
+                       VkPipelineStageFlags stages,
+                       VkAccessFlags access,
+                       VkImageUsageFlags usage,
+                       bool reads,
+                       bool writes);
+        void use_buffer(RenderGraphBuffer buffer,
+                        VkPipelineStageFlags stages,
+                        VkAccessFlags access,
+                        bool reads,
+                        bool writes);
+
+        RenderGraphPlan& graph_;
+        uint32_t pass_;
+    };
+
+    // Records the pass, inside its render pass when it has attachments.
+    // Called while the graph executes, in the compiled order.
+    using ExecuteFunction = std::function<void(VkCommandBuffer)>;
+
+    // A dependency between two uses of a resource, recorded before the pass
+    // of the second one
+    struct Barrier
+    {
+        uint32_t resource;
+        bool image;
+        VkPipelineStageFlags src_stages;
+        VkAccessFlags src_access;
+        VkPipelineStageFlags dst_stages;
+        VkAccessFlags dst_access;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+    };
+
+    RenderGraphImage create_image(std::string_view name,
+                                  const RenderGraphImageDesc& desc);
+    RenderGraphImage import_image(std::string_view name,
+                                  const RenderGraphImportedImage& image);
+    RenderGraphBuffer import_buffer(std::string_view name,
+                                    VkBuffer buffer,
+                                    RenderGraphState initial = {},
+                                    RenderGraphState final   = {});
+
+    // setup declares what the pass uses right away. Passes see the writes
+    // of the passes declared before them.
+    void add_pass(std::string_view name,
+                  const std::function<void(PassBuilder&)>& setup,
+                  ExecuteFunction execute);
+
+    // The plan of the last compile, passes by declaration index
+    std::span<const uint32_t> get_pass_order() const
+    {
+        return order_;
+    }
+    bool is_culled(uint32_t pass) const
+    {
+        return passes_[pass].culled;
+    }
+    std::span<const Barrier> get_barriers(uint32_t pass) const
+    {
+        return passes_[pass].barriers;
+    }
+    // Barriers after the last pass, to the final state of imported resources
+    std::span<const Barrier> get_final_barriers() const
+    {
+        return final_barriers_;
+    }
+    // The image behind a handle, for passes to record commands with. Valid
+    // after compile() for transient images.
+    VkImage get_image(RenderGraphImage image) const
+    {
+        return images_[image.index].image;
+    }
+    // Transient images with the same block share memory, UINT32_MAX for
+    // imported and unused images
+    uint32_t get_memory_block(RenderGraphImage image) const
+    {
+        return images_[image.index].block;
+    }
+
+  protected:
+    static constexpr uint32_t NO_PASS = UINT32_MAX;
+
+    struct Use
+    {
+        uint32_t resource;
+        bool image;
+        VkImageLayout layout;
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkImageUsageFlags usage;
+        bool reads;
+        bool writes;
+        // the version of the resource the use reads, a write makes the next
+        uint32_t version;
+    };
+
+    struct Attachment
+    {
+        uint32_t image;
+        VkAttachmentLoadOp load_op;
+        VkAttachmentStoreOp store_op;
+        VkClearValue clear;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        ExecuteFunction execute;
+        std::pmr::vector<Use> uses;
+        // color attachments, then the depth attachment
+        std::pmr::vector<Attachment> attachments;
+        bool has_depth          = false;
+        bool side_effect        = false;
+        bool secondary_contents = false;
+        bool culled             = false;
+        std::pmr::vector<Barrier> barriers;
+        VkRenderPass render_pass  = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent         = {};
+        // within extent, the whole of it unless the pass declared one
+        VkExtent2D render_area = {};
+    };
+
+    struct Image
+    {
+        std::string name;
+        bool imported;
+        VkFormat format;
+        VkExtent2D extent;
+        VkImageUsageFlags usage = 0;
+        VkImage image           = VK_NULL_HANDLE;
+        VkImageView view        = VK_NULL_HANDLE;
+        // of the imported view, transient views are never reused while
+        // framebuffers hold them
+        uint64_t generation = 0;
+        RenderGraphState initial{};
+        RenderGraphState final{};
+        uint32_t version = 0;
+        // first and last use in compiled order, NO_PASS while unused
+        uint32_t first_use = NO_PASS;
+        uint32_t last_use  = NO_PASS;
+        // whether a compiled pass reads it
+        bool read = false;
+        // index of the physical image and memory block of transient images
+        uint32_t physical = UINT32_MAX;
+        uint32_t block    = UINT32_MAX;
+    };
+
+    struct Buffer
+    {
+        std::string name;
+        VkBuffer buffer;
+        RenderGraphState initial{};
+        RenderGraphState final{};
+        uint32_t version = 0;
+    };
+
+    // what a transient image is created from, compiles declaring the same
+    // list reuse the images and memory of the previous one
+    struct TransientKey
+    {
+        VkFormat format;
+        VkExtent2D extent;
+        VkImageUsageFlags usage;
+        uint32_t first_use;
+        uint32_t last_use;
+
+        bool operator==(const TransientKey& other) const;
+    };
+
+    struct PhysicalImage
+    {
+        VkImage image    = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkMemoryRequirements requirements{};
+        uint32_t block = 0;
+    };
+
+    struct MemoryBlock
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size     = 0;
+        uint32_t type_bits    = 0;
+        // holds transient attachments only, in lazily allocated memory when
+        // the device has it
+        bool lazy = false;
+        // physical images placed in the block, their uses never overlap
+        std::pmr::vector<uint32_t> images;
+    };
+
+    // the transient images of a frame slot
+    struct TransientSet
+    {
+        std::pmr::vector<TransientKey> keys;
+        std::pmr::vector<PhysicalImage> images;
+        std::pmr::vector<MemoryBlock> blocks;
+    };
+
+    // Forgets the declared passes and resources
+    void clear();
+
+    // images first, then buffers
+    uint32_t resource_key(const Use& use) const
+    {
+        return use.image ? use.resource
+                         : static_cast<uint32_t>(images_.size()) + use.resource;
+    }
+    // a flag per version of every resource, by resource_key()
+    std::pmr::vector<std::pmr::vector<bool>> version_flags() const;
+
+    void cull_passes();
+    void order_passes();
+    // A key per transient image the ordered passes use, in the order of
+    // their physical indices. With lazy_memory, attachments nothing reads
+    // ask for transient attachment usage.
+    std::pmr::vector<TransientKey> transient_keys(bool lazy_memory);
+    // Places the set's images in memory blocks from their keys and memory
+    // requirements, the blocks' memory is left to the caller
+    static void plan_memory_blocks(TransientSet& set);
+    // Points the transient images at the set's images and blocks
+    void use_transient_set(const TransientSet& set);
+    // block_count is that of the transient set in use
+    void plan_barriers(uint32_t block_count);
+    void choose_store_ops();
+
+    std::pmr::vector<Pass> passes_;
+    std::pmr::vector<Image> images_;
+    std::pmr::vector<Buffer> buffers_;
+    std::pmr::vector<uint32_t> order_;
+    std::pmr::vector<Barrier> final_barriers_;
+};
+} // namespace lve
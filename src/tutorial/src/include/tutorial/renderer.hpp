@@ -1,9 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <tutorial/descriptors.hpp>
 #include <tutorial/device.hpp>
+#include <tutorial/frame_stats.hpp>
 #include <tutorial/model.hpp>
+#include <tutorial/pipeline.hpp>
+#include <tutorial/render_graph.hpp>
 #include <tutorial/swap_chain.hpp>
 #include <tutorial/window.hpp>
 #include <vector>
@@ -13,19 +22,127 @@ namespace lve
 class LveRenderer
 {
   public:
-    LveRenderer(LveWindow& window, LveDevice& device);
+    LveRenderer(LveWindow& window,
+                LveDevice& device,
+                uint32_t recording_thread_count   = 1,
+                SwapChainConfig swap_chain_config = {});
     ~LveRenderer();
 
-    VkCommandBuffer begin_frame();
+    // Called before the input of the next frame is read. With low latency
+    // pacing it blocks until the GPU released the frame's resources, so the
+    // input is read after the wait instead of before it.
+    void wait_for_frame();
+    // input_time is when the frame's input was read, frames are measured
+    // from it to when they are shown
+    VkCommandBuffer begin_frame(
+        std::chrono::steady_clock::time_point input_time =
+            std::chrono::steady_clock::now());
     void end_frame();
 
-    void begin_swap_chain_render_pass(VkCommandBuffer command_buffer);
-    void end_swap_chain_render_pass(VkCommandBuffer command_buffer);
+    // Takes effect with the next frame, which recreates the swap chain
+    void set_swap_chain_config(SwapChainConfig config);
+    // Swap chains created so far, the first one included
+    uint32_t get_swap_chain_recreations() const
+    {
+        return swap_chain_recreations_;
+    }
+    const SwapChainConfig& get_swap_chain_config() const
+    {
+        return swap_chain_config_;
+    }
+    VkPresentModeKHR get_present_mode() const
+    {
+        return swap_chain_->presentMode();
+    }
+    uint32_t get_frames_in_flight() const
+    {
+        return swap_chain_->framesInFlight();
+    }
+    uint32_t get_swap_chain_image_count() const
+    {
+        return static_cast<uint32_t>(swap_chain_->imageCount());
+    }
+
+    // Adds the latency of the frames that were shown since the last call
+    void collect_latency(FrameStats::Latency& stats);
+
+    // The image the frame in progress renders to, brought from when it was
+    // acquired to its presentable layout by the graph
+    RenderGraphImage import_swap_chain_image(LveRenderGraph& graph) const;
+    VkExtent2D get_swap_chain_extent() const
+    {
+        return swap_chain_->getSwapChainExtent();
+    }
+    VkFormat get_depth_format() const
+    {
+        return swap_chain_->getDepthFormat();
+    }
+    VkFormat get_swap_chain_image_format() const
+    {
+        return swap_chain_->getSwapChainImageFormat();
+    }
+    bool supports_upscaling() const
+    {
+        return swap_chain_->supportsUpscaling();
+    }
 
-    VkRenderPass get_swap_chain_render_pass() const
+    // GPU time from the start to the end of the command buffer of the last
+    // frame known to have finished, nullopt without timestamp support
+    std::optional<double> get_gpu_frame_ms() const
     {
+        return gpu_frame_ms_;
+    }
 
-        return swap_chain_->getRenderPass();
+    // Viewport and scissor of the frame's secondary command buffers, the
+    // swap chain extent unless set after begin_frame()
+    void set_render_extent(VkExtent2D extent)
+    {
+        assert(is_frame_in_progress() &&
+               "Can't set render extent if frame is not in progress");
+        render_extent_ = extent;
+    }
+
+    // The frame's shaders wait for the device's transfer timeline to reach
+    // value, so they see what was uploaded up to it
+    void wait_for_transfer(uint64_t value)
+    {
+        assert(is_frame_in_progress() &&
+               "Can't wait for transfers if frame is not in progress");
+        transfer_wait_value_ = std::max(transfer_wait_value_, value);
+    }
+
+    // Secondary command buffers continue a render pass compatible with the
+    // swap chain render pass, or dynamic rendering to attachments of the
+    // swap chain formats, with the render extent. Each
+    // recording thread owns a command pool per frame in flight, so buffers
+    // for different thread indices can be recorded concurrently.
+    VkCommandBuffer begin_secondary_command_buffer(uint32_t thread_index);
+    void end_secondary_command_buffer(VkCommandBuffer command_buffer);
+    void execute_secondary_command_buffers(
+        VkCommandBuffer command_buffer,
+        const std::pmr::vector<VkCommandBuffer>& secondary_buffers);
+
+    // Threads recording from the next frame on, at most the count the
+    // renderer was created with
+    void set_recording_thread_count(uint32_t count)
+    {
+        assert(count > 0 && count <= secondary_pools_[0].size() &&
+               "Recording thread count without command pools");
+        recording_thread_count_ = count;
+    }
+    uint32_t get_recording_thread_count() const
+    {
+        return recording_thread_count_;
+    }
+
+    // What pipelines drawing to the swap chain are created against
+    PipelineRenderTarget get_render_target() const
+    {
+        return {.render_pass    = swap_chain_->getRenderPass(),
+                .subpass        = 0,
+                .color_format   = swap_chain_->getSwapChainImageFormat(),
+                .depth_format   = swap_chain_->getDepthFormat(),
+                .stencil_format = swap_chain_->getStencilFormat()};
     }
     bool is_frame_in_progress() const
     {
@@ -51,19 +168,86 @@ class LveRenderer
         return current_frame_index_;
     }
 
+    // Transient sets of the frame in progress, recycled when the frame's
+    // previous submission has completed
+    LveDescriptorAllocator& get_frame_descriptor_allocator() const
+    {
+        assert(is_frame_in_progress() &&
+               "Cannot get descriptor allocator when frame not in progress");
+        return *frame_descriptor_allocators_[current_frame_index_];
+    }
+
   private:
+    struct SecondaryCommandPool
+    {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::pmr::vector<VkCommandBuffer> buffers;
+        size_t used = 0;
+    };
+
+    // a submitted frame whose latency isn't known yet
+    struct PresentedFrame
+    {
+        // 0 without present wait, the graphics timeline tells then
+        uint64_t present_id;
+        uint64_t frame;
+        std::chrono::steady_clock::time_point input_time;
+    };
+
     void create_command_buffers();
     void free_command_buffers();
-    void recreate_swap_chain();
+    void create_secondary_command_pools(uint32_t thread_count);
+    void destroy_secondary_command_pools();
+    void reset_secondary_command_pools();
+    void create_timestamp_pool();
+    // reads the timestamps the frame slot's previous frame wrote
+    void read_gpu_frame_time();
+    void set_viewport_and_scissor(VkCommandBuffer command_buffer);
+    // false while the window is minimized, the swap chain stays outdated
+    // then and frames are skipped
+    bool recreate_swap_chain();
+    // Blocks until frame and every frame before it finished on the GPU,
+    // then runs the deletions that were waiting for them
+    void wait_for_completed_frame(uint64_t frame);
+    void poll_presented_frames();
 
     LveWindow& window_;
     LveDevice& device_;
+    SwapChainConfig swap_chain_config_;
+    // recreated at the start of the next frame
+    bool swap_chain_outdated_        = false;
+    uint32_t swap_chain_recreations_ = 0;
     std::unique_ptr<LveSwapChain> swap_chain_;
     std::pmr::vector<VkCommandBuffer> command_buffer_;
+    std::array<std::pmr::vector<SecondaryCommandPool>,
+               LveSwapChain::MAX_FRAMES_IN_FLIGHT>
+        secondary_pools_;
+    uint32_t recording_thread_count_ = 1;
+    std::array<std::unique_ptr<LveDescriptorAllocator>,
+               LveSwapChain::MAX_FRAMES_IN_FLIGHT>
+        frame_descriptor_allocators_;
 
     uint32_t current_image_index_;
     int current_frame_index_ = 0;
     bool is_frame_started_   = false;
+
+    // the graphics timeline value the frame signals, frames count from 1
+    // and the deletion queue is keyed by them
+    uint64_t frame_number_ = 0;
+    // the last frame recorded with each frame slot's resources
+    std::array<uint64_t, LveSwapChain::MAX_FRAMES_IN_FLIGHT> slot_frames_{};
+
+    // a start and end timestamp per frame slot, VK_NULL_HANDLE when the
+    // graphics queue can't write them
+    VkQueryPool timestamp_pool_ = VK_NULL_HANDLE;
+    std::optional<double> gpu_frame_ms_;
+    VkExtent2D render_extent_{};
+    // 0 unless the frame waits for the transfer timeline
+    uint64_t transfer_wait_value_ = 0;
+
+    std::chrono::steady_clock::time_point input_time_;
+    std::deque<PresentedFrame> presented_frames_;
+    FrameStats::Latency latency_{};
 };
 } // namespace lve
 
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <tutorial/frame_stats.hpp>
+#include <type_traits>
+#include <vulkan/vulkan.h>
+
+namespace lve
+{
+struct ResolutionScalerConfig
+{
+    // GPU time a frame may take, 0 renders at full resolution
+    double target_gpu_ms = 14.0;
+    // of the swap chain extent, along each axis
+    float min_scale = 0.5f;
+    float max_scale = 1.f;
+    // scales are multiples of it, so the extent changes in a few steps
+    // rather than by a pixel every frame
+    float scale_step = 0.05f;
+};
+
+// Picks the resolution the scene is rendered at from the GPU time of past
+// frames, dropping it when they go over the budget and raising it again a
+// step at a time once there is room. GPU time is taken to grow with the
+// pixel count, so the scale along each axis follows its square root.
+class LveResolutionScaler
+{
+  public:
+    // What one frame measured and decided
+    struct Sample
+    {
+        // nullopt while no measurement was available
+        std::optional<double> gpu_ms;
+        float scale;
+        FrameStats::Resolution::Decision decision;
+    };
+
+    explicit LveResolutionScaler(ResolutionScalerConfig config = {});
+
+    LveResolutionScaler(const LveResolutionScaler&) = delete;
+    LveResolutionScaler& operator=(const LveResolutionScaler&) = delete;
+
+    // Called once a frame with the GPU time of the latest frame that
+    // finished, returns the scale of the frame being recorded
+    float update(std::optional<double> gpu_ms);
+
+    // Whether the scale may change, false with a target_gpu_ms of 0
+    bool is_enabled() const
+    {
+        return config_.target_gpu_ms > 0.0;
+    }
+    float get_scale() const
+    {
+        return scale_;
+    }
+    // extent scaled and rounded to whole pixels, at least one
+    VkExtent2D scale_extent(VkExtent2D extent) const;
+    // The last HISTORY_LENGTH frames, oldest first
+    const std::deque<Sample>& get_history() const
+    {
+        return history_;
+    }
+    // The last update() of the frame, for FrameStats
+    FrameStats::Resolution get_stats(VkExtent2D full_extent) const;
+
+    static constexpr size_t HISTORY_LENGTH = 240;
+
+  private:
+    // measurements lag the scale they were rendered at by the frames in
+    // flight, a change waits this many frames before the next one down
+    static constexpr uint32_t FRAMES_BEFORE_DROP = 4;
+    // and this many before the next one up, so it doesn't oscillate
+    static constexpr uint32_t FRAMES_BEFORE_RAISE = 30;
+    // raised only while the time would stay under the budget afterwards
+    static constexpr double RAISE_HEADROOM = 0.85;
+    // weight of the latest measurement in the running average
+    static constexpr double SMOOTHING = 0.25;
+
+    float clamp_to_steps(float scale) const;
+
+    ResolutionScalerConfig config_;
+    float scale_                  = 1.f;
+    double average_gpu_ms_        = 0.0;
+    bool has_average_             = false;
+    uint32_t frames_since_change_ = 0;
+    std::deque<Sample> history_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveResolutionScaler>);
+static_assert(!std::is_copy_assignable_v<lve::LveResolutionScaler>);
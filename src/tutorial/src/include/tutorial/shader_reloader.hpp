@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tutorial/pipeline.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+// Watches the compiled shader directory and rebuilds the pipelines using a
+// changed shader on a background thread. Rebuilt pipelines are swapped in by
+// apply_reloads() at a frame boundary, the ones they replace are destroyed
+// once no frame in flight can still use them. Changes come from inotify on
+// Linux, elsewhere the directory is polled for new write times.
+class LveShaderReloader
+{
+  public:
+    using PipelineFactory = std::function<std::unique_ptr<LvePipeline>()>;
+
+    // longest the watcher thread blocks, also the quiet time it waits for
+    // before rebuilding so shaders written together are picked up together
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{100};
+
+    explicit LveShaderReloader(std::filesystem::path directory);
+    ~LveShaderReloader();
+
+    LveShaderReloader(const LveShaderReloader&) = delete;
+    LveShaderReloader& operator=(const LveShaderReloader&) = delete;
+
+    // Rebuilds *pipeline with factory whenever one of the shaders, named
+    // relative to the watched directory, is written. The factory runs on the
+    // watcher thread so everything it reads must stay unchanged while the
+    // pipeline is watched.
+    void watch(std::unique_ptr<LvePipeline>* pipeline,
+               const std::pmr::vector<std::filesystem::path>& shaders,
+               PipelineFactory factory);
+    // Waits for a rebuild in progress and drops one not swapped in yet
+    void unwatch(std::unique_ptr<LvePipeline>* pipeline);
+
+    // Call once per frame on the render thread after begin_frame() and
+    // before recording. Returns the number of pipelines swapped in.
+    uint32_t apply_reloads();
+
+  private:
+    struct Watch
+    {
+        std::unique_ptr<LvePipeline>* pipeline;
+        std::pmr::vector<std::string> shaders;
+        PipelineFactory factory;
+    };
+
+    struct Reload
+    {
+        std::unique_ptr<LvePipeline>* pipeline;
+        std::unique_ptr<LvePipeline> replacement;
+    };
+
+    void watcher_loop();
+    // Blocks for at most POLL_INTERVAL, returns the names of files written
+    // in the directory meanwhile
+    std::pmr::vector<std::string> wait_for_changes();
+    void rebuild(const std::pmr::vector<std::string>& changed);
+
+    std::filesystem::path directory_;
+
+    // held for a whole rebuild and by unwatch(), never by watch() or
+    // apply_reloads()
+    std::mutex rebuild_mutex_;
+    // only held to change or copy watches_
+    std::mutex watch_mutex_;
+    std::pmr::vector<Watch> watches_;
+    std::mutex reload_mutex_;
+    std::pmr::vector<Reload> reloads_;
+
+#ifdef __linux__
+    int inotify_fd_ = -1;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type>
+        write_times_;
+#endif
+    std::atomic<bool> stopping_{false};
+    std::thread watcher_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveShaderReloader>);
+static_assert(!std::is_copy_assignable_v<lve::LveShaderReloader>);
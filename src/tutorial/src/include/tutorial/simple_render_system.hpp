@@ -1,31 +1,161 @@
 #pragma once
 
+#include <array>
 #include <memory>
+#include <tutorial/bindless.hpp>
+#include <tutorial/buffer.hpp>
 #include <tutorial/camera.hpp>
+#include <tutorial/descriptors.hpp>
 #include <tutorial/device.hpp>
+#include <tutorial/draw_list.hpp>
+#include <tutorial/frame_info.hpp>
+#include <tutorial/frame_stats.hpp>
 #include <tutorial/game_object.hpp>
+#include <tutorial/job_system.hpp>
 #include <tutorial/model.hpp>
 #include <tutorial/pipeline.hpp>
+#include <tutorial/pipeline_layout_cache.hpp>
+#include <tutorial/pipeline_library_cache.hpp>
+#include <tutorial/pipeline_variants.hpp>
+#include <tutorial/renderer.hpp>
+#include <tutorial/shader_reloader.hpp>
+#include <tutorial/texture_streamer.hpp>
 #include <vector>
 namespace lve
 {
 class SimpleRenderSystem
 {
   public:
-    SimpleRenderSystem(LveDevice& device, VkRenderPass render_pass);
+    // Mirrors the specialization constants of the simple shaders
+    enum SpecializationConstant : uint32_t
+    {
+        // colors objects with LveGameObject::color instead of vertex colors
+        OBJECT_COLOR,
+        SPECIALIZATION_CONSTANT_COUNT
+    };
+
+    // With a bindless table object data is read from storage buffers
+    // registered in it, otherwise a uniform buffer set is allocated per frame
+    SimpleRenderSystem(LveDevice& device,
+                       const PipelineRenderTarget& render_target,
+                       const LveDescriptorSetLayout& global_set_layout,
+                       LveDescriptorLayoutCache& layout_cache,
+                       LvePipelineLayoutCache& pipeline_layout_cache,
+                       LvePipelineLibraryCache& pipeline_library_cache,
+                       LveBindlessTable* bindless_table = nullptr);
     ~SimpleRenderSystem();
 
-    void render_game_objects(VkCommandBuffer command_buffer,
-                             std::pmr::vector<LveGameObject>& game_objects,
-                             const LveCamera& camera);
+    // Rebuilds the pipeline when its shaders change, the reloader must
+    // outlive this render system
+    void watch_shaders(LveShaderReloader& shader_reloader);
+
+    // Selects the pipeline variant rendered with from the next call on, a
+    // variant is created the first time its values are used
+    void set_specialization_constant(SpecializationConstant constant,
+                                     uint32_t value);
+
+    // Cull mode, front face, topology and depth test of the draws from the
+    // next call on. Without extended dynamic state each combination is a
+    // pipeline variant of its own.
+    void set_raster_state(const PipelineRasterState& state)
+    {
+        raster_state_ = state;
+    }
+
+    // Textures of the objects drawn from the next call on. Only the bindless
+    // shaders sample them, once their mip tail is resident.
+    void set_texture_streamer(const LveTextureStreamer* texture_streamer)
+    {
+        texture_streamer_ = texture_streamer;
+    }
+
+    size_t get_pipeline_variant_count() const
+    {
+        return pipeline_variants_.size();
+    }
+
+    void render_game_objects(const FrameInfo& frame_info,
+                             std::pmr::vector<LveGameObject>& game_objects);
+
+    // Sorts the visible objects into a draw list, records ranges of it into
+    // secondary command buffers on the job system and stitches them into the
+    // render pass or dynamic rendering begun on the frame command buffer
+    // for secondary command buffer contents.
+    void render_game_objects_parallel(
+        LveRenderer& renderer,
+        JobSystem& job_system,
+        const FrameInfo& frame_info,
+        std::pmr::vector<LveGameObject>& game_objects,
+        const std::pmr::vector<uint32_t>& visible,
+        FrameStats& stats);
+
+    // Smallest number of objects worth a secondary command buffer of its own
+    static constexpr size_t MIN_OBJECTS_PER_RECORDING_THREAD = 256;
+    // Objects the per frame object buffers start with, they grow on demand
+    static constexpr uint32_t INITIAL_OBJECT_CAPACITY = 1024;
 
   private:
-    void create_pipeline_layout();
-    void create_pipeline(VkRenderPass render_pass);
+    // Reflects the embedded shaders, the layout is owned by the cache
+    void create_pipeline_layout(
+        const LveDescriptorSetLayout& global_set_layout,
+        LvePipelineLayoutCache& pipeline_layout_cache);
+    void create_pipeline(const PipelineRenderTarget& render_target);
+    std::unique_ptr<LvePipeline> create_pipeline_variant(
+        std::span<const uint32_t> specialization_constants,
+        uint32_t baked_state,
+        bool from_files);
+    // The variant for the current constants and raster state
+    LvePipeline& get_pipeline();
+    void create_object_buffers();
+    // Makes room for count objects in the buffer of the given frame, a grown
+    // buffer replaces the old one in the bindless table
+    void reserve_objects(int frame_index, uint32_t count);
+    // Points set 1 at the frame's object buffer for the non bindless path
+    void write_object_set(const FrameInfo& frame_info);
+    void sort_draws(JobSystem* job_system,
+                    std::pmr::vector<LveGameObject>& game_objects,
+                    const std::pmr::vector<uint32_t>& visible,
+                    const glm::mat4& projection_view,
+                    FrameStats& stats);
+    uint64_t make_draw_key(LveGameObject& game_object,
+                           const glm::mat4& projection_view) const;
+    // Records draws [begin, end) of the draw list, per object data goes to
+    // the same slots of the frame's object buffer. Returns the number of
+    // pipeline and vertex buffer binds recorded.
+    uint32_t record_game_objects(VkCommandBuffer command_buffer,
+                                 const FrameInfo& frame_info,
+                                 std::pmr::vector<LveGameObject>& game_objects,
+                                 size_t begin,
+                                 size_t end);
 
     LveDevice& device_;
-    std::unique_ptr<LvePipeline> pipeline_;
+    LveDynamicState dynamic_state_;
+    // kept for creating variants and rebuilding them on reloads
+    PipelineRenderTarget render_target_{};
+    LvePipelineLibraryCache& pipeline_library_cache_;
+    std::filesystem::path vertex_shader_path_;
+    std::filesystem::path fragment_shader_path_;
+    LvePipelineVariants pipeline_variants_;
+    std::array<uint32_t, SPECIALIZATION_CONSTANT_COUNT>
+        specialization_constants_{};
+    PipelineRasterState raster_state_{};
+    // variant of the current frame, picked before its draws are sorted
+    LvePipeline* pipeline_ = nullptr;
     VkPipelineLayout pipeline_layout_;
+    DrawList draw_list_;
+
+    // per object data in one buffer per frame in flight. Bindless draws find
+    // it through a push constant holding the buffer's table index and their
+    // first instance, otherwise a transient set is bound with a dynamic
+    // offset per draw.
+    LveBindlessTable* bindless_table_;
+    std::array<std::unique_ptr<LveBuffer>, LveSwapChain::MAX_FRAMES_IN_FLIGHT>
+        object_buffers_;
+    std::array<uint32_t, LveSwapChain::MAX_FRAMES_IN_FLIGHT>
+        object_buffer_indices_{};
+    std::unique_ptr<LveDescriptorSetLayout> object_set_layout_;
+    VkDescriptorSet object_descriptor_set_ = VK_NULL_HANDLE;
+    const LveTextureStreamer* texture_streamer_ = nullptr;
 };
 } // namespace lve
 
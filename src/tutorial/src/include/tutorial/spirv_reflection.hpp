@@ -0,0 +1,46 @@
+#pragma once
+
+#include <span>
+#include <tutorial/device.hpp>
+#include <vector>
+
+namespace lve
+{
+// The interface of a shader as far as pipeline creation cares, read from
+// its SPIR-V
+struct ShaderReflection
+{
+    struct Binding
+    {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        // 0 for runtime sized arrays
+        uint32_t count;
+    };
+
+    struct Input
+    {
+        uint32_t location;
+        VkFormat format;
+    };
+
+    VkShaderStageFlagBits stage;
+    // ordered by set, then binding
+    std::pmr::vector<Binding> bindings;
+    // bytes of the push constant block, 0 without one
+    uint32_t push_constant_size = 0;
+    // user defined inputs ordered by location, builtins are left out
+    std::pmr::vector<Input> inputs;
+};
+
+// Reflects the first entry point of the module. Throws std::runtime_error
+// for malformed SPIR-V and for interface types it can't map to Vulkan.
+ShaderReflection reflect_shader(std::span<const uint32_t> code);
+
+// Throws std::runtime_error naming the first vertex shader input that no
+// attribute feeds with the same format
+void check_vertex_inputs(
+    const ShaderReflection& vertex_shader,
+    std::span<const VkVertexInputAttributeDescription> attributes);
+} // namespace lve
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <tutorial/buffer.hpp>
+#include <tutorial/device.hpp>
+
+namespace lve
+{
+// Persistently mapped host visible buffer handed out in FIFO order. Space is
+// given back by releasing every allocation up to the end of a later one,
+// which fits uploads retired in the order they were submitted.
+class LveStagingRing
+{
+  public:
+    struct Allocation
+    {
+        VkDeviceSize offset;
+        // pass to release() once the GPU has consumed the allocation
+        VkDeviceSize end;
+        std::byte* data;
+    };
+
+    LveStagingRing(LveDevice& device, VkDeviceSize size);
+
+    LveStagingRing(const LveStagingRing&) = delete;
+    LveStagingRing& operator=(const LveStagingRing&) = delete;
+
+    // Empty when the ring has no contiguous room for size bytes
+    std::optional<Allocation> allocate(VkDeviceSize size,
+                                       VkDeviceSize alignment);
+    void release(VkDeviceSize end);
+
+    VkBuffer get_buffer() const
+    {
+        return buffer_.get_buffer();
+    }
+
+    VkDeviceSize size() const
+    {
+        return buffer_.get_buffer_size();
+    }
+
+    VkDeviceSize used() const
+    {
+        return head_ - tail_;
+    }
+
+  private:
+    LveBuffer buffer_;
+    // running byte counts, offsets into the buffer are taken modulo size()
+    VkDeviceSize head_ = 0;
+    VkDeviceSize tail_ = 0;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveStagingRing>);
+static_assert(!std::is_copy_assignable_v<lve::LveStagingRing>);
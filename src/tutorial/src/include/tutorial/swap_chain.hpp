@@ -7,34 +7,63 @@
 
 // std lib headers
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
 namespace lve
 {
 
+// How frames are queued for presentation, applied when a swap chain is
+// created
+struct SwapChainConfig
+{
+    // the first of these the surface supports is used, FIFO when none is
+    std::pmr::vector<VkPresentModeKHR> presentModes{
+        VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    // 0 for one more than the surface minimum, clamped to the surface limits
+    uint32_t imageCount = 0;
+    // frames recorded while earlier ones are still on the GPU, 0 for
+    // LveSwapChain::MAX_FRAMES_IN_FLIGHT
+    uint32_t framesInFlight = 0;
+    // wait for the GPU to release a frame before its input is read rather
+    // than right before recording, so the input is as recent as possible
+    bool lowLatency = false;
+};
+
+const char* presentModeName(VkPresentModeKHR presentMode);
+
 class LveSwapChain
 {
   public:
     static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-    LveSwapChain(LveDevice& deviceRef, VkExtent2D windowExtent);
     LveSwapChain(LveDevice& deviceRef,
                  VkExtent2D windowExtent,
+                 const SwapChainConfig& config);
+    // Replaces previous, which may still be rendering. It continues with the
+    // frame slot previous would have used next.
+    LveSwapChain(LveDevice& deviceRef,
+                 VkExtent2D windowExtent,
+                 const SwapChainConfig& config,
                  std::shared_ptr<LveSwapChain> previous);
     ~LveSwapChain();
 
     LveSwapChain(const LveSwapChain&) = delete;
     void operator=(const LveSwapChain&) = delete;
 
-    VkFramebuffer getFrameBuffer(int index)
-    {
-        return swapChainFramebuffers[index];
-    }
+    // Color and depth attachment in the swap chain and depth formats.
+    // Pipelines and secondary command buffers are created against it, the
+    // render graph's passes drawing to the swap chain use compatible ones.
+    // VK_NULL_HANDLE when the device renders dynamically.
     VkRenderPass getRenderPass()
     {
         return renderPass;
     }
+    VkImage getImage(int index)
+    {
+        return swapChainImages[index];
+    }
     VkImageView getImageView(int index)
     {
         return swapChainImageViews[index];
@@ -66,10 +95,53 @@ class LveSwapChain
                static_cast<float>(swapChainExtent.height);
     }
     VkFormat findDepthFormat();
+    VkFormat getDepthFormat() const
+    {
+        return swap_chain_depth_format_;
+    }
+    // The depth format when it has a stencil aspect
+    VkFormat getStencilFormat() const
+    {
+        return swap_chain_depth_format_ == VK_FORMAT_D32_SFLOAT
+                   ? VK_FORMAT_UNDEFINED
+                   : swap_chain_depth_format_;
+    }
+
+    uint32_t framesInFlight() const
+    {
+        return framesInFlight_;
+    }
+    VkPresentModeKHR presentMode() const
+    {
+        return presentMode_;
+    }
+    // Whether an image in the swap chain format can be blitted to the swap
+    // chain images with linear filtering
+    bool supportsUpscaling() const
+    {
+        return supportsUpscaling_;
+    }
 
+    // The caller waits for the frame submitted framesInFlight() frames ago
+    // first, whose semaphore this reuses
     VkResult acquireNextImage(uint32_t* imageIndex);
+    // Signals timelineValue on the device's graphics timeline when the
+    // buffers are done, then presents the image. Unless transferWaitValue is
+    // 0 their shaders first wait for the device's transfer timeline to
+    // reach it.
     VkResult submitCommandBuffers(const VkCommandBuffer* buffers,
-                                  uint32_t* imageIndex);
+                                  uint32_t* imageIndex,
+                                  uint64_t timelineValue,
+                                  uint64_t transferWaitValue = 0);
+
+    // Id of the last present, 0 unless the device supports present wait
+    uint64_t lastPresentId() const
+    {
+        return presentId_;
+    }
+    // Whether the present with the given id reached the screen, waiting
+    // up to timeout nanoseconds for it
+    bool waitForPresent(uint64_t presentId, uint64_t timeout);
     bool compare_swap_formats(const LveSwapChain& swap_chain) const
     {
         return swap_chain.swap_chain_depth_format_ ==
@@ -81,9 +153,7 @@ class LveSwapChain
     void init();
     void createSwapChain();
     void createImageViews();
-    void createDepthResources();
     void createRenderPass();
-    void createFramebuffers();
     void createSyncObjects();
 
     // Helper functions
@@ -93,16 +163,19 @@ class LveSwapChain
         const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
+    SwapChainConfig config_;
+    uint32_t framesInFlight_;
+    VkPresentModeKHR presentMode_;
+    bool supportsUpscaling_ = false;
+    PFN_vkWaitForPresentKHR waitForPresent_ = nullptr;
+    uint64_t presentId_                     = 0;
+
     VkFormat swapChainImageFormat;
     VkFormat swap_chain_depth_format_;
     VkExtent2D swapChainExtent;
 
-    std::vector<VkFramebuffer> swapChainFramebuffers;
     VkRenderPass renderPass;
 
-    std::vector<VkImage> depthImages;
-    std::vector<VkDeviceMemory> depthImageMemorys;
-    std::vector<VkImageView> depthImageViews;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
 
@@ -110,12 +183,13 @@ class LveSwapChain
     VkExtent2D windowExtent;
 
     VkSwapchainKHR swapChain;
+    // only set while this swap chain is created from it
     std::shared_ptr<LveSwapChain> old_swap_chain_;
 
+    // by frame slot
     std::vector<VkSemaphore> imageAvailableSemaphores;
+    // by image
     std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
-    std::vector<VkFence> imagesInFlight;
     size_t currentFrame = 0;
 };
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vulkan/vulkan.h>
+
+namespace lve
+{
+using TextureId = uint32_t;
+constexpr TextureId INVALID_TEXTURE_ID = std::numeric_limits<TextureId>::max();
+
+// Mip chain of a 2D texture that can be read one level at a time, level 0
+// being the largest
+class TextureSource
+{
+  public:
+    virtual ~TextureSource() = default;
+
+    virtual VkFormat format() const = 0;
+    virtual VkExtent2D extent() const = 0;
+    virtual uint32_t mip_levels() const = 0;
+    // Bytes of the level laid out as vkCmdCopyBufferToImage reads it with
+    // bufferRowLength and bufferImageHeight left at 0
+    virtual size_t level_size(uint32_t level) const = 0;
+    // Writes level_size(level) bytes, called from the streaming thread.
+    // Throws std::runtime_error when the data cannot be read.
+    virtual void load_level(uint32_t level,
+                            std::span<std::byte> destination) const = 0;
+
+    VkExtent2D level_extent(uint32_t level) const
+    {
+        const auto base = extent();
+        return {std::max(base.width >> level, 1u),
+                std::max(base.height >> level, 1u)};
+    }
+};
+
+// BC formats can only be sampled with the textureCompressionBC feature
+inline bool is_bc_compressed(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace lve
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tutorial/bindless.hpp>
+#include <tutorial/device.hpp>
+#include <tutorial/frame_stats.hpp>
+#include <tutorial/staging_ring.hpp>
+#include <tutorial/texture.hpp>
+#include <vector>
+
+namespace lve
+{
+struct TextureStreamerConfig
+{
+    // device memory the streamed images may take, least recently visible
+    // textures drop back to their mip tail when it is exceeded
+    VkDeviceSize memory_budget = VkDeviceSize{256} << 20;
+    VkDeviceSize staging_size  = VkDeviceSize{64} << 20;
+    // mip chains requested from the streaming thread per update
+    uint32_t max_requests_per_update = 4;
+};
+
+// Streams mip levels of 2D textures into device local images. A texture
+// first gets its mip tail, then one finer level per request while it is
+// visible and asks for more detail. Levels are read on a streaming thread
+// straight into a staging ring and copied on the transfer queue, a finished
+// copy swaps the texture's image and the old one is destroyed once no frame
+// in flight can read it.
+class LveTextureStreamer
+{
+  public:
+    // levels no larger than this are loaded together as the mip tail
+    static constexpr uint32_t TAIL_EXTENT           = 64;
+    static constexpr uint32_t MAX_BATCHES_IN_FLIGHT = 4;
+
+    LveTextureStreamer(LveDevice& device,
+                       LveBindlessTable* bindless_table,
+                       const TextureStreamerConfig& config = {});
+    ~LveTextureStreamer();
+
+    LveTextureStreamer(const LveTextureStreamer&) = delete;
+    LveTextureStreamer& operator=(const LveTextureStreamer&) = delete;
+
+    // Not safe to call while mark_visible() runs on other threads. Throws
+    // std::runtime_error for formats the device cannot sample.
+    TextureId add_texture(std::shared_ptr<const TextureSource> source);
+
+    // Records that the texture is seen covering about screen_pixels along its
+    // larger side this frame, which picks the finest level it needs. Safe to
+    // call from several threads.
+    void mark_visible(TextureId texture, float screen_pixels);
+
+    // Call once per frame on the render thread: retires finished uploads,
+    // evicts over budget and issues new requests
+    void update(FrameStats::Streaming& stats);
+
+    // VK_NULL_HANDLE until the mip tail is resident
+    VkImageView get_image_view(TextureId texture) const;
+    // Index in the bindless image array, INVALID_SLOT until the mip tail is
+    // resident or without a bindless table
+    uint32_t get_bindless_index(TextureId texture) const;
+
+    VkSampler get_sampler() const
+    {
+        return sampler_;
+    }
+
+    // The transfer timeline value of the last upload textures were switched
+    // to. Frames sampling them wait for it on the GPU, which makes the
+    // copies visible to their shaders.
+    uint64_t get_transfer_wait_value() const
+    {
+        return transfer_wait_value_;
+    }
+
+    static constexpr uint32_t INVALID_SLOT = ~0u;
+
+  private:
+    struct Image
+    {
+        VkImage image          = VK_NULL_HANDLE;
+        VkDeviceMemory memory  = VK_NULL_HANDLE;
+        VkImageView view       = VK_NULL_HANDLE;
+        VkDeviceSize bytes     = 0;
+        uint32_t bindless_slot = INVALID_SLOT;
+    };
+
+    struct Texture
+    {
+        std::shared_ptr<const TextureSource> source;
+        uint32_t mip_levels;
+        // first level of the mip tail
+        uint32_t tail_level;
+        // finest first level whose chain fits the staging ring
+        uint32_t finest_level;
+        // first resident level, mip_levels while nothing is
+        uint32_t resident_level;
+        // first level of a chain being loaded, mip_levels when none is
+        uint32_t pending_level;
+        bool failed = false;
+        Image image{};
+        std::atomic<uint64_t> last_visible_frame{0};
+        // finest level asked for since the last update
+        std::atomic<uint32_t> wanted_level;
+    };
+
+    struct Request
+    {
+        TextureId texture;
+        // held here so the streaming thread never touches textures_
+        std::shared_ptr<const TextureSource> source;
+        uint32_t first_level;
+        LveStagingRing::Allocation staging;
+        // offsets into the allocation, one per level from first_level
+        std::pmr::vector<VkDeviceSize> level_offsets;
+        bool failed = false;
+    };
+
+    // image taking over a texture once its batch completes
+    struct Swap
+    {
+        TextureId texture;
+        uint32_t first_level;
+        Image image;
+    };
+
+    struct Batch
+    {
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkDeviceSize staging_end       = 0;
+        bool recording                 = false;
+        bool submitted                 = false;
+        // the transfer timeline value the batch signals, batches retire
+        // oldest first
+        uint64_t sequence = 0;
+        std::pmr::vector<Swap> swaps;
+    };
+
+    struct RetiredImage
+    {
+        Image image;
+        // graphics timeline value after which nothing samples the image
+        uint64_t frame;
+    };
+
+    void loader_loop();
+    void retire_batches(FrameStats::Streaming& stats);
+    void destroy_retired_images();
+    void record_loaded_requests(FrameStats::Streaming& stats);
+    void issue_requests(FrameStats::Streaming& stats);
+    bool request_chain(TextureId texture, uint32_t first_level);
+    bool evict_least_recently_visible(FrameStats::Streaming& stats);
+    Batch* recording_batch();
+    void submit_batch();
+    Image create_image(const Texture& texture, uint32_t first_level);
+    void destroy_image(Image& image);
+    VkDeviceSize chain_size(const Texture& texture, uint32_t first_level) const;
+
+    LveDevice& device_;
+    LveBindlessTable* bindless_table_;
+    TextureStreamerConfig config_;
+    LveStagingRing staging_ring_;
+    VkSampler sampler_          = VK_NULL_HANDLE;
+    VkCommandPool command_pool_ = VK_NULL_HANDLE;
+    std::array<uint32_t, 2> queue_families_{};
+    std::array<Batch, MAX_BATCHES_IN_FLIGHT> batches_{};
+    size_t next_batch_            = 0;
+    uint64_t transfer_wait_value_ = 0;
+
+    // deque keeps textures in place while new ones are added
+    std::deque<Texture> textures_;
+    std::pmr::vector<RetiredImage> retired_;
+    std::atomic<uint64_t> frame_{1};
+    // chain sizes of resident and pending levels, compared to the budget
+    VkDeviceSize projected_bytes_ = 0;
+    VkDeviceSize resident_bytes_  = 0;
+
+    std::mutex loader_mutex_;
+    std::condition_variable loader_wakeup_;
+    std::deque<Request> load_queue_;
+    std::deque<Request> loaded_;
+    bool stopping_ = false;
+    std::thread loader_;
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveTextureStreamer>);
+static_assert(!std::is_copy_assignable_v<lve::LveTextureStreamer>);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vulkan/vulkan.h>
+
+namespace lve
+{
+// Timeline semaphore signalled by the submissions to one queue, each with
+// a larger value than the one before. Whether submission n finished is a
+// comparison against the counter, without a fence per submission.
+class LveTimeline
+{
+  public:
+    explicit LveTimeline(VkDevice device);
+    ~LveTimeline();
+
+    LveTimeline(const LveTimeline&) = delete;
+    LveTimeline& operator=(const LveTimeline&) = delete;
+
+    VkSemaphore get_semaphore() const
+    {
+        return semaphore_;
+    }
+
+    // The value for the next submission to signal. Submissions to the
+    // queue are made in the order their values were handed out.
+    uint64_t next_value()
+    {
+        return ++last_value_;
+    }
+    uint64_t last_value() const
+    {
+        return last_value_;
+    }
+
+    // Every submission up to this value has finished
+    uint64_t completed_value() const;
+    bool is_complete(uint64_t value) const
+    {
+        return value <= completed_value();
+    }
+    // Returns false when timeout nanoseconds passed first
+    bool wait(uint64_t value, uint64_t timeout = UINT64_MAX) const;
+
+  private:
+    VkDevice device_;
+    VkSemaphore semaphore_ = VK_NULL_HANDLE;
+    std::atomic<uint64_t> last_value_{0};
+};
+} // namespace lve
+
+static_assert(!std::is_copy_constructible_v<lve::LveTimeline>);
+static_assert(!std::is_copy_assignable_v<lve::LveTimeline>);
@@ -20,6 +20,16 @@ class LveWindow
         return glfwWindowShouldClose(window_.get());
     }
 
+    void close()
+    {
+        glfwSetWindowShouldClose(window_.get(), GLFW_TRUE);
+    }
+    // The framebuffer follows once the window system applied it
+    void set_size(int width, int height)
+    {
+        glfwSetWindowSize(window_.get(), width, height);
+    }
+
     void create_window_surface(VkInstance instance, VkSurfaceKHR* surface);
     VkExtent2D get_extent()
     {
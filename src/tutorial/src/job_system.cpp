@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <atomic>
+#include <tutorial/job_system.hpp>
+
+namespace lve
+{
+JobSystem::JobSystem(uint32_t worker_count)
+{
+    if (worker_count == 0)
+    {
+        worker_count =
+            std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    workers_.reserve(worker_count);
+    for (uint32_t i = 0; i < worker_count; ++i)
+    {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::scoped_lock lock{mutex_};
+        stopping_ = true;
+    }
+    job_available_.notify_all();
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::worker_loop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock{mutex_};
+            job_available_.wait(lock,
+                                [this] { return stopping_ || !jobs_.empty(); });
+            if (stopping_ && jobs_.empty())
+            {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop();
+        }
+        job();
+    }
+}
+
+bool JobSystem::try_run_pending_job()
+{
+    std::function<void()> job;
+    {
+        std::scoped_lock lock{mutex_};
+        if (jobs_.empty())
+        {
+            return false;
+        }
+        job = std::move(jobs_.front());
+        jobs_.pop();
+    }
+    job();
+    return true;
+}
+
+void JobSystem::parallel_for(size_t count,
+                             size_t min_range,
+                             uint32_t max_ranges,
+                             const range_job& job)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    min_range              = std::max<size_t>(min_range, 1);
+    const size_t by_size   = (count + min_range - 1) / min_range;
+    const size_t by_thread = std::min(max_ranges, thread_count());
+    const size_t ranges    = std::max<size_t>(std::min(by_size, by_thread), 1);
+    if (ranges == 1)
+    {
+        job(0, count, 0);
+        return;
+    }
+
+    const size_t range_size = (count + ranges - 1) / ranges;
+    std::atomic<size_t> remaining{ranges - 1};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto run_range = [&](size_t index) {
+        const size_t begin = index * range_size;
+        const size_t end   = std::min(begin + range_size, count);
+        try
+        {
+            if (begin < end)
+            {
+                job(begin, end, static_cast<uint32_t>(index));
+            }
+        }
+        catch (...)
+        {
+            std::scoped_lock lock{error_mutex};
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    {
+        std::scoped_lock lock{mutex_};
+        for (size_t index = 1; index < ranges; ++index)
+        {
+            jobs_.push([&, index] {
+                run_range(index);
+                if (remaining.fetch_sub(1) == 1)
+                {
+                    std::scoped_lock done_lock{mutex_};
+                    job_done_.notify_all();
+                }
+            });
+        }
+    }
+    job_available_.notify_all();
+
+    run_range(0);
+    while (remaining.load() != 0 && try_run_pending_job())
+    {
+    }
+    {
+        std::unique_lock lock{mutex_};
+        job_done_.wait(lock, [&] { return remaining.load() == 0; });
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+} // namespace lve
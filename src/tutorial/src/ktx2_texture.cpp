@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <fmt/format.h>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tutorial/ktx2_texture.hpp>
+
+namespace lve
+{
+namespace
+{
+constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER{
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// Fields following the identifier, all little endian. The supercompression
+// global data offset and length follow as two 64-bit values.
+struct Ktx2Header
+{
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+};
+static_assert(sizeof(Ktx2Header) == 52);
+
+constexpr size_t LEVEL_INDEX_OFFSET = 80;
+
+struct Ktx2LevelIndex
+{
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+static_assert(sizeof(Ktx2LevelIndex) == 24);
+
+struct BlockInfo
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytes;
+};
+
+std::optional<BlockInfo> block_info(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return BlockInfo{4, 4, 8};
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return BlockInfo{4, 4, 16};
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return BlockInfo{1, 1, 4};
+    case VK_FORMAT_R8G8_UNORM:
+        return BlockInfo{1, 1, 2};
+    case VK_FORMAT_R8_UNORM:
+        return BlockInfo{1, 1, 1};
+    default:
+        return std::nullopt;
+    }
+}
+
+template <typename T>
+T read(const file::mapped_file& file, size_t offset)
+{
+    T value;
+    std::memcpy(&value, file.data() + offset, sizeof(T));
+    return value;
+}
+} // namespace
+
+Ktx2Texture::Ktx2Texture(const std::filesystem::path& file_path)
+    : file_{file_path}
+{
+    auto fail = [&](std::string_view reason) {
+        return std::runtime_error(fmt::format(
+            "Failed to load KTX2 texture {}: {}", file_path.string(), reason));
+    };
+
+    if (file_.size() < LEVEL_INDEX_OFFSET ||
+        std::memcmp(file_.data(),
+                    KTX2_IDENTIFIER.data(),
+                    KTX2_IDENTIFIER.size()) != 0)
+    {
+        throw fail("not a KTX2 file");
+    }
+    const auto header = read<Ktx2Header>(file_, KTX2_IDENTIFIER.size());
+
+    format_          = static_cast<VkFormat>(header.vk_format);
+    const auto block = block_info(format_);
+    if (!block)
+    {
+        throw fail(fmt::format("unsupported format {}", header.vk_format));
+    }
+    if (header.supercompression_scheme != 0)
+    {
+        throw fail("supercompressed data would need transcoding");
+    }
+    if (header.pixel_width == 0 || header.pixel_height == 0 ||
+        header.pixel_depth > 1 || header.layer_count > 1 ||
+        header.face_count != 1)
+    {
+        throw fail("only single layer 2D textures are supported");
+    }
+    // a level count of 0 asks the loader to generate mips, which would mean
+    // processing the image on the CPU
+    if (header.level_count == 0)
+    {
+        throw fail("mip chain is not stored in the file");
+    }
+    extent_ = {header.pixel_width, header.pixel_height};
+    if (header.level_count > std::bit_width(std::max(extent_.width,
+                                                     extent_.height)))
+    {
+        throw fail("more levels than the extent allows");
+    }
+
+    const auto index_end =
+        LEVEL_INDEX_OFFSET + header.level_count * sizeof(Ktx2LevelIndex);
+    if (file_.size() < index_end)
+    {
+        throw fail("truncated level index");
+    }
+    levels_.reserve(header.level_count);
+    for (uint32_t level = 0; level < header.level_count; ++level)
+    {
+        const auto index = read<Ktx2LevelIndex>(
+            file_, LEVEL_INDEX_OFFSET + level * sizeof(Ktx2LevelIndex));
+        const auto extent = level_extent(level);
+        const uint64_t expected =
+            uint64_t{(extent.width + block->width - 1) / block->width} *
+            ((extent.height + block->height - 1) / block->height) *
+            block->bytes;
+        if (index.byte_length != expected ||
+            index.uncompressed_byte_length != expected)
+        {
+            throw fail(fmt::format("level {} holds {} bytes, expected {}",
+                                   level,
+                                   index.byte_length,
+                                   expected));
+        }
+        if (index.byte_offset < index_end ||
+            index.byte_offset > file_.size() ||
+            file_.size() - index.byte_offset < index.byte_length)
+        {
+            throw fail(fmt::format("level {} lies outside the file", level));
+        }
+        levels_.push_back({index.byte_offset, index.byte_length});
+    }
+}
+
+void Ktx2Texture::load_level(uint32_t level,
+                             std::span<std::byte> destination) const
+{
+    assert(level < levels_.size() && "Level out of range");
+    const auto& entry = levels_[level];
+    assert(destination.size() >= entry.size && "Destination too small");
+    // the first touch of these pages reads them from disk
+    std::memcpy(destination.data(),
+                file_.data() + entry.offset,
+                static_cast<size_t>(entry.size));
+}
+} // namespace lve
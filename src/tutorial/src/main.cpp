@@ -1,11 +1,136 @@
+#include <algorithm>
 #include <cstdlib>
 #include <fmt/format.h>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tutorial/app.hpp>
 
-int main()
+namespace
 {
-    lve::FirstApp app{};
+constexpr std::string_view USAGE =
+    "usage: {} [--present-modes <mode>[,<mode>...]] [--images <count>]\n"
+    "          [--frames-in-flight <count>] [--low-latency] [--resize-test]\n"
+    "          [--gpu-budget <ms>] [--record-threads <count>[,<count>...]]\n"
+    "          [--objects <count>] [--texture <file.ktx2>]\n"
+    "modes in order of preference: immediate, mailbox, fifo, fifo-relaxed\n"
+    "the scene is rendered at a lower resolution when the GPU takes longer\n"
+    "than the budget, 0 keeps it at full resolution\n"
+    "draws are recorded with each of the thread counts for a stats report,\n"
+    "then their record times are compared\n"
+    "--objects replaces the scene with a grid of that many cubes\n"
+    "--texture streams a KTX2 texture onto every object, texture-benchmark\n"
+    "writes one\n";
+
+VkPresentModeKHR parse_present_mode(std::string_view name)
+{
+    if (name == "immediate")
+    {
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+    if (name == "mailbox")
+    {
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    }
+    if (name == "fifo")
+    {
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+    if (name == "fifo-relaxed")
+    {
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    }
+    throw std::invalid_argument(fmt::format("Unknown present mode: {}", name));
+}
+
+lve::AppOptions parse_options(int argc, char** argv)
+{
+    lve::AppOptions options{};
+    auto& config = options.swap_chain;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--low-latency")
+        {
+            config.lowLatency = true;
+            continue;
+        }
+        if (arg == "--resize-test")
+        {
+            options.resize_test = true;
+            continue;
+        }
+        if (i + 1 == argc)
+        {
+            throw std::invalid_argument(fmt::format("Unknown option: {}", arg));
+        }
+        const std::string_view value = argv[++i];
+        if (arg == "--present-modes")
+        {
+            config.presentModes.clear();
+            for (size_t begin = 0; begin <= value.size();)
+            {
+                const auto end = std::min(value.find(',', begin), value.size());
+                config.presentModes.push_back(
+                    parse_present_mode(value.substr(begin, end - begin)));
+                begin = end + 1;
+            }
+        }
+        else if (arg == "--images")
+        {
+            config.imageCount = std::stoul(std::string{value});
+        }
+        else if (arg == "--frames-in-flight")
+        {
+            config.framesInFlight = std::stoul(std::string{value});
+        }
+        else if (arg == "--gpu-budget")
+        {
+            options.resolution.target_gpu_ms = std::stod(std::string{value});
+        }
+        else if (arg == "--record-threads")
+        {
+            options.record_threads.clear();
+            for (size_t begin = 0; begin <= value.size();)
+            {
+                const auto end = std::min(value.find(',', begin), value.size());
+                options.record_threads.push_back(static_cast<uint32_t>(
+                    std::stoul(std::string{value.substr(begin, end - begin)})));
+                begin = end + 1;
+            }
+        }
+        else if (arg == "--objects")
+        {
+            options.objects = std::stoul(std::string{value});
+        }
+        else if (arg == "--texture")
+        {
+            options.texture = value;
+        }
+        else
+        {
+            throw std::invalid_argument(fmt::format("Unknown option: {}", arg));
+        }
+    }
+    return options;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    lve::AppOptions options;
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        fmt::print(stderr, "{}\n", e.what());
+        fmt::print(stderr, USAGE, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    lve::FirstApp app{std::move(options)};
     try
     {
         app.run();
@@ -1,25 +1,39 @@
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <tutorial/model.hpp>
 
 namespace lve
 {
+namespace
+{
+std::atomic<uint32_t> next_model_id{0};
+} // namespace
+
 LveModel::LveModel(LveDevice& device, const std::pmr::vector<Vertex>& vertices)
-    : device_{device}
+    : device_{device}, id_{next_model_id++}
 {
     create_vertex_buffers(vertices);
 }
 
 LveModel::~LveModel()
 {
-    vkDestroyBuffer(device_.device(), vertex_buffer_, nullptr);
-    vkFreeMemory(device_.device(), vertex_buffer_memory_, nullptr);
+    device_.deletionQueue().push([device = device_.device(),
+                                  buffer = vertex_buffer_,
+                                  memory = vertex_buffer_memory_] {
+        vkDestroyBuffer(device, buffer, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+    });
 }
 
 void LveModel::create_vertex_buffers(const std::pmr::vector<Vertex>& vertices)
 {
     vertex_count_ = static_cast<uint32_t>(vertices.size());
     assert(vertex_count_ >= 3 && "Vertex count must be at least 3");
+    for (const auto& vertex : vertices)
+    {
+        bounds_.expand(vertex.position);
+    }
     VkDeviceSize buffer_size = sizeof(vertices.front()) * vertex_count_;
     device_.createBuffer(buffer_size,
                          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
@@ -42,9 +56,9 @@ void LveModel::bind(VkCommandBuffer command_buffer)
         command_buffer, 0, 1, buffers.data(), offsets.data());
 }
 
-void LveModel::draw(VkCommandBuffer command_buffer)
+void LveModel::draw(VkCommandBuffer command_buffer, uint32_t first_instance)
 {
-    vkCmdDraw(command_buffer, vertex_count_, 1, 0, 0);
+    vkCmdDraw(command_buffer, vertex_count_, 1, 0, first_instance);
 }
 
 std::pmr::vector<VkVertexInputBindingDescription> LveModel::Vertex::
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <tutorial/occlusion_culler.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LVE_OCCLUSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace lve
+{
+namespace
+{
+// Triangles closer than this to a zero area are not worth rasterizing
+constexpr float MIN_TRIANGLE_AREA = 1e-6f;
+// Tile rows rasterized by a single job
+constexpr size_t MIN_TILE_ROWS_PER_JOB = 2;
+// Depth a box must be behind the buffer by to be hidden, more than the
+// float error of the depth interpolated across an occluder's triangles
+constexpr float DEPTH_BIAS = 1e-5f;
+} // namespace
+
+OccluderMesh OccluderMesh::from_box(const BoundingBox& box)
+{
+    const auto& l = box.min;
+    const auto& h = box.max;
+    const std::array<glm::vec3, 8> corners{glm::vec3{l.x, l.y, l.z},
+                                           glm::vec3{h.x, l.y, l.z},
+                                           glm::vec3{h.x, h.y, l.z},
+                                           glm::vec3{l.x, h.y, l.z},
+                                           glm::vec3{l.x, l.y, h.z},
+                                           glm::vec3{h.x, l.y, h.z},
+                                           glm::vec3{h.x, h.y, h.z},
+                                           glm::vec3{l.x, h.y, h.z}};
+    // two triangles per face, winding does not matter to the rasterizer
+    constexpr std::array<uint32_t, 36> indices{
+        0, 1, 2, 0, 2, 3, // -z
+        4, 6, 5, 4, 7, 6, // +z
+        0, 4, 5, 0, 5, 1, // -y
+        3, 2, 6, 3, 6, 7, // +y
+        0, 3, 7, 0, 7, 4, // -x
+        1, 5, 6, 1, 6, 2  // +x
+    };
+    OccluderMesh mesh;
+    mesh.triangles.reserve(indices.size());
+    for (auto index : indices)
+    {
+        mesh.triangles.push_back(corners[index]);
+    }
+    return mesh;
+}
+
+OcclusionCuller::OcclusionCuller(JobSystem& job_system,
+                                 uint32_t width,
+                                 uint32_t height)
+    : job_system_{job_system}, width_{width}, height_{height},
+      tiles_x_{width / TILE_SIZE}, tiles_y_{height / TILE_SIZE},
+      depth_(size_t{width} * height, 1.f),
+      tile_depth_(size_t{tiles_x_} * tiles_y_, 1.f)
+{
+    assert(width % TILE_SIZE == 0 && height % TILE_SIZE == 0 &&
+           "Occlusion buffer size must be a multiple of the tile size");
+}
+
+void OcclusionCuller::begin_frame(const glm::mat4& projection_view)
+{
+    projection_view_ = projection_view;
+    triangles_.clear();
+    occluder_count_ = 0;
+}
+
+void OcclusionCuller::add_occluder(const OccluderMesh& mesh,
+                                   const glm::mat4& transform)
+{
+    assert(mesh.triangles.size() % 3 == 0 &&
+           "Occluder mesh must be a triangle list");
+    const auto clip_from_model = projection_view_ * transform;
+    ++occluder_count_;
+
+    for (size_t i = 0; i + 2 < mesh.triangles.size(); i += 3)
+    {
+        std::array<glm::vec3, 3> screen;
+        bool clipped = false;
+        for (size_t v = 0; v < 3; ++v)
+        {
+            const auto clip =
+                clip_from_model * glm::vec4{mesh.triangles[i + v], 1.f};
+            // dropping an occluder triangle is always safe, clipping it
+            // against the near plane is not worth it at this resolution
+            if (clip.w <= 0.f || clip.z < 0.f)
+            {
+                clipped = true;
+                break;
+            }
+            screen[v] = {(clip.x / clip.w * 0.5f + 0.5f) * width_,
+                         (clip.y / clip.w * 0.5f + 0.5f) * height_,
+                         clip.z / clip.w};
+        }
+        if (clipped)
+        {
+            continue;
+        }
+
+        auto edge = [&screen](size_t from, size_t to, glm::vec3 p) {
+            return (screen[to].x - screen[from].x) * (p.y - screen[from].y) -
+                   (screen[to].y - screen[from].y) * (p.x - screen[from].x);
+        };
+        float area = edge(0, 1, screen[2]);
+        if (std::abs(area) < MIN_TRIANGLE_AREA)
+        {
+            continue;
+        }
+        if (area < 0.f)
+        {
+            std::swap(screen[1], screen[2]);
+            area = -area;
+        }
+
+        const float min_x = std::min({screen[0].x, screen[1].x, screen[2].x});
+        const float min_y = std::min({screen[0].y, screen[1].y, screen[2].y});
+        const float max_x = std::max({screen[0].x, screen[1].x, screen[2].x});
+        const float max_y = std::max({screen[0].y, screen[1].y, screen[2].y});
+        if (max_x < 0.f || max_y < 0.f || min_x >= width_ || min_y >= height_)
+        {
+            continue;
+        }
+
+        // clamped as floats, vertices close to the camera plane land far
+        // outside what uint32_t holds
+        Triangle triangle{};
+        triangle.min_x = static_cast<uint32_t>(std::max(min_x, 0.f));
+        triangle.min_y = static_cast<uint32_t>(std::max(min_y, 0.f));
+        triangle.max_x = static_cast<uint32_t>(
+            std::min(std::ceil(max_x) + 1.f, static_cast<float>(width_)));
+        triangle.max_y = static_cast<uint32_t>(
+            std::min(std::ceil(max_y) + 1.f, static_cast<float>(height_)));
+
+        // edge k is opposite to vertex k, so it doubles as its barycentric
+        // weight once divided by the area
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const auto& from   = screen[(k + 1) % 3];
+            const auto& to     = screen[(k + 2) % 3];
+            triangle.edge_a[k] = from.y - to.y;
+            triangle.edge_b[k] = to.x - from.x;
+            triangle.edge_c[k] =
+                (to.y - from.y) * from.x - (to.x - from.x) * from.y;
+
+            const float weight = screen[k].z / area;
+            triangle.depth_a += triangle.edge_a[k] * weight;
+            triangle.depth_b += triangle.edge_b[k] * weight;
+            triangle.depth_c += triangle.edge_c[k] * weight;
+        }
+        triangles_.push_back(triangle);
+    }
+}
+
+void OcclusionCuller::rasterize()
+{
+    job_system_.parallel_for(
+        tiles_y_,
+        MIN_TILE_ROWS_PER_JOB,
+        [this](size_t begin, size_t end, uint32_t) {
+            const auto first_tile_row = static_cast<uint32_t>(begin);
+            const auto end_tile_row   = static_cast<uint32_t>(end);
+            rasterize_rows(first_tile_row * TILE_SIZE,
+                           end_tile_row * TILE_SIZE);
+            build_tiles(first_tile_row, end_tile_row);
+        });
+}
+
+void OcclusionCuller::rasterize_rows(uint32_t begin, uint32_t end)
+{
+    std::fill(depth_.begin() + size_t{begin} * width_,
+              depth_.begin() + size_t{end} * width_,
+              1.f);
+
+    for (const auto& triangle : triangles_)
+    {
+        const auto first_row = std::max(triangle.min_y, begin);
+        const auto end_row   = std::min(triangle.max_y, end);
+        // rows are processed four pixels at a time, the buffer width is a
+        // multiple of the tile size so a group never runs past the row
+        const auto first_column = triangle.min_x & ~3u;
+
+        for (auto y = first_row; y < end_row; ++y)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            float* row     = depth_.data() + size_t{y} * width_;
+#ifdef LVE_OCCLUSION_SSE2
+            __m128 edge_a[3];
+            __m128 edge_row[3];
+            for (size_t k = 0; k < 3; ++k)
+            {
+                edge_a[k]   = _mm_set1_ps(triangle.edge_a[k]);
+                edge_row[k] = _mm_set1_ps(triangle.edge_b[k] * py +
+                                          triangle.edge_c[k]);
+            }
+            const __m128 depth_a = _mm_set1_ps(triangle.depth_a);
+            const __m128 depth_row =
+                _mm_set1_ps(triangle.depth_b * py + triangle.depth_c);
+            const __m128 zero    = _mm_setzero_ps();
+            const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+            for (auto x = first_column; x < triangle.max_x; x += 4)
+            {
+                const __m128 px =
+                    _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                __m128 inside = _mm_cmpge_ps(
+                    _mm_add_ps(_mm_mul_ps(edge_a[0], px), edge_row[0]), zero);
+                inside = _mm_and_ps(
+                    inside,
+                    _mm_cmpge_ps(
+                        _mm_add_ps(_mm_mul_ps(edge_a[1], px), edge_row[1]),
+                        zero));
+                inside = _mm_and_ps(
+                    inside,
+                    _mm_cmpge_ps(
+                        _mm_add_ps(_mm_mul_ps(edge_a[2], px), edge_row[2]),
+                        zero));
+                if (_mm_movemask_ps(inside) == 0)
+                {
+                    continue;
+                }
+                const __m128 depth =
+                    _mm_add_ps(_mm_mul_ps(depth_a, px), depth_row);
+                const __m128 current = _mm_loadu_ps(row + x);
+                const __m128 nearest = _mm_min_ps(current, depth);
+                _mm_storeu_ps(row + x,
+                              _mm_or_ps(_mm_and_ps(inside, nearest),
+                                        _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (auto x = first_column; x < triangle.max_x; ++x)
+            {
+                const float px = static_cast<float>(x) + 0.5f;
+                bool inside    = true;
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    const float distance = triangle.edge_a[k] * px +
+                                           triangle.edge_b[k] * py +
+                                           triangle.edge_c[k];
+                    inside = inside && distance >= 0.f;
+                }
+                if (inside)
+                {
+                    const float depth = triangle.depth_a * px +
+                                        triangle.depth_b * py +
+                                        triangle.depth_c;
+                    row[x] = std::min(row[x], depth);
+                }
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::build_tiles(uint32_t begin, uint32_t end)
+{
+    for (auto tile_y = begin; tile_y < end; ++tile_y)
+    {
+        for (uint32_t tile_x = 0; tile_x < tiles_x_; ++tile_x)
+        {
+            const float* tile = depth_.data() +
+                                size_t{tile_y} * TILE_SIZE * width_ +
+                                size_t{tile_x} * TILE_SIZE;
+#ifdef LVE_OCCLUSION_SSE2
+            __m128 farthest = _mm_setzero_ps();
+            for (uint32_t y = 0; y < TILE_SIZE; ++y)
+            {
+                const float* row = tile + size_t{y} * width_;
+                for (uint32_t x = 0; x < TILE_SIZE; x += 4)
+                {
+                    farthest = _mm_max_ps(farthest, _mm_loadu_ps(row + x));
+                }
+            }
+            farthest = _mm_max_ps(
+                farthest,
+                _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+            farthest = _mm_max_ps(
+                farthest,
+                _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+            tile_depth_[size_t{tile_y} * tiles_x_ + tile_x] =
+                _mm_cvtss_f32(farthest);
+#else
+            float farthest = 0.f;
+            for (uint32_t y = 0; y < TILE_SIZE; ++y)
+            {
+                const float* row = tile + size_t{y} * width_;
+                farthest         = std::max(
+                    farthest, *std::max_element(row, row + TILE_SIZE));
+            }
+            tile_depth_[size_t{tile_y} * tiles_x_ + tile_x] = farthest;
+#endif
+        }
+    }
+}
+
+bool OcclusionCuller::is_visible(const BoundingBox& box) const
+{
+    if (triangles_.empty() || box.is_empty())
+    {
+        return true;
+    }
+
+    glm::vec2 screen_min{std::numeric_limits<float>::max()};
+    glm::vec2 screen_max{std::numeric_limits<float>::lowest()};
+    float nearest = std::numeric_limits<float>::max();
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec4 position{corner & 1 ? box.max.x : box.min.x,
+                                 corner & 2 ? box.max.y : box.min.y,
+                                 corner & 4 ? box.max.z : box.min.z,
+                                 1.f};
+        const auto clip = projection_view_ * position;
+        // boxes reaching in front of the near plane are never culled
+        if (clip.w <= 0.f || clip.z < 0.f)
+        {
+            return true;
+        }
+        const glm::vec2 screen{(clip.x / clip.w * 0.5f + 0.5f) * width_,
+                               (clip.y / clip.w * 0.5f + 0.5f) * height_};
+        screen_min = glm::min(screen_min, screen);
+        screen_max = glm::max(screen_max, screen);
+        nearest    = std::min(nearest, clip.z / clip.w);
+    }
+    nearest -= DEPTH_BIAS;
+    if (screen_max.x < 0.f || screen_max.y < 0.f || screen_min.x >= width_ ||
+        screen_min.y >= height_)
+    {
+        // off screen, left to the frustum test
+        return true;
+    }
+
+    // clamped as floats, corners close to the camera plane land far outside
+    // what uint32_t holds
+    const auto min_x = static_cast<uint32_t>(std::max(screen_min.x, 0.f));
+    const auto min_y = static_cast<uint32_t>(std::max(screen_min.y, 0.f));
+    const auto max_x = static_cast<uint32_t>(
+        std::min(std::ceil(screen_max.x), static_cast<float>(width_)));
+    const auto max_y = static_cast<uint32_t>(
+        std::min(std::ceil(screen_max.y), static_cast<float>(height_)));
+
+    for (auto tile_y = min_y / TILE_SIZE; tile_y * TILE_SIZE < max_y; ++tile_y)
+    {
+        for (auto tile_x = min_x / TILE_SIZE; tile_x * TILE_SIZE < max_x;
+             ++tile_x)
+        {
+            if (tile_depth_[size_t{tile_y} * tiles_x_ + tile_x] < nearest)
+            {
+                continue;
+            }
+            // the tile is not entirely in front of the box, look at the
+            // pixels the box actually covers
+            const auto begin_x = std::max(tile_x * TILE_SIZE, min_x);
+            const auto end_x   = std::min((tile_x + 1) * TILE_SIZE, max_x);
+            const auto begin_y = std::max(tile_y * TILE_SIZE, min_y);
+            const auto end_y   = std::min((tile_y + 1) * TILE_SIZE, max_y);
+            for (auto y = begin_y; y < end_y; ++y)
+            {
+                const float* row = depth_.data() + size_t{y} * width_;
+                for (auto x = begin_x; x < end_x; ++x)
+                {
+                    if (row[x] >= nearest)
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+} // namespace lve
@@ -1,71 +1,186 @@
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <file/io.hpp>
 #include <fmt/format.h>
 #include <tutorial/model.hpp>
 #include <tutorial/pipeline.hpp>
+#include <tutorial/spirv_reflection.hpp>
 
 namespace lve
 {
+namespace
+{
+std::atomic<uint32_t> next_pipeline_id{0};
+
+// in the order they are linked
+constexpr std::array<VkGraphicsPipelineLibraryFlagsEXT, 4> LIBRARY_PARTS{
+    VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT};
+
+// file::load hands out storage aligned for any scalar type
+std::span<const uint32_t> as_words(const std::pmr::vector<std::byte>& code)
+{
+    return {reinterpret_cast<const uint32_t*>(code.data()),
+            code.size() / sizeof(uint32_t)};
+}
+
+VkPipeline link_libraries(VkDevice device,
+                          std::span<const VkPipeline> libraries,
+                          VkPipelineLayout layout,
+                          bool optimize)
+{
+    const VkPipelineLibraryCreateInfoKHR library_info{
+        .sType        = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .libraryCount = static_cast<uint32_t>(libraries.size()),
+        .pLibraries   = libraries.data()};
+    const VkPipelineCreateFlags flags =
+        optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    const VkGraphicsPipelineCreateInfo pipeline_info{
+        .sType  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext  = &library_info,
+        .flags  = flags,
+        .layout = layout};
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(
+            device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to link graphics pipeline.");
+    }
+    return pipeline;
+}
+} // namespace
+
 LvePipeline::LvePipeline(LveDevice& device,
                          const std::filesystem::path& vertex_path,
                          const std::filesystem::path& fragment_path,
-                         const PipelineConfigInfo& config)
-    : device_{device}
+                         const PipelineConfigInfo& config,
+                         std::span<const uint32_t> specialization_constants)
+    : LvePipeline(device,
+                  as_words(file::load(vertex_path)),
+                  as_words(file::load(fragment_path)),
+                  config,
+                  specialization_constants)
 {
-    create_graphics_pipeline(vertex_path, fragment_path, config);
+}
+
+LvePipeline::LvePipeline(LveDevice& device,
+                         std::span<const uint32_t> vertex_code,
+                         std::span<const uint32_t> fragment_code,
+                         const PipelineConfigInfo& config,
+                         std::span<const uint32_t> specialization_constants)
+    : device_{device}, id_{next_pipeline_id++}
+{
+    try
+    {
+        create_graphics_pipeline(
+            vertex_code, fragment_code, config, specialization_constants);
+    }
+    catch (...)
+    {
+        // shaders being edited fail here routinely, don't leak their modules
+        vkDestroyShaderModule(device_.device(), vert_shader_module_, nullptr);
+        vkDestroyShaderModule(device_.device(), frag_shader_module_, nullptr);
+        throw;
+    }
 }
 
 LvePipeline::~LvePipeline()
 {
+    // the modules aren't needed once the pipeline exists
     vkDestroyShaderModule(device_.device(), vert_shader_module_, nullptr);
     vkDestroyShaderModule(device_.device(), frag_shader_module_, nullptr);
-    vkDestroyPipeline(device_.device(), graphics_pipeline_, nullptr);
+    // an optimised link queued or running sees this and drops its result,
+    // so there is nothing to wait for
+    std::lock_guard lock{linked_->mutex};
+    linked_->destroyed = true;
+    device_.deletionQueue().push([device   = device_.device(),
+                                  pipeline = linked_->pipeline.load()] {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    });
 }
 
 void LvePipeline::bind(VkCommandBuffer command_buffer)
 {
-    vkCmdBindPipeline(
-        command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline_);
+    vkCmdBindPipeline(command_buffer,
+                      VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      linked_->pipeline.load(std::memory_order_acquire));
 }
 
 void LvePipeline::create_graphics_pipeline(
-    const std::filesystem::path& vertex_path,
-    const std::filesystem::path& fragment_path,
-    const PipelineConfigInfo& config)
+    std::span<const uint32_t> vertex_code,
+    std::span<const uint32_t> fragment_code,
+    const PipelineConfigInfo& config,
+    std::span<const uint32_t> specialization_constants)
 {
     assert(config.pipeline_layout != VK_NULL_HANDLE &&
            "Cannot create graphics pipeline:: no pipelineLayout in config");
-    assert(config.render_pass != VK_NULL_HANDLE &&
-           "Cannot create graphics pipeline:: no renderPass in config");
-    auto vert_code = file::load(vertex_path);
-    auto frag_code = file::load(fragment_path);
+    assert((config.render_target.render_pass != VK_NULL_HANDLE ||
+            config.render_target.color_format != VK_FORMAT_UNDEFINED) &&
+           "Cannot create graphics pipeline:: no render target in config");
+    assert(!vertex_code.empty() && !fragment_code.empty() &&
+           "Cannot create graphics pipeline:: missing shader code");
+    // libraries are created from the code, which the cache keys them on,
+    // rather than from modules
+    const bool use_libraries = config.library_cache != nullptr &&
+                               device_.featureSupport().graphicsPipelineLibrary;
+    const std::array<VkShaderModuleCreateInfo, 2> module_infos{
+        {{.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+          .codeSize = vertex_code.size_bytes(),
+          .pCode    = vertex_code.data()},
+         {.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+          .codeSize = fragment_code.size_bytes(),
+          .pCode    = fragment_code.data()}}};
+    if (!use_libraries)
+    {
+        create_shader_module(vertex_code, &vert_shader_module_);
+        create_shader_module(fragment_code, &frag_shader_module_);
+    }
 
-    create_shader_module(vert_code, &vert_shader_module_);
-    create_shader_module(frag_code, &frag_shader_module_);
+    std::pmr::vector<VkSpecializationMapEntry> map_entries;
+    for (uint32_t i = 0; i < specialization_constants.size(); ++i)
+    {
+        map_entries.push_back(
+            {.constantID = i,
+             .offset     = static_cast<uint32_t>(i * sizeof(uint32_t)),
+             .size       = sizeof(uint32_t)});
+    }
+    const VkSpecializationInfo specialization_info{
+        .mapEntryCount = static_cast<uint32_t>(map_entries.size()),
+        .pMapEntries   = map_entries.data(),
+        .dataSize      = specialization_constants.size_bytes(),
+        .pData         = specialization_constants.data()};
+    const auto* specialization =
+        map_entries.empty() ? nullptr : &specialization_info;
 
     std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages = {};
-    shader_stages[0]                                             = {.sType =
-                            VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                                                                    .pNext               = nullptr,
-                                                                    .flags               = 0,
-                                                                    .stage               = VK_SHADER_STAGE_VERTEX_BIT,
-                                                                    .module              = vert_shader_module_,
-                                                                    .pName               = "main",
-                                                                    .pSpecializationInfo = nullptr};
-    shader_stages[1]                                             = {.sType =
-                            VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                                                                    .pNext               = nullptr,
-                                                                    .flags               = 0,
-                                                                    .stage               = VK_SHADER_STAGE_FRAGMENT_BIT,
-                                                                    .module              = frag_shader_module_,
-                                                                    .pName               = "main",
-                                                                    .pSpecializationInfo = nullptr};
+    shader_stages[0] = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .pNext               = use_libraries ? &module_infos[0] : nullptr,
+        .flags               = 0,
+        .stage               = VK_SHADER_STAGE_VERTEX_BIT,
+        .module              = vert_shader_module_,
+        .pName               = "main",
+        .pSpecializationInfo = specialization};
+    shader_stages[1] = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .pNext               = use_libraries ? &module_infos[1] : nullptr,
+        .flags               = 0,
+        .stage               = VK_SHADER_STAGE_FRAGMENT_BIT,
+        .module              = frag_shader_module_,
+        .pName               = "main",
+        .pSpecializationInfo = specialization};
 
     const auto binding_descriptions =
         LveModel::Vertex::get_binding_description();
     const auto attribute_descriptions =
         LveModel::Vertex::get_attribute_descriptions();
+    // a reloaded shader may expect vertex data the model doesn't provide
+    check_vertex_inputs(reflect_shader(vertex_code), attribute_descriptions);
     VkPipelineVertexInputStateCreateInfo vertex_input_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         .vertexBindingDescriptionCount =
@@ -76,8 +191,19 @@ void LvePipeline::create_graphics_pipeline(
         .pVertexAttributeDescriptions = attribute_descriptions.data(),
     };
 
+    const auto& target = config.render_target;
+    const VkPipelineRenderingCreateInfo rendering_info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount    = 1,
+        .pColorAttachmentFormats = &target.color_format,
+        .depthAttachmentFormat   = target.depth_format,
+        .stencilAttachmentFormat = target.stencil_format};
+
     VkGraphicsPipelineCreateInfo pipeline_info{
         .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        // without a render pass the formats come from the rendering info
+        .pNext = target.render_pass == VK_NULL_HANDLE ? &rendering_info
+                                                      : nullptr,
         .stageCount          = 2,
         .pStages             = shader_stages.data(),
         .pVertexInputState   = &vertex_input_info,
@@ -89,30 +215,104 @@ void LvePipeline::create_graphics_pipeline(
         .pColorBlendState    = &config.color_blend_info,
         .pDynamicState       = &config.dynamic_state_info,
         .layout              = config.pipeline_layout,
-        .renderPass          = config.render_pass,
-        .subpass             = config.subpass,
+        .renderPass          = target.render_pass,
+        .subpass             = target.subpass,
         .basePipelineHandle  = VK_NULL_HANDLE,
         .basePipelineIndex   = -1};
-    if (vkCreateGraphicsPipelines(device_.device(),
-                                  VK_NULL_HANDLE,
-                                  1,
-                                  &pipeline_info,
-                                  nullptr,
-                                  &graphics_pipeline_) != VK_SUCCESS)
+    if (use_libraries)
+    {
+        std::array<VkPipeline, LIBRARY_PARTS.size()> libraries{};
+        for (size_t i = 0; i < LIBRARY_PARTS.size(); ++i)
+        {
+            libraries[i] = config.library_cache->get_library(
+                pipeline_info, LIBRARY_PARTS[i]);
+        }
+        linked_->pipeline = link_libraries(
+            device_.device(), libraries, config.pipeline_layout, false);
+        config.library_cache->optimize_later(
+            [&device = device_,
+             linked  = linked_,
+             libraries,
+             layout = config.pipeline_layout,
+             id     = id_] {
+                optimize_libraries(device, *linked, libraries, layout, id);
+            });
+    }
+    else
     {
-        throw std::runtime_error("Failed to create graphics pipeline.");
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (vkCreateGraphicsPipelines(device_.device(),
+                                      VK_NULL_HANDLE,
+                                      1,
+                                      &pipeline_info,
+                                      nullptr,
+                                      &pipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create graphics pipeline.");
+        }
+        linked_->pipeline = pipeline;
     }
     fmt::print("vertex size: {}, fragment size: {}\n",
-               vert_code.size(),
-               frag_code.size());
+               vertex_code.size_bytes(),
+               fragment_code.size_bytes());
+}
+
+void LvePipeline::optimize_libraries(
+    LveDevice& device,
+    Linked& linked,
+    const std::array<VkPipeline, 4>& libraries,
+    VkPipelineLayout layout,
+    uint32_t id)
+{
+    {
+        // nothing binds it anymore
+        std::lock_guard lock{linked.mutex};
+        if (linked.destroyed)
+        {
+            return;
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    VkPipeline optimized = VK_NULL_HANDLE;
+    try
+    {
+        optimized = link_libraries(device.device(), libraries, layout, true);
+    }
+    catch (const std::runtime_error& error)
+    {
+        // the fast linked pipeline stays, it only draws slower
+        fmt::print("pipeline {}: {}\n", id, error.what());
+        return;
+    }
+    std::lock_guard lock{linked.mutex};
+    // frames recorded from now on bind the optimised pipeline, the fast
+    // linked one goes once the frame being recorded is done with it. A
+    // pipeline destroyed during the link has no use for the optimised one.
+    const auto unused =
+        linked.destroyed
+            ? optimized
+            : linked.pipeline.exchange(optimized, std::memory_order_acq_rel);
+    device.deletionQueue().push(
+        [device = device.device(), pipeline = unused] {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        });
+    if (!linked.destroyed)
+    {
+        fmt::print("pipeline {}: optimised in {:.1f} ms\n",
+                   id,
+                   std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count());
+    }
 }
-void LvePipeline::create_shader_module(const std::pmr::vector<std::byte>& code,
+
+void LvePipeline::create_shader_module(std::span<const uint32_t> code,
                                        VkShaderModule* shader_module)
 {
     VkShaderModuleCreateInfo create_info{
         .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = code.size(),
-        .pCode    = reinterpret_cast<const uint32_t*>(code.data())};
+        .codeSize = code.size_bytes(),
+        .pCode    = code.data()};
     if (vkCreateShaderModule(
             device_.device(), &create_info, nullptr, shader_module) !=
         VK_SUCCESS)
@@ -121,7 +321,9 @@ void LvePipeline::create_shader_module(const std::pmr::vector<std::byte>& code,
     }
 }
 
-void LvePipeline::default_pipeline_config_info(PipelineConfigInfo& config_info)
+void LvePipeline::default_pipeline_config_info(
+    PipelineConfigInfo& config_info,
+    const DeviceFeatureSupport& features)
 {
     config_info.input_assembly_info.sType =
         VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -201,6 +403,23 @@ void LvePipeline::default_pipeline_config_info(PipelineConfigInfo& config_info)
 
     config_info.dynamic_state_enables = {VK_DYNAMIC_STATE_VIEWPORT,
                                          VK_DYNAMIC_STATE_SCISSOR};
+    // kept in step with what LveDynamicState sets
+    if (features.extendedDynamicState)
+    {
+        config_info.dynamic_state_enables.insert(
+            config_info.dynamic_state_enables.end(),
+            {VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+             VK_DYNAMIC_STATE_CULL_MODE_EXT,
+             VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+             VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+             VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+             VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT});
+    }
+    if (features.extendedDynamicState && features.extendedDynamicState2)
+    {
+        config_info.dynamic_state_enables.push_back(
+            VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT);
+    }
     config_info.dynamic_state_info.sType =
         VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
     config_info.dynamic_state_info.pDynamicStates =
@@ -210,4 +429,19 @@ void LvePipeline::default_pipeline_config_info(PipelineConfigInfo& config_info)
     config_info.dynamic_state_info.flags = 0;
 }
 
+void LvePipeline::set_raster_state(PipelineConfigInfo& config_info,
+                                   const PipelineRasterState& state)
+{
+    config_info.input_assembly_info.topology = state.topology;
+    config_info.input_assembly_info.primitiveRestartEnable =
+        state.primitive_restart;
+
+    config_info.rasterization_info.cullMode  = state.cull_mode;
+    config_info.rasterization_info.frontFace = state.front_face;
+
+    config_info.depth_stencil_info.depthTestEnable  = state.depth_test;
+    config_info.depth_stencil_info.depthWriteEnable = state.depth_write;
+    config_info.depth_stencil_info.depthCompareOp   = state.depth_compare_op;
+}
+
 } // namespace lve
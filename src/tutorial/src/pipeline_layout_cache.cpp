@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <fmt/format.h>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <tutorial/pipeline_layout_cache.hpp>
+
+namespace lve
+{
+namespace
+{
+void hash_combine(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// a shader binding fits a set layout binding that may hold a dynamic
+// variant of its buffer and at least as many descriptors
+bool fits(const ShaderReflection::Binding& shader,
+          const VkDescriptorSetLayoutBinding& layout,
+          VkShaderStageFlags stages)
+{
+    const bool same_type =
+        shader.type == layout.descriptorType ||
+        (shader.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+         layout.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) ||
+        (shader.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER &&
+         layout.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+    return same_type && (layout.stageFlags & stages) == stages &&
+           layout.descriptorCount >= std::max(shader.count, 1u);
+}
+} // namespace
+
+LvePipelineLayoutCache::~LvePipelineLayoutCache()
+{
+    for (const auto& [key, layout] : layouts_)
+    {
+        vkDestroyPipelineLayout(device_.device(), layout, nullptr);
+    }
+}
+
+VkPipelineLayout LvePipelineLayoutCache::get_pipeline_layout(
+    std::span<const ShaderReflection> stages,
+    std::span<const SetLayout> set_layouts)
+{
+    // bindings of all stages by set, then binding index
+    std::map<uint32_t, std::map<uint32_t, ShaderReflection::Binding>> sets;
+    std::map<std::pair<uint32_t, uint32_t>, VkShaderStageFlags> binding_stages;
+    VkPushConstantRange push_constant_range{};
+    for (const auto& stage : stages)
+    {
+        for (const auto& binding : stage.bindings)
+        {
+            auto [it, inserted] =
+                sets[binding.set].try_emplace(binding.binding, binding);
+            if (!inserted && (it->second.type != binding.type ||
+                              it->second.count != binding.count))
+            {
+                throw std::runtime_error(fmt::format(
+                    "Shader stages disagree on binding {}.{}.",
+                    binding.set,
+                    binding.binding));
+            }
+            binding_stages[{binding.set, binding.binding}] |= stage.stage;
+        }
+        if (stage.push_constant_size > 0)
+        {
+            push_constant_range.stageFlags |= stage.stage;
+            push_constant_range.size =
+                std::max(push_constant_range.size, stage.push_constant_size);
+        }
+    }
+
+    LayoutKey key{.push_constant_range = push_constant_range};
+    uint32_t set_count = sets.empty() ? 0 : sets.rbegin()->first + 1;
+    for (const auto& set_layout : set_layouts)
+    {
+        set_count = std::max(set_count, set_layout.set + 1);
+    }
+    key.set_layouts.resize(set_count, VK_NULL_HANDLE);
+
+    for (const auto& set_layout : set_layouts)
+    {
+        for (const auto& [index, binding] : sets[set_layout.set])
+        {
+            const auto layout_binding = std::find_if(
+                set_layout.bindings.begin(),
+                set_layout.bindings.end(),
+                [&](const auto& layout_binding) {
+                    return layout_binding.binding == index;
+                });
+            if (layout_binding == set_layout.bindings.end() ||
+                !fits(binding,
+                      *layout_binding,
+                      binding_stages[{set_layout.set, index}]))
+            {
+                throw std::runtime_error(
+                    fmt::format("Shader binding {}.{} doesn't match its set "
+                                "layout.",
+                                set_layout.set,
+                                index));
+            }
+        }
+        key.set_layouts[set_layout.set] = set_layout.layout;
+    }
+
+    // sets without a given layout, including unused ones below used sets
+    for (uint32_t set = 0; set < set_count; ++set)
+    {
+        if (key.set_layouts[set] != VK_NULL_HANDLE)
+        {
+            continue;
+        }
+        std::pmr::vector<VkDescriptorSetLayoutBinding> bindings;
+        for (const auto& [index, binding] : sets[set])
+        {
+            if (binding.count == 0)
+            {
+                throw std::runtime_error(fmt::format(
+                    "Runtime sized binding {}.{} needs a given set layout.",
+                    set,
+                    index));
+            }
+            bindings.push_back(
+                {.binding         = index,
+                 .descriptorType  = binding.type,
+                 .descriptorCount = binding.count,
+                 .stageFlags      = binding_stages[{set, index}]});
+        }
+        key.set_layouts[set] =
+            descriptor_layout_cache_.create_descriptor_layout(bindings);
+    }
+
+    std::lock_guard lock{mutex_};
+    if (auto it = layouts_.find(key); it != layouts_.end())
+    {
+        return it->second;
+    }
+
+    VkPipelineLayoutCreateInfo layout_info{
+        .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(key.set_layouts.size()),
+        .pSetLayouts    = key.set_layouts.data(),
+        .pushConstantRangeCount = push_constant_range.size > 0 ? 1u : 0u,
+        .pPushConstantRanges    = &key.push_constant_range};
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(
+            device_.device(), &layout_info, nullptr, &layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create pipeline layout.");
+    }
+    layouts_.emplace(std::move(key), layout);
+    return layout;
+}
+
+size_t LvePipelineLayoutCache::size() const
+{
+    std::lock_guard lock{mutex_};
+    return layouts_.size();
+}
+
+bool LvePipelineLayoutCache::LayoutKey::operator==(
+    const LayoutKey& other) const
+{
+    return set_layouts == other.set_layouts &&
+           push_constant_range.stageFlags ==
+               other.push_constant_range.stageFlags &&
+           push_constant_range.offset == other.push_constant_range.offset &&
+           push_constant_range.size == other.push_constant_range.size;
+}
+
+size_t LvePipelineLayoutCache::LayoutKeyHash::operator()(
+    const LayoutKey& key) const
+{
+    size_t seed = std::hash<uint32_t>{}(key.push_constant_range.size);
+    hash_combine(seed,
+                 std::hash<uint32_t>{}(key.push_constant_range.stageFlags));
+    for (const auto layout : key.set_layouts)
+    {
+        hash_combine(seed, std::hash<VkDescriptorSetLayout>{}(layout));
+    }
+    return seed;
+}
+} // namespace lve
@@ -0,0 +1,375 @@
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <tutorial/pipeline_library_cache.hpp>
+
+namespace lve
+{
+namespace
+{
+// kept for the optimised link
+constexpr VkPipelineCreateFlags LIBRARY_FLAGS =
+    VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+    VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+// enums and flags alike
+template <typename... Values>
+void append(std::pmr::vector<uint32_t>& key, Values... values)
+{
+    (key.push_back(static_cast<uint32_t>(values)), ...);
+}
+
+// non-dispatchable handles are pointers on 64-bit platforms only
+template <typename Handle>
+void append_handle(std::pmr::vector<uint32_t>& key, Handle handle)
+{
+    uint64_t value = 0;
+    if constexpr (std::is_pointer_v<Handle>)
+    {
+        value = reinterpret_cast<uintptr_t>(handle);
+    }
+    else
+    {
+        value = handle;
+    }
+    key.push_back(static_cast<uint32_t>(value));
+    key.push_back(static_cast<uint32_t>(value >> 32));
+}
+
+void append_float(std::pmr::vector<uint32_t>& key, float value)
+{
+    key.push_back(std::bit_cast<uint32_t>(value));
+}
+
+// the size, then the bytes padded to whole words
+void append_bytes(std::pmr::vector<uint32_t>& key,
+                  const void* data,
+                  size_t size)
+{
+    key.push_back(static_cast<uint32_t>(size));
+    const auto offset = key.size();
+    key.resize(offset + (size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    std::memcpy(key.data() + offset, data, size);
+}
+
+void append_stage(std::pmr::vector<uint32_t>& key,
+                  const VkPipelineShaderStageCreateInfo& stage)
+{
+    const auto* module_info =
+        static_cast<const VkShaderModuleCreateInfo*>(stage.pNext);
+    assert(stage.module == VK_NULL_HANDLE && module_info &&
+           module_info->sType == VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO &&
+           "Library shader stages are keyed on their code");
+    key.push_back(stage.stage);
+    const std::string_view name{stage.pName};
+    append_bytes(key, name.data(), name.size());
+    append_bytes(key, module_info->pCode, module_info->codeSize);
+    const auto* specialization = stage.pSpecializationInfo;
+    if (!specialization)
+    {
+        key.push_back(0);
+        return;
+    }
+    key.push_back(specialization->mapEntryCount);
+    for (uint32_t i = 0; i < specialization->mapEntryCount; ++i)
+    {
+        const auto& entry = specialization->pMapEntries[i];
+        key.push_back(entry.constantID);
+        key.push_back(entry.offset);
+        key.push_back(static_cast<uint32_t>(entry.size));
+    }
+    append_bytes(key, specialization->pData, specialization->dataSize);
+}
+
+void append_multisample(std::pmr::vector<uint32_t>& key,
+                        const VkPipelineMultisampleStateCreateInfo& state)
+{
+    assert(!state.pSampleMask && "Sample masks aren't part of library keys");
+    key.push_back(state.rasterizationSamples);
+    key.push_back(state.sampleShadingEnable);
+    append_float(key, state.minSampleShading);
+    key.push_back(state.alphaToCoverageEnable);
+    key.push_back(state.alphaToOneEnable);
+}
+
+void append_stencil(std::pmr::vector<uint32_t>& key,
+                    const VkStencilOpState& state)
+{
+    append(key,
+           state.failOp,
+           state.passOp,
+           state.depthFailOp,
+           state.compareOp,
+           state.compareMask,
+           state.writeMask,
+           state.reference);
+}
+} // namespace
+
+LvePipelineLibraryCache::LvePipelineLibraryCache(LveDevice& device)
+    : device_{device}
+{
+    optimizer_ = std::thread{&LvePipelineLibraryCache::optimizer_loop, this};
+}
+
+LvePipelineLibraryCache::~LvePipelineLibraryCache()
+{
+    {
+        std::lock_guard lock{optimizer_mutex_};
+        stopping_ = true;
+    }
+    optimizer_wakeup_.notify_all();
+    optimizer_.join();
+
+    // the links are done with the libraries now
+    for (const auto& [key, library] : libraries_)
+    {
+        vkDestroyPipeline(device_.device(), library, nullptr);
+    }
+}
+
+VkPipeline LvePipelineLibraryCache::get_library(
+    const VkGraphicsPipelineCreateInfo& complete,
+    VkGraphicsPipelineLibraryFlagsEXT part)
+{
+    auto key = make_key(complete, part);
+    {
+        std::lock_guard lock{mutex_};
+        if (const auto library = libraries_.find(key);
+            library != libraries_.end())
+        {
+            return library->second;
+        }
+    }
+    // created unlocked, compiling a shader part takes a while
+    const auto library = create_library(complete, part);
+    std::lock_guard lock{mutex_};
+    const auto [cached, inserted] =
+        libraries_.try_emplace(std::move(key), library);
+    if (!inserted)
+    {
+        // another thread created the same part meanwhile
+        vkDestroyPipeline(device_.device(), library, nullptr);
+    }
+    return cached->second;
+}
+
+void LvePipelineLibraryCache::optimize_later(std::function<void()> link)
+{
+    {
+        std::lock_guard lock{optimizer_mutex_};
+        link_queue_.push_back(std::move(link));
+    }
+    optimizer_wakeup_.notify_one();
+}
+
+size_t LvePipelineLibraryCache::size() const
+{
+    std::lock_guard lock{mutex_};
+    return libraries_.size();
+}
+
+LvePipelineLibraryCache::Key LvePipelineLibraryCache::make_key(
+    const VkGraphicsPipelineCreateInfo& complete,
+    VkGraphicsPipelineLibraryFlagsEXT part)
+{
+    Key key{part};
+    // every part is created with the dynamic state and render target
+    const auto& dynamic = *complete.pDynamicState;
+    key.push_back(dynamic.dynamicStateCount);
+    key.insert(key.end(),
+               dynamic.pDynamicStates,
+               dynamic.pDynamicStates + dynamic.dynamicStateCount);
+    append_handle(key, complete.renderPass);
+    key.push_back(complete.subpass);
+    // the only structure chained to complete, with dynamic rendering
+    if (const auto* rendering =
+            static_cast<const VkPipelineRenderingCreateInfo*>(complete.pNext))
+    {
+        key.push_back(rendering->viewMask);
+        key.push_back(rendering->colorAttachmentCount);
+        key.insert(key.end(),
+                   rendering->pColorAttachmentFormats,
+                   rendering->pColorAttachmentFormats +
+                       rendering->colorAttachmentCount);
+        key.push_back(rendering->depthAttachmentFormat);
+        key.push_back(rendering->stencilAttachmentFormat);
+    }
+
+    switch (part)
+    {
+    case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+    {
+        const auto& vertex_input = *complete.pVertexInputState;
+        key.push_back(vertex_input.vertexBindingDescriptionCount);
+        for (uint32_t i = 0; i < vertex_input.vertexBindingDescriptionCount;
+             ++i)
+        {
+            const auto& binding = vertex_input.pVertexBindingDescriptions[i];
+            append(key, binding.binding, binding.stride, binding.inputRate);
+        }
+        key.push_back(vertex_input.vertexAttributeDescriptionCount);
+        for (uint32_t i = 0; i < vertex_input.vertexAttributeDescriptionCount;
+             ++i)
+        {
+            const auto& attribute =
+                vertex_input.pVertexAttributeDescriptions[i];
+            append(key,
+                   attribute.location,
+                   attribute.binding,
+                   attribute.format,
+                   attribute.offset);
+        }
+        key.push_back(complete.pInputAssemblyState->topology);
+        key.push_back(complete.pInputAssemblyState->primitiveRestartEnable);
+        break;
+    }
+    case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+    {
+        append_handle(key, complete.layout);
+        append_stage(key, complete.pStages[0]);
+        key.push_back(complete.pViewportState->viewportCount);
+        key.push_back(complete.pViewportState->scissorCount);
+        const auto& rasterization = *complete.pRasterizationState;
+        append(key,
+               rasterization.depthClampEnable,
+               rasterization.rasterizerDiscardEnable,
+               rasterization.polygonMode,
+               rasterization.cullMode,
+               rasterization.frontFace,
+               rasterization.depthBiasEnable);
+        append_float(key, rasterization.depthBiasConstantFactor);
+        append_float(key, rasterization.depthBiasClamp);
+        append_float(key, rasterization.depthBiasSlopeFactor);
+        append_float(key, rasterization.lineWidth);
+        break;
+    }
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+    {
+        append_handle(key, complete.layout);
+        append_stage(key, complete.pStages[1]);
+        append_multisample(key, *complete.pMultisampleState);
+        const auto& depth_stencil = *complete.pDepthStencilState;
+        append(key,
+               depth_stencil.depthTestEnable,
+               depth_stencil.depthWriteEnable,
+               depth_stencil.depthCompareOp,
+               depth_stencil.depthBoundsTestEnable,
+               depth_stencil.stencilTestEnable);
+        append_float(key, depth_stencil.minDepthBounds);
+        append_float(key, depth_stencil.maxDepthBounds);
+        append_stencil(key, depth_stencil.front);
+        append_stencil(key, depth_stencil.back);
+        break;
+    }
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+    {
+        append_multisample(key, *complete.pMultisampleState);
+        const auto& color_blend = *complete.pColorBlendState;
+        key.push_back(color_blend.logicOpEnable);
+        key.push_back(color_blend.logicOp);
+        key.push_back(color_blend.attachmentCount);
+        for (uint32_t i = 0; i < color_blend.attachmentCount; ++i)
+        {
+            const auto& attachment = color_blend.pAttachments[i];
+            append(key,
+                   attachment.blendEnable,
+                   attachment.srcColorBlendFactor,
+                   attachment.dstColorBlendFactor,
+                   attachment.colorBlendOp,
+                   attachment.srcAlphaBlendFactor,
+                   attachment.dstAlphaBlendFactor,
+                   attachment.alphaBlendOp,
+                   attachment.colorWriteMask);
+        }
+        for (const auto constant : color_blend.blendConstants)
+        {
+            append_float(key, constant);
+        }
+        break;
+    }
+    }
+    return key;
+}
+
+VkPipeline LvePipelineLibraryCache::create_library(
+    const VkGraphicsPipelineCreateInfo& complete,
+    VkGraphicsPipelineLibraryFlagsEXT part)
+{
+    // the rendering info chained for dynamic rendering is kept for all parts
+    const VkGraphicsPipelineLibraryCreateInfoEXT library_info{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .pNext = complete.pNext,
+        .flags = part};
+    VkGraphicsPipelineCreateInfo pipeline_info{
+        .sType              = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext              = &library_info,
+        .flags              = LIBRARY_FLAGS,
+        .pDynamicState      = complete.pDynamicState,
+        .renderPass         = complete.renderPass,
+        .subpass            = complete.subpass,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex  = -1};
+    // each part only gets the state that belongs to it
+    switch (part)
+    {
+    case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+        pipeline_info.pVertexInputState   = complete.pVertexInputState;
+        pipeline_info.pInputAssemblyState = complete.pInputAssemblyState;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+        pipeline_info.stageCount          = 1;
+        pipeline_info.pStages             = &complete.pStages[0];
+        pipeline_info.pViewportState      = complete.pViewportState;
+        pipeline_info.pRasterizationState = complete.pRasterizationState;
+        pipeline_info.layout              = complete.layout;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+        pipeline_info.stageCount         = 1;
+        pipeline_info.pStages            = &complete.pStages[1];
+        pipeline_info.pMultisampleState  = complete.pMultisampleState;
+        pipeline_info.pDepthStencilState = complete.pDepthStencilState;
+        pipeline_info.layout             = complete.layout;
+        break;
+    case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+        pipeline_info.pMultisampleState = complete.pMultisampleState;
+        pipeline_info.pColorBlendState  = complete.pColorBlendState;
+        break;
+    }
+
+    VkPipeline library = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(device_.device(),
+                                  VK_NULL_HANDLE,
+                                  1,
+                                  &pipeline_info,
+                                  nullptr,
+                                  &library) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create graphics pipeline library.");
+    }
+    return library;
+}
+
+void LvePipelineLibraryCache::optimizer_loop()
+{
+    while (true)
+    {
+        std::function<void()> link;
+        {
+            std::unique_lock lock{optimizer_mutex_};
+            optimizer_wakeup_.wait(
+                lock, [this] { return stopping_ || !link_queue_.empty(); });
+            if (stopping_)
+            {
+                return;
+            }
+            link = std::move(link_queue_.front());
+            link_queue_.pop_front();
+        }
+        link();
+    }
+}
+} // namespace lve
@@ -0,0 +1,70 @@
+#include <cassert>
+#include <tutorial/pipeline_variants.hpp>
+
+namespace lve
+{
+LvePipelineVariants::LvePipelineVariants(uint32_t constant_count,
+                                         Factory factory)
+    : constant_count_{constant_count}, factory_{std::move(factory)}
+{
+    assert(factory_ && "Pipeline variants without factory");
+}
+
+LvePipelineVariants::~LvePipelineVariants()
+{
+    if (shader_reloader_)
+    {
+        for (auto& [key, variant] : variants_)
+        {
+            shader_reloader_->unwatch(&variant);
+        }
+    }
+}
+
+void LvePipelineVariants::watch_shaders(
+    LveShaderReloader& shader_reloader,
+    const std::pmr::vector<std::filesystem::path>& shaders)
+{
+    assert(!shader_reloader_ && "Shaders are watched already");
+    shader_reloader_ = &shader_reloader;
+    shaders_         = shaders;
+    for (auto& [key, variant] : variants_)
+    {
+        watch_variant(key, variant);
+    }
+}
+
+LvePipeline& LvePipelineVariants::get(
+    std::span<const uint32_t> specialization_constants,
+    uint32_t baked_state)
+{
+    assert(specialization_constants.size() == constant_count_ &&
+           "Wrong number of specialization constants");
+    Key key(specialization_constants.begin(), specialization_constants.end());
+    key.push_back(baked_state);
+    auto variant = variants_.find(key);
+    if (variant == variants_.end())
+    {
+        auto pipeline =
+            factory_(specialization_constants, baked_state, reloaded_);
+        variant = variants_.emplace(std::move(key), std::move(pipeline)).first;
+        if (shader_reloader_)
+        {
+            watch_variant(variant->first, variant->second);
+        }
+    }
+    return *variant->second;
+}
+
+void LvePipelineVariants::watch_variant(const Key& key,
+                                        std::unique_ptr<LvePipeline>& variant)
+{
+    // map keys never move, the reference stays valid while watched
+    shader_reloader_->watch(&variant, shaders_, [this, &key] {
+        auto pipeline = factory_(
+            std::span{key}.first(constant_count_), key.back(), true);
+        reloaded_     = true;
+        return pipeline;
+    });
+}
+} // namespace lve
@@ -0,0 +1,630 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <tutorial/render_graph.hpp>
+
+namespace lve
+{
+namespace
+{
+bool has_stencil(VkFormat format)
+{
+    return format == VK_FORMAT_S8_UINT ||
+           format == VK_FORMAT_D16_UNORM_S8_UINT ||
+           format == VK_FORMAT_D24_UNORM_S8_UINT ||
+           format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+bool has_depth(VkFormat format)
+{
+    return format == VK_FORMAT_D16_UNORM ||
+           format == VK_FORMAT_X8_D24_UNORM_PACK32 ||
+           format == VK_FORMAT_D32_SFLOAT ||
+           (has_stencil(format) && format != VK_FORMAT_S8_UINT);
+}
+
+VkImageAspectFlags aspect_mask(VkFormat format)
+{
+    VkImageAspectFlags aspect = 0;
+    if (has_depth(format))
+    {
+        aspect |= VK_IMAGE_ASPECT_DEPTH_BIT;
+    }
+    if (has_stencil(format))
+    {
+        aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    return aspect != 0 ? aspect : VK_IMAGE_ASPECT_COLOR_BIT;
+}
+} // namespace
+
+LveRenderGraph::LveRenderGraph(LveDevice& device)
+    : device_{device},
+      lazy_memory_types_{
+          device.findMemoryTypes(VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)}
+{
+    if (device.featureSupport().dynamicRendering)
+    {
+        begin_rendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(device.device(), "vkCmdBeginRenderingKHR"));
+        end_rendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+            vkGetDeviceProcAddr(device.device(), "vkCmdEndRenderingKHR"));
+    }
+}
+
+LveRenderGraph::~LveRenderGraph()
+{
+    retire_framebuffers(true);
+    for (auto& set : transient_sets_)
+    {
+        retire_transient_images(set);
+    }
+    std::pmr::vector<VkRenderPass> render_passes;
+    for (const auto& cached : render_passes_)
+    {
+        render_passes.push_back(cached.render_pass);
+    }
+    device_.deletionQueue().push(
+        [device        = device_.device(),
+         render_passes = std::move(render_passes)] {
+            for (auto render_pass : render_passes)
+            {
+                vkDestroyRenderPass(device, render_pass, nullptr);
+            }
+        });
+}
+
+void LveRenderGraph::reset(uint32_t frame_slot)
+{
+    frame_slot_ = frame_slot;
+    if (transient_sets_.size() <= frame_slot)
+    {
+        transient_sets_.resize(frame_slot + 1);
+    }
+    clear();
+    compiled_ = false;
+}
+
+void LveRenderGraph::compile()
+{
+    const auto start = std::chrono::steady_clock::now();
+    ++compile_count_;
+
+    cull_passes();
+    order_passes();
+    realize_transient_images();
+    plan_barriers(
+        static_cast<uint32_t>(transient_sets_[frame_slot_].blocks.size()));
+    choose_store_ops();
+    prepare_render_passes();
+    retire_framebuffers(false);
+    compiled_ = true;
+
+    stats_        = {};
+    stats_.passes = static_cast<uint32_t>(order_.size());
+    stats_.culled = static_cast<uint32_t>(passes_.size() - order_.size());
+    stats_.barriers = static_cast<uint32_t>(final_barriers_.size());
+    for (const auto index : order_)
+    {
+        stats_.barriers +=
+            static_cast<uint32_t>(passes_[index].barriers.size());
+    }
+    for (const auto& set : transient_sets_)
+    {
+        stats_.transient_images += static_cast<uint32_t>(set.images.size());
+        stats_.memory_blocks += static_cast<uint32_t>(set.blocks.size());
+        for (const auto& image : set.images)
+        {
+            stats_.aliased_bytes += image.requirements.size;
+        }
+        for (const auto& block : set.blocks)
+        {
+            stats_.transient_bytes += block.size;
+            stats_.lazy_bytes += block.lazy ? block.size : 0;
+        }
+    }
+    stats_.aliased_bytes -= stats_.transient_bytes;
+    stats_.cpu_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+}
+
+void LveRenderGraph::realize_transient_images()
+{
+    auto keys = transient_keys(lazy_memory_types_ != 0);
+    auto& set = transient_sets_[frame_slot_];
+    if (keys != set.keys)
+    {
+        // the framebuffers hold views of the images being replaced
+        retire_framebuffers(true);
+        retire_transient_images(set);
+        set.keys = std::move(keys);
+
+        set.images.resize(set.keys.size());
+        for (size_t i = 0; i < set.keys.size(); ++i)
+        {
+            const auto& key = set.keys[i];
+            VkImageCreateInfo image_info{
+                .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType     = VK_IMAGE_TYPE_2D,
+                .format        = key.format,
+                .extent        = {key.extent.width, key.extent.height, 1},
+                .mipLevels     = 1,
+                .arrayLayers   = 1,
+                .samples       = VK_SAMPLE_COUNT_1_BIT,
+                .tiling        = VK_IMAGE_TILING_OPTIMAL,
+                .usage         = key.usage,
+                .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+            auto& physical = set.images[i];
+            if (vkCreateImage(
+                    device_.device(), &image_info, nullptr, &physical.image) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error(
+                    "Failed to create render graph image.");
+            }
+            vkGetImageMemoryRequirements(
+                device_.device(), physical.image, &physical.requirements);
+        }
+
+        plan_memory_blocks(set);
+
+        for (auto& block : set.blocks)
+        {
+            // images with TRANSIENT_ATTACHMENT usage may still not support
+            // a lazily allocated type, they fall back to device local memory
+            const auto lazy_types = block.type_bits & lazy_memory_types_;
+            block.lazy            = block.lazy && lazy_types != 0;
+            const auto memory_type =
+                block.lazy ? device_.findMemoryType(
+                                 lazy_types,
+                                 VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+                           : device_.findMemoryType(
+                                 block.type_bits,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            VkMemoryAllocateInfo alloc_info{
+                .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize  = block.size,
+                .memoryTypeIndex = memory_type};
+            if (vkAllocateMemory(
+                    device_.device(), &alloc_info, nullptr, &block.memory) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error(
+                    "Failed to allocate render graph memory.");
+            }
+        }
+        for (size_t i = 0; i < set.images.size(); ++i)
+        {
+            auto& physical = set.images[i];
+            vkBindImageMemory(device_.device(),
+                              physical.image,
+                              set.blocks[physical.block].memory,
+                              0);
+            const auto format = set.keys[i].format;
+            VkImageViewCreateInfo view_info{
+                .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image            = physical.image,
+                .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+                .format           = format,
+                .subresourceRange = {.aspectMask     = aspect_mask(format),
+                                     .baseMipLevel   = 0,
+                                     .levelCount     = 1,
+                                     .baseArrayLayer = 0,
+                                     .layerCount     = 1}};
+            if (vkCreateImageView(
+                    device_.device(), &view_info, nullptr, &physical.view) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error(
+                    "Failed to create render graph image view.");
+            }
+        }
+    }
+
+    use_transient_set(set);
+}
+
+void LveRenderGraph::prepare_render_passes()
+{
+    for (const auto index : order_)
+    {
+        auto& pass = passes_[index];
+        if (pass.attachments.empty())
+        {
+            pass.render_pass = VK_NULL_HANDLE;
+            pass.framebuffer = VK_NULL_HANDLE;
+            continue;
+        }
+        pass.extent = images_[pass.attachments.front().image].extent;
+        for (const auto& attachment : pass.attachments)
+        {
+            const auto extent = images_[attachment.image].extent;
+            assert(extent.width == pass.extent.width &&
+                   extent.height == pass.extent.height &&
+                   "Render graph pass attachments differ in size");
+        }
+        if (pass.render_area.width == 0 || pass.render_area.height == 0)
+        {
+            pass.render_area = pass.extent;
+        }
+        assert(pass.render_area.width <= pass.extent.width &&
+               pass.render_area.height <= pass.extent.height &&
+               "Render graph pass renders outside its attachments");
+        if (begin_rendering_)
+        {
+            pass.render_pass = VK_NULL_HANDLE;
+            pass.framebuffer = VK_NULL_HANDLE;
+            continue;
+        }
+        pass.render_pass = get_render_pass(pass);
+        pass.framebuffer = get_framebuffer(pass);
+    }
+}
+
+VkRenderPass LveRenderGraph::get_render_pass(const Pass& pass)
+{
+    std::pmr::vector<uint32_t> key{pass.has_depth};
+    for (const auto& attachment : pass.attachments)
+    {
+        key.push_back(images_[attachment.image].format);
+        key.push_back(attachment.load_op);
+        key.push_back(attachment.store_op);
+    }
+    for (const auto& cached : render_passes_)
+    {
+        if (cached.key == key)
+        {
+            return cached.render_pass;
+        }
+    }
+
+    // the graph's barriers bring the attachments to their layouts before
+    // the render pass begins, it transitions nothing itself
+    std::pmr::vector<VkAttachmentDescription> descriptions;
+    std::pmr::vector<VkAttachmentReference> color_references;
+    VkAttachmentReference depth_reference{};
+    for (uint32_t i = 0; i < pass.attachments.size(); ++i)
+    {
+        const auto& attachment = pass.attachments[i];
+        const auto format      = images_[attachment.image].format;
+        const bool depth = pass.has_depth && i + 1 == pass.attachments.size();
+        const auto layout =
+            depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                  : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        const bool stencil = has_stencil(format);
+        descriptions.push_back(
+            {.format  = format,
+             .samples = VK_SAMPLE_COUNT_1_BIT,
+             .loadOp  = attachment.load_op,
+             .storeOp = attachment.store_op,
+             .stencilLoadOp =
+                 stencil ? attachment.load_op : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+             .stencilStoreOp = stencil ? attachment.store_op
+                                       : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+             .initialLayout = layout,
+             .finalLayout   = layout});
+        if (depth)
+        {
+            depth_reference = {i, layout};
+        }
+        else
+        {
+            color_references.push_back({i, layout});
+        }
+    }
+
+    VkSubpassDescription subpass{
+        .pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = static_cast<uint32_t>(color_references.size()),
+        .pColorAttachments    = color_references.data(),
+        .pDepthStencilAttachment =
+            pass.has_depth ? &depth_reference : nullptr};
+    VkRenderPassCreateInfo render_pass_info{
+        .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = static_cast<uint32_t>(descriptions.size()),
+        .pAttachments    = descriptions.data(),
+        .subpassCount    = 1,
+        .pSubpasses      = &subpass};
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    if (vkCreateRenderPass(
+            device_.device(), &render_pass_info, nullptr, &render_pass) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render graph render pass.");
+    }
+    render_passes_.push_back({std::move(key), render_pass});
+    return render_pass;
+}
+
+VkFramebuffer LveRenderGraph::get_framebuffer(const Pass& pass)
+{
+    std::pmr::vector<VkImageView> views;
+    std::pmr::vector<uint64_t> generations;
+    for (const auto& attachment : pass.attachments)
+    {
+        views.push_back(images_[attachment.image].view);
+        generations.push_back(images_[attachment.image].generation);
+    }
+    for (auto& cached : framebuffers_)
+    {
+        if (cached.render_pass == pass.render_pass && cached.views == views &&
+            cached.generations == generations &&
+            cached.extent.width == pass.extent.width &&
+            cached.extent.height == pass.extent.height)
+        {
+            cached.last_used = compile_count_;
+            return cached.framebuffer;
+        }
+    }
+
+    VkFramebufferCreateInfo framebuffer_info{
+        .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .renderPass      = pass.render_pass,
+        .attachmentCount = static_cast<uint32_t>(views.size()),
+        .pAttachments    = views.data(),
+        .width           = pass.extent.width,
+        .height          = pass.extent.height,
+        .layers          = 1};
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    if (vkCreateFramebuffer(
+            device_.device(), &framebuffer_info, nullptr, &framebuffer) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render graph framebuffer.");
+    }
+    framebuffers_.push_back({pass.render_pass,
+                             std::move(views),
+                             std::move(generations),
+                             pass.extent,
+                             framebuffer,
+                             compile_count_});
+    return framebuffer;
+}
+
+void LveRenderGraph::retire_framebuffers(bool all)
+{
+    // imported views change every frame, framebuffers of views that are
+    // gone, or of an earlier generation of them, are dropped once they went
+    // unused for a while
+    std::pmr::vector<VkFramebuffer> retired;
+    std::erase_if(framebuffers_, [&](const CachedFramebuffer& cached) {
+        if (!all && compile_count_ - cached.last_used <=
+                        FRAMEBUFFER_MAX_IDLE_COMPILES)
+        {
+            return false;
+        }
+        retired.push_back(cached.framebuffer);
+        return true;
+    });
+    if (retired.empty())
+    {
+        return;
+    }
+    device_.deletionQueue().push(
+        [device = device_.device(), retired = std::move(retired)] {
+            for (auto framebuffer : retired)
+            {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+        });
+}
+
+void LveRenderGraph::retire_transient_images(TransientSet& set)
+{
+    std::pmr::vector<PhysicalImage> images;
+    std::pmr::vector<VkDeviceMemory> memories;
+    images.swap(set.images);
+    for (const auto& block : set.blocks)
+    {
+        memories.push_back(block.memory);
+    }
+    set.blocks.clear();
+    set.keys.clear();
+    if (images.empty())
+    {
+        return;
+    }
+    device_.deletionQueue().push([device   = device_.device(),
+                                  images   = std::move(images),
+                                  memories = std::move(memories)] {
+        for (const auto& image : images)
+        {
+            vkDestroyImageView(device, image.view, nullptr);
+            vkDestroyImage(device, image.image, nullptr);
+        }
+        for (auto memory : memories)
+        {
+            vkFreeMemory(device, memory, nullptr);
+        }
+    });
+}
+
+void LveRenderGraph::execute(VkCommandBuffer command_buffer)
+{
+    assert(compiled_ && "Render graph executed before it was compiled");
+    std::pmr::vector<VkClearValue> clear_values;
+    for (const auto index : order_)
+    {
+        auto& pass = passes_[index];
+        record_barriers(command_buffer, pass.barriers);
+        if (pass.attachments.empty())
+        {
+            if (pass.execute)
+            {
+                pass.execute(command_buffer);
+            }
+            continue;
+        }
+
+        if (begin_rendering_)
+        {
+            begin_rendering(command_buffer, pass);
+        }
+        else
+        {
+            clear_values.clear();
+            for (const auto& attachment : pass.attachments)
+            {
+                clear_values.push_back(attachment.clear);
+            }
+            VkRenderPassBeginInfo render_pass_info{
+                .sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .renderPass  = pass.render_pass,
+                .framebuffer = pass.framebuffer,
+                .renderArea = {.offset = {0, 0}, .extent = pass.render_area},
+                .clearValueCount = static_cast<uint32_t>(clear_values.size()),
+                .pClearValues    = clear_values.data()};
+            vkCmdBeginRenderPass(
+                command_buffer,
+                &render_pass_info,
+                pass.secondary_contents
+                    ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                    : VK_SUBPASS_CONTENTS_INLINE);
+        }
+        // secondary command buffers set their own
+        if (!pass.secondary_contents)
+        {
+            const VkViewport viewport{
+                .x        = 0.f,
+                .y        = 0.f,
+                .width    = static_cast<float>(pass.render_area.width),
+                .height   = static_cast<float>(pass.render_area.height),
+                .minDepth = 0.f,
+                .maxDepth = 1.f};
+            const VkRect2D scissor{{0, 0}, pass.render_area};
+            vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+            vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        }
+        if (pass.execute)
+        {
+            pass.execute(command_buffer);
+        }
+        if (begin_rendering_)
+        {
+            end_rendering_(command_buffer);
+        }
+        else
+        {
+            vkCmdEndRenderPass(command_buffer);
+        }
+    }
+    record_barriers(command_buffer, final_barriers_);
+}
+
+void LveRenderGraph::begin_rendering(VkCommandBuffer command_buffer,
+                                     const Pass& pass)
+{
+    // like the render passes, rendering transitions nothing, the graph's
+    // barriers have brought the attachments to these layouts
+    std::pmr::vector<VkRenderingAttachmentInfo> color_attachments;
+    VkRenderingAttachmentInfo depth_attachment{};
+    for (uint32_t i = 0; i < pass.attachments.size(); ++i)
+    {
+        const auto& attachment = pass.attachments[i];
+        const bool depth = pass.has_depth && i + 1 == pass.attachments.size();
+        const auto layout =
+            depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                  : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        const VkRenderingAttachmentInfo info{
+            .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView   = images_[attachment.image].view,
+            .imageLayout = layout,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .loadOp      = attachment.load_op,
+            .storeOp     = attachment.store_op,
+            .clearValue  = attachment.clear};
+        if (depth)
+        {
+            depth_attachment = info;
+        }
+        else
+        {
+            color_attachments.push_back(info);
+        }
+    }
+
+    const auto depth_format =
+        pass.has_depth ? images_[pass.attachments.back().image].format
+                       : VK_FORMAT_UNDEFINED;
+    const VkRenderingInfo rendering_info{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags = pass.secondary_contents
+                     ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+                     : 0u,
+        .renderArea = {.offset = {0, 0}, .extent = pass.render_area},
+        .layerCount = 1,
+        .colorAttachmentCount =
+            static_cast<uint32_t>(color_attachments.size()),
+        .pColorAttachments = color_attachments.data(),
+        .pDepthAttachment  = pass.has_depth ? &depth_attachment : nullptr,
+        .pStencilAttachment =
+            has_stencil(depth_format) ? &depth_attachment : nullptr};
+    begin_rendering_(command_buffer, &rendering_info);
+}
+
+void LveRenderGraph::record_barriers(VkCommandBuffer command_buffer,
+                                     std::span<const Barrier> barriers)
+{
+    VkPipelineStageFlags src_stages = 0;
+    VkPipelineStageFlags dst_stages = 0;
+    std::pmr::vector<VkImageMemoryBarrier> image_barriers;
+    std::pmr::vector<VkBufferMemoryBarrier> buffer_barriers;
+    for (const auto& barrier : barriers)
+    {
+        src_stages |= barrier.src_stages;
+        dst_stages |= barrier.dst_stages;
+        // waiting for reads only takes an execution dependency
+        if (barrier.src_access == 0 &&
+            barrier.old_layout == barrier.new_layout)
+        {
+            continue;
+        }
+        if (!barrier.image)
+        {
+            buffer_barriers.push_back(
+                {.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                 .srcAccessMask       = barrier.src_access,
+                 .dstAccessMask       = barrier.dst_access,
+                 .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                 .buffer              = buffers_[barrier.resource].buffer,
+                 .offset              = 0,
+                 .size                = VK_WHOLE_SIZE});
+            continue;
+        }
+        const auto& image = images_[barrier.resource];
+        image_barriers.push_back(
+            {.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+             .srcAccessMask       = barrier.src_access,
+             .dstAccessMask       = barrier.dst_access,
+             .oldLayout           = barrier.old_layout,
+             .newLayout           = barrier.new_layout,
+             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .image               = image.image,
+             .subresourceRange    = {.aspectMask = aspect_mask(image.format),
+                                     .baseMipLevel   = 0,
+                                     .levelCount     = 1,
+                                     .baseArrayLayer = 0,
+                                     .layerCount     = 1}});
+    }
+    if (barriers.empty())
+    {
+        return;
+    }
+    vkCmdPipelineBarrier(
+        command_buffer,
+        src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        dst_stages != 0 ? dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(buffer_barriers.size()),
+        buffer_barriers.data(),
+        static_cast<uint32_t>(image_barriers.size()),
+        image_barriers.data());
+}
+} // namespace lve
@@ -0,0 +1,726 @@
+#include <algorithm>
+#include <cassert>
+#include <tutorial/render_graph_plan.hpp>
+
+namespace lve
+{
+namespace
+{
+constexpr VkAccessFlags WRITE_ACCESS =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+// usage that lets an image live in lazily allocated memory
+constexpr VkImageUsageFlags ATTACHMENT_USAGE =
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+    VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+bool overlaps(uint32_t first_a,
+              uint32_t last_a,
+              uint32_t first_b,
+              uint32_t last_b)
+{
+    return first_a <= last_b && first_b <= last_a;
+}
+} // namespace
+
+void RenderGraphPlan::PassBuilder::color_attachment(RenderGraphImage image,
+                                                    VkAttachmentLoadOp load_op,
+                                                    VkClearColorValue clear)
+{
+    const bool loads = load_op == VK_ATTACHMENT_LOAD_OP_LOAD;
+    use_image(image,
+              VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+              VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+              (loads ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0) |
+                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+              loads,
+              true);
+    auto& pass = graph_.passes_[pass_];
+    // the depth attachment stays last
+    const auto position = pass.attachments.end() - (pass.has_depth ? 1 : 0);
+    pass.attachments.insert(
+        position,
+        {image.index,
+         load_op,
+         VK_ATTACHMENT_STORE_OP_STORE,
+         VkClearValue{.color = clear}});
+}
+
+void RenderGraphPlan::PassBuilder::depth_attachment(
+    RenderGraphImage image,
+    VkAttachmentLoadOp load_op,
+    VkClearDepthStencilValue clear)
+{
+    auto& pass = graph_.passes_[pass_];
+    assert(!pass.has_depth && "Pass with more than one depth attachment");
+    // depth tests read the attachment whatever its load op
+    use_image(image,
+              VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                  VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+              VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+              VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+              load_op == VK_ATTACHMENT_LOAD_OP_LOAD,
+              true);
+    pass.attachments.push_back({image.index,
+                                load_op,
+                                VK_ATTACHMENT_STORE_OP_STORE,
+                                VkClearValue{.depthStencil = clear}});
+    pass.has_depth = true;
+}
+
+void RenderGraphPlan::PassBuilder::sampled(RenderGraphImage image,
+                                           VkPipelineStageFlags stages)
+{
+    use_image(image,
+              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+              stages,
+              VK_ACCESS_SHADER_READ_BIT,
+              VK_IMAGE_USAGE_SAMPLED_BIT,
+              true,
+              false);
+}
+
+void RenderGraphPlan::PassBuilder::storage_read(RenderGraphImage image,
+                                                VkPipelineStageFlags stages)
+{
+    use_image(image,
+              VK_IMAGE_LAYOUT_GENERAL,
+              stages,
+              VK_ACCESS_SHADER_READ_BIT,
+              VK_IMAGE_USAGE_STORAGE_BIT,
+              true,
+              false);
+}
+
+void RenderGraphPlan::PassBuilder::storage_write(RenderGraphImage image,
+                                                 VkPipelineStageFlags stages)
+{
+    use_image(image,
+              VK_IMAGE_LAYOUT_GENERAL,
+              stages,
+              VK_ACCESS_SHADER_WRITE_BIT,
+              VK_IMAGE_USAGE_STORAGE_BIT,
+              false,
+              true);
+}
+
+void RenderGraphPlan::PassBuilder::transfer_source(RenderGraphImage image)
+{
+    use_image(image,
+              VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+              VK_PIPELINE_STAGE_TRANSFER_BIT,
+              VK_ACCESS_TRANSFER_READ_BIT,
+              VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+              true,
+              false);
+}
+
+void RenderGraphPlan::PassBuilder::transfer_destination(RenderGraphImage image)
+{
+    use_image(image,
+              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+              VK_PIPELINE_STAGE_TRANSFER_BIT,
+              VK_ACCESS_TRANSFER_WRITE_BIT,
+              VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+              false,
+              true);
+}
+
+void RenderGraphPlan::PassBuilder::read(RenderGraphBuffer buffer,
+                                        VkPipelineStageFlags stages,
+                                        VkAccessFlags access)
+{
+    use_buffer(buffer, stages, access, true, false);
+}
+
+void RenderGraphPlan::PassBuilder::write(RenderGraphBuffer buffer,
+                                         VkPipelineStageFlags stages,
+                                         VkAccessFlags access)
+{
+    use_buffer(buffer, stages, access, false, true);
+}
+
+void RenderGraphPlan::PassBuilder::render_area(VkExtent2D extent)
+{
+    graph_.passes_[pass_].render_area = extent;
+}
+
+void RenderGraphPlan::PassBuilder::side_effect()
+{
+    graph_.passes_[pass_].side_effect = true;
+}
+
+void RenderGraphPlan::PassBuilder::secondary_command_buffers()
+{
+    graph_.passes_[pass_].secondary_contents = true;
+}
+
+void RenderGraphPlan::PassBuilder::use_image(RenderGraphImage image,
+                                             VkImageLayout layout,
+                                             VkPipelineStageFlags stages,
+                                             VkAccessFlags access,
+                                             VkImageUsageFlags usage,
+                                             bool reads,
+                                             bool writes)
+{
+    assert(image.index < graph_.images_.size() && "Unknown render graph image");
+    auto& resource = graph_.images_[image.index];
+    auto& uses     = graph_.passes_[pass_].uses;
+    auto use       = std::find_if(uses.begin(), uses.end(), [&](const Use& u) {
+        return u.image && u.resource == image.index;
+    });
+    if (use == uses.end())
+    {
+        uses.push_back({image.index,
+                        true,
+                        layout,
+                        stages,
+                        access,
+                        usage,
+                        reads,
+                        writes,
+                        resource.version});
+        resource.version += writes ? 1 : 0;
+        return;
+    }
+    // a pass sees an image in one layout, its uses of it are merged
+    assert(use->layout == layout &&
+           "Image used in two layouts by the same render graph pass");
+    resource.version += writes && !use->writes ? 1 : 0;
+    use->stages |= stages;
+    use->access |= access;
+    use->usage |= usage;
+    use->reads  = use->reads || reads;
+    use->writes = use->writes || writes;
+}
+
+void RenderGraphPlan::PassBuilder::use_buffer(RenderGraphBuffer buffer,
+                                              VkPipelineStageFlags stages,
+                                              VkAccessFlags access,
+                                              bool reads,
+                                              bool writes)
+{
+    assert(buffer.index < graph_.buffers_.size() &&
+           "Unknown render graph buffer");
+    auto& resource = graph_.buffers_[buffer.index];
+    auto& uses     = graph_.passes_[pass_].uses;
+    auto use       = std::find_if(uses.begin(), uses.end(), [&](const Use& u) {
+        return !u.image && u.resource == buffer.index;
+    });
+    if (use == uses.end())
+    {
+        uses.push_back({buffer.index,
+                        false,
+                        VK_IMAGE_LAYOUT_UNDEFINED,
+                        stages,
+                        access,
+                        0,
+                        reads,
+                        writes,
+                        resource.version});
+        resource.version += writes ? 1 : 0;
+        return;
+    }
+    resource.version += writes && !use->writes ? 1 : 0;
+    use->stages |= stages;
+    use->access |= access;
+    use->reads  = use->reads || reads;
+    use->writes = use->writes || writes;
+}
+
+bool RenderGraphPlan::TransientKey::operator==(const TransientKey& other) const
+{
+    return format == other.format && extent.width == other.extent.width &&
+           extent.height == other.extent.height && usage == other.usage &&
+           first_use == other.first_use && last_use == other.last_use;
+}
+
+void RenderGraphPlan::clear()
+{
+    passes_.clear();
+    images_.clear();
+    buffers_.clear();
+    order_.clear();
+    final_barriers_.clear();
+}
+
+RenderGraphImage RenderGraphPlan::create_image(std::string_view name,
+                                               const RenderGraphImageDesc& desc)
+{
+    auto& image    = images_.emplace_back();
+    image.name     = name;
+    image.imported = false;
+    image.format   = desc.format;
+    image.extent   = desc.extent;
+    return {static_cast<uint32_t>(images_.size() - 1)};
+}
+
+RenderGraphImage RenderGraphPlan::import_image(
+    std::string_view name,
+    const RenderGraphImportedImage& imported)
+{
+    auto& image      = images_.emplace_back();
+    image.name       = name;
+    image.imported   = true;
+    image.format     = imported.format;
+    image.extent     = imported.extent;
+    image.image      = imported.image;
+    image.view       = imported.view;
+    image.generation = imported.generation;
+    image.initial    = imported.initial;
+    image.final      = imported.final;
+    return {static_cast<uint32_t>(images_.size() - 1)};
+}
+
+RenderGraphBuffer RenderGraphPlan::import_buffer(std::string_view name,
+                                                 VkBuffer buffer,
+                                                 RenderGraphState initial,
+                                                 RenderGraphState final)
+{
+    buffers_.push_back({std::string{name}, buffer, initial, final});
+    return {static_cast<uint32_t>(buffers_.size() - 1)};
+}
+
+void RenderGraphPlan::add_pass(std::string_view name,
+                               const std::function<void(PassBuilder&)>& setup,
+                               ExecuteFunction execute)
+{
+    auto& pass   = passes_.emplace_back();
+    pass.name    = name;
+    pass.execute = std::move(execute);
+    PassBuilder builder{*this, static_cast<uint32_t>(passes_.size() - 1)};
+    setup(builder);
+}
+
+std::pmr::vector<std::pmr::vector<bool>> RenderGraphPlan::version_flags() const
+{
+    std::pmr::vector<std::pmr::vector<bool>> flags;
+    flags.reserve(images_.size() + buffers_.size());
+    for (const auto& image : images_)
+    {
+        flags.emplace_back(image.version + 1, false);
+    }
+    for (const auto& buffer : buffers_)
+    {
+        flags.emplace_back(buffer.version + 1, false);
+    }
+    return flags;
+}
+
+void RenderGraphPlan::cull_passes()
+{
+    // walking back from the passes with visible results, a pass is needed
+    // when a needed pass reads a version of a resource it writes
+    auto needed = version_flags();
+    for (auto pass = passes_.rbegin(); pass != passes_.rend(); ++pass)
+    {
+        bool keep = pass->side_effect;
+        for (const auto& use : pass->uses)
+        {
+            // buffers are all imported
+            const bool imported = !use.image || images_[use.resource].imported;
+            keep = keep || (use.writes && (imported ||
+                                           needed[resource_key(use)]
+                                                 [use.version + 1]));
+        }
+        pass->culled = !keep;
+        if (!keep)
+        {
+            continue;
+        }
+        for (const auto& use : pass->uses)
+        {
+            if (use.reads)
+            {
+                needed[resource_key(use)][use.version] = true;
+            }
+        }
+    }
+}
+
+void RenderGraphPlan::order_passes()
+{
+    // each pass after the writer of what it reads, and a write after the
+    // reads and the write of the version it replaces
+    const auto resource_count = images_.size() + buffers_.size();
+    std::pmr::vector<uint32_t> last_writer(resource_count, NO_PASS);
+    std::pmr::vector<std::pmr::vector<uint32_t>> readers(resource_count);
+    std::pmr::vector<std::pmr::vector<uint32_t>> dependencies(passes_.size());
+    std::pmr::vector<std::pmr::vector<uint32_t>> dependents(passes_.size());
+    const auto depend = [&](uint32_t pass, uint32_t on) {
+        if (on == NO_PASS || on == pass ||
+            std::find(dependencies[pass].begin(),
+                      dependencies[pass].end(),
+                      on) != dependencies[pass].end())
+        {
+            return;
+        }
+        dependencies[pass].push_back(on);
+        dependents[on].push_back(pass);
+    };
+    for (uint32_t index = 0; index < passes_.size(); ++index)
+    {
+        if (passes_[index].culled)
+        {
+            continue;
+        }
+        for (const auto& use : passes_[index].uses)
+        {
+            const auto key = resource_key(use);
+            depend(index, last_writer[key]);
+            if (!use.writes)
+            {
+                readers[key].push_back(index);
+                continue;
+            }
+            for (const auto reader : readers[key])
+            {
+                depend(index, reader);
+            }
+            readers[key].clear();
+            last_writer[key] = index;
+        }
+    }
+
+    // of the passes ready to run, prefer one that doesn't wait for the pass
+    // just ordered, so a barrier has other work to hide behind
+    std::pmr::vector<uint32_t> waiting(passes_.size());
+    size_t live = 0;
+    for (uint32_t index = 0; index < passes_.size(); ++index)
+    {
+        waiting[index] = static_cast<uint32_t>(dependencies[index].size());
+        live += passes_[index].culled ? 0 : 1;
+    }
+    std::pmr::vector<bool> ordered(passes_.size(), false);
+    order_.clear();
+    while (order_.size() < live)
+    {
+        const auto previous = order_.empty() ? NO_PASS : order_.back();
+        uint32_t next       = NO_PASS;
+        for (uint32_t index = 0; index < passes_.size(); ++index)
+        {
+            if (passes_[index].culled || ordered[index] || waiting[index] != 0)
+            {
+                continue;
+            }
+            const auto& waits_for = dependencies[index];
+            const bool independent =
+                std::find(waits_for.begin(), waits_for.end(), previous) ==
+                waits_for.end();
+            if (next == NO_PASS || independent)
+            {
+                next = index;
+            }
+            if (independent)
+            {
+                break;
+            }
+        }
+        assert(next != NO_PASS && "Render graph passes depend on each other");
+        ordered[next] = true;
+        order_.push_back(next);
+        for (const auto dependent : dependents[next])
+        {
+            --waiting[dependent];
+        }
+    }
+
+    for (auto& image : images_)
+    {
+        image.first_use = NO_PASS;
+        image.last_use  = NO_PASS;
+        image.usage     = 0;
+        image.read      = false;
+    }
+    for (uint32_t position = 0; position < order_.size(); ++position)
+    {
+        for (const auto& use : passes_[order_[position]].uses)
+        {
+            if (!use.image)
+            {
+                continue;
+            }
+            auto& image = images_[use.resource];
+            image.first_use = std::min(image.first_use, position);
+            image.last_use  = image.last_use == NO_PASS
+                                  ? position
+                                  : std::max(image.last_use, position);
+            image.usage |= use.usage;
+            image.read = image.read || use.reads;
+        }
+    }
+}
+
+std::pmr::vector<RenderGraphPlan::TransientKey> RenderGraphPlan::transient_keys(
+    bool lazy_memory)
+{
+    std::pmr::vector<TransientKey> keys;
+    for (auto& image : images_)
+    {
+        image.physical = UINT32_MAX;
+        image.block    = UINT32_MAX;
+        if (image.imported || image.first_use == NO_PASS)
+        {
+            continue;
+        }
+        // nothing reads the attachment, so none of its contents are stored
+        // and it only has to exist while a pass renders to it
+        const bool lazy = lazy_memory && !image.read &&
+                          (image.usage & ~ATTACHMENT_USAGE) == 0;
+        image.physical = static_cast<uint32_t>(keys.size());
+        keys.push_back(
+            {image.format,
+             image.extent,
+             image.usage |
+                 (lazy ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0),
+             image.first_use,
+             image.last_use});
+    }
+    return keys;
+}
+
+void RenderGraphPlan::plan_memory_blocks(TransientSet& set)
+{
+    // largest first, each image goes to the first block with memory types
+    // in common whose images are all used by other passes. Images are bound
+    // at offset 0, a block is as large as the largest of them. Transient
+    // attachments only share blocks with each other.
+    std::pmr::vector<uint32_t> by_size(set.images.size());
+    for (uint32_t i = 0; i < by_size.size(); ++i)
+    {
+        by_size[i] = i;
+    }
+    std::stable_sort(by_size.begin(), by_size.end(), [&](auto a, auto b) {
+        return set.images[a].requirements.size >
+               set.images[b].requirements.size;
+    });
+
+    set.blocks.clear();
+    for (const auto index : by_size)
+    {
+        auto& physical    = set.images[index];
+        const auto& key   = set.keys[index];
+        const auto& needs = physical.requirements;
+        const bool lazy =
+            (key.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+        auto block = std::find_if(
+            set.blocks.begin(), set.blocks.end(), [&](auto& block) {
+                return block.lazy == lazy &&
+                       (block.type_bits & needs.memoryTypeBits) != 0 &&
+                       std::none_of(block.images.begin(),
+                                    block.images.end(),
+                                    [&](uint32_t other) {
+                                        const auto& other_key = set.keys[other];
+                                        return overlaps(key.first_use,
+                                                        key.last_use,
+                                                        other_key.first_use,
+                                                        other_key.last_use);
+                                    });
+            });
+        if (block == set.blocks.end())
+        {
+            block            = set.blocks.emplace(set.blocks.end());
+            block->type_bits = needs.memoryTypeBits;
+            block->lazy      = lazy;
+        }
+        block->size = std::max(block->size, needs.size);
+        block->type_bits &= needs.memoryTypeBits;
+        block->images.push_back(index);
+        physical.block = static_cast<uint32_t>(block - set.blocks.begin());
+    }
+}
+
+void RenderGraphPlan::use_transient_set(const TransientSet& set)
+{
+    for (auto& image : images_)
+    {
+        if (image.physical == UINT32_MAX)
+        {
+            continue;
+        }
+        const auto& physical = set.images[image.physical];
+        image.image = physical.image;
+        image.view  = physical.view;
+        image.block = physical.block;
+    }
+}
+
+void RenderGraphPlan::plan_barriers(uint32_t block_count)
+{
+    // the state a resource was left in by its uses so far
+    struct Track
+    {
+        VkImageLayout layout              = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags write_stages = 0;
+        VkAccessFlags write_access        = 0;
+        // reads since the last write, which have waited for it
+        VkPipelineStageFlags read_stages = 0;
+        VkAccessFlags read_access        = 0;
+    };
+    std::pmr::vector<Track> tracks(images_.size() + buffers_.size());
+    for (uint32_t i = 0; i < images_.size(); ++i)
+    {
+        const auto& initial    = images_[i].initial;
+        tracks[i].layout       = initial.layout;
+        tracks[i].write_stages = initial.stages;
+        tracks[i].write_access = initial.access & WRITE_ACCESS;
+    }
+    for (uint32_t i = 0; i < buffers_.size(); ++i)
+    {
+        const auto& initial = buffers_[i].initial;
+        auto& track         = tracks[images_.size() + i];
+        track.write_stages  = initial.stages;
+        track.write_access  = initial.access & WRITE_ACCESS;
+    }
+
+    // the image that used each memory block last, a transient image waits
+    // for it before taking over the memory. The first image of a block waits
+    // for nothing, the frame that used the slot's blocks before is done.
+    std::pmr::vector<uint32_t> block_users(block_count, UINT32_MAX);
+
+    for (auto& pass : passes_)
+    {
+        pass.barriers.clear();
+    }
+    for (uint32_t position = 0; position < order_.size(); ++position)
+    {
+        auto& pass = passes_[order_[position]];
+        for (const auto& use : pass.uses)
+        {
+            const auto key = resource_key(use);
+            auto& track    = tracks[key];
+            const bool takes_over_block =
+                use.image && images_[use.resource].block != UINT32_MAX &&
+                images_[use.resource].first_use == position;
+            if (takes_over_block)
+            {
+                const auto block = images_[use.resource].block;
+                assert(use.writes &&
+                       "Transient image read before it was written");
+                if (block_users[block] != UINT32_MAX)
+                {
+                    const auto& previous = tracks[block_users[block]];
+                    track.write_stages =
+                        previous.write_stages | previous.read_stages;
+                    track.write_access = previous.write_access;
+                }
+                block_users[block] = use.resource;
+            }
+
+            const bool transition = use.image && use.layout != track.layout;
+            if (transition || use.writes)
+            {
+                // a write waits for the reads and the write before it
+                const auto src_stages = track.write_stages | track.read_stages;
+                if (transition || src_stages != 0)
+                {
+                    pass.barriers.push_back({use.resource,
+                                             use.image,
+                                             src_stages,
+                                             track.write_access,
+                                             use.stages,
+                                             use.access,
+                                             track.layout,
+                                             use.layout});
+                }
+                track.layout = use.image ? use.layout : track.layout;
+                // a layout transition is a write the use has waited for
+                track.write_stages = use.stages;
+                track.write_access = use.writes ? use.access & WRITE_ACCESS : 0;
+                track.read_stages  = use.writes ? 0 : use.stages;
+                track.read_access  = use.writes ? 0 : use.access;
+                continue;
+            }
+
+            const bool waited = (use.stages & ~track.read_stages) == 0 &&
+                                (use.access & ~track.read_access) == 0;
+            if (track.write_stages != 0 && !waited)
+            {
+                pass.barriers.push_back({use.resource,
+                                         use.image,
+                                         track.write_stages,
+                                         track.write_access,
+                                         use.stages,
+                                         use.access,
+                                         track.layout,
+                                         track.layout});
+            }
+            track.read_stages |= use.stages;
+            track.read_access |= use.access;
+        }
+    }
+
+    final_barriers_.clear();
+    const auto add_final_barrier = [&](uint32_t resource,
+                                       bool image,
+                                       const Track& track,
+                                       const RenderGraphState& final) {
+        const auto layout = image && final.layout != VK_IMAGE_LAYOUT_UNDEFINED
+                                ? final.layout
+                                : track.layout;
+        if (layout == track.layout && final.access == 0)
+        {
+            return;
+        }
+        final_barriers_.push_back({resource,
+                                   image,
+                                   track.write_stages | track.read_stages,
+                                   track.write_access,
+                                   final.stages,
+                                   final.access,
+                                   track.layout,
+                                   layout});
+    };
+    for (uint32_t i = 0; i < images_.size(); ++i)
+    {
+        if (images_[i].imported)
+        {
+            add_final_barrier(i, true, tracks[i], images_[i].final);
+        }
+    }
+    for (uint32_t i = 0; i < buffers_.size(); ++i)
+    {
+        add_final_barrier(
+            i, false, tracks[images_.size() + i], buffers_[i].final);
+    }
+}
+
+void RenderGraphPlan::choose_store_ops()
+{
+    // attachments nothing reads afterwards are not written back to memory
+    auto read = version_flags();
+    for (const auto index : order_)
+    {
+        for (const auto& use : passes_[index].uses)
+        {
+            if (use.reads)
+            {
+                read[resource_key(use)][use.version] = true;
+            }
+        }
+    }
+    for (const auto index : order_)
+    {
+        auto& pass = passes_[index];
+        for (auto& attachment : pass.attachments)
+        {
+            const auto use = std::find_if(
+                pass.uses.begin(), pass.uses.end(), [&](const Use& u) {
+                    return u.image && u.resource == attachment.image;
+                });
+            const bool kept = images_[attachment.image].imported ||
+                              read[resource_key(*use)][use->version + 1];
+            attachment.store_op = kept ? VK_ATTACHMENT_STORE_OP_STORE
+                                       : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+    }
+}
+
+} // namespace lve
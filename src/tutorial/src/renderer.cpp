@@ -7,44 +7,78 @@
 
 namespace lve
 {
-LveRenderer::LveRenderer(LveWindow& window, LveDevice& device)
-    : window_(window), device_(device)
+LveRenderer::LveRenderer(LveWindow& window,
+                         LveDevice& device,
+                         uint32_t recording_thread_count,
+                         SwapChainConfig swap_chain_config)
+    : window_(window), device_(device),
+      swap_chain_config_(std::move(swap_chain_config))
 {
-    recreate_swap_chain();
+    while (!recreate_swap_chain())
+    {
+        // minimized before the first frame
+    }
     create_command_buffers();
+    recording_thread_count_ = std::max(recording_thread_count, 1u);
+    create_secondary_command_pools(recording_thread_count_);
+    create_timestamp_pool();
+    for (auto& allocator : frame_descriptor_allocators_)
+    {
+        allocator = std::make_unique<LveDescriptorAllocator>(device_);
+    }
 }
 
 LveRenderer::~LveRenderer()
 {
+    if (timestamp_pool_ != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device_.device(), timestamp_pool_, nullptr);
+    }
+    destroy_secondary_command_pools();
     free_command_buffers();
 }
 
-void LveRenderer::recreate_swap_chain()
+bool LveRenderer::recreate_swap_chain()
 {
-    auto extent = window_.get_extent();
-    while (extent.width == 0 || extent.height == 0)
+    const auto extent = window_.get_extent();
+    if (extent.width == 0 || extent.height == 0)
     {
-        extent = window_.get_extent();
+        // minimized, there is nothing to present to until it is restored
+        swap_chain_outdated_ = true;
         glfwWaitEvents();
+        return false;
     }
+    swap_chain_outdated_ = false;
+    ++swap_chain_recreations_;
 
-    vkDeviceWaitIdle(device_.device());
+    // the new swap chain starts over with its present ids
+    presented_frames_.clear();
     if (swap_chain_ == nullptr)
     {
-        swap_chain_ = std::make_unique<LveSwapChain>(device_, extent);
+        swap_chain_ =
+            std::make_unique<LveSwapChain>(device_, extent, swap_chain_config_);
+        return true;
     }
-    else
+
+    // frames of the old swap chain may still be rendering, its objects go
+    // through the deletion queue instead of waiting for the device to idle
+    std::shared_ptr<LveSwapChain> old_swap_chain = std::move(swap_chain_);
+    swap_chain_ = std::make_unique<LveSwapChain>(
+        device_, extent, swap_chain_config_, old_swap_chain);
+    if (!old_swap_chain->compare_swap_formats(*swap_chain_.get()))
     {
-        std::shared_ptr<LveSwapChain> old_swap_chain = std::move(swap_chain_);
-        swap_chain_ = std::make_unique<LveSwapChain>(
-            device_, extent, std::move(swap_chain_));
-        if (!old_swap_chain->compare_swap_formats(*swap_chain_.get()))
-        {
-            throw std::runtime_error(
-                "Swap chain image (or depth) format has changed");
-        }
+        throw std::runtime_error(
+            "Swap chain image (or depth) format has changed");
     }
-    // TODO
+    current_frame_index_ %= swap_chain_->framesInFlight();
+    return true;
+}
+
+void LveRenderer::wait_for_completed_frame(uint64_t frame)
+{
+    auto& timeline = device_.graphicsTimeline();
+    timeline.wait(frame);
+    device_.deletionQueue().collect(timeline.completed_value());
 }
 
 void LveRenderer::create_command_buffers()
@@ -73,15 +107,255 @@ void LveRenderer::free_command_buffers()
     command_buffer_.clear();
 }
 
-VkCommandBuffer LveRenderer::begin_frame()
+void LveRenderer::create_secondary_command_pools(uint32_t thread_count)
+{
+    const auto queue_family_indices = device_.findPhysicalQueueFamilies();
+    VkCommandPoolCreateInfo pool_info{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queue_family_indices.graphicsFamily};
+
+    for (auto& frame_pools : secondary_pools_)
+    {
+        frame_pools.resize(thread_count);
+        for (auto& thread_pool : frame_pools)
+        {
+            if (vkCreateCommandPool(device_.device(),
+                                    &pool_info,
+                                    nullptr,
+                                    &thread_pool.pool) != VK_SUCCESS)
+            {
+                throw std::runtime_error(
+                    "Failed to create secondary command pool.");
+            }
+        }
+    }
+}
+
+void LveRenderer::destroy_secondary_command_pools()
+{
+    for (auto& frame_pools : secondary_pools_)
+    {
+        for (auto& thread_pool : frame_pools)
+        {
+            // destroying the pool frees all buffers allocated from it
+            vkDestroyCommandPool(device_.device(), thread_pool.pool, nullptr);
+        }
+        frame_pools.clear();
+    }
+}
+
+void LveRenderer::reset_secondary_command_pools()
+{
+    for (auto& thread_pool : secondary_pools_[current_frame_index_])
+    {
+        if (thread_pool.used != 0)
+        {
+            vkResetCommandPool(device_.device(), thread_pool.pool, 0);
+            thread_pool.used = 0;
+        }
+    }
+}
+
+void LveRenderer::create_timestamp_pool()
+{
+    if (!device_.properties.limits.timestampComputeAndGraphics)
+    {
+        return;
+    }
+    VkQueryPoolCreateInfo pool_info{
+        .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 2 * LveSwapChain::MAX_FRAMES_IN_FLIGHT};
+    if (vkCreateQueryPool(
+            device_.device(), &pool_info, nullptr, &timestamp_pool_) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timestamp query pool.");
+    }
+}
+
+void LveRenderer::read_gpu_frame_time()
+{
+    // the slot's timestamps are written by every frame that uses it, the
+    // frame has finished once begin_frame() waited for it
+    if (timestamp_pool_ == VK_NULL_HANDLE ||
+        slot_frames_[current_frame_index_] == 0)
+    {
+        return;
+    }
+    std::array<uint64_t, 2> timestamps{};
+    if (vkGetQueryPoolResults(device_.device(),
+                              timestamp_pool_,
+                              2 * current_frame_index_,
+                              2,
+                              sizeof(timestamps),
+                              timestamps.data(),
+                              sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return;
+    }
+    const auto nanoseconds =
+        static_cast<double>(timestamps[1] - timestamps[0]) *
+        device_.properties.limits.timestampPeriod;
+    gpu_frame_ms_ = nanoseconds / 1'000'000.0;
+}
+
+VkCommandBuffer LveRenderer::begin_secondary_command_buffer(
+    uint32_t thread_index)
+{
+    assert(is_frame_in_progress() &&
+           "Can't begin secondary command buffer if frame is not in progress");
+    assert(thread_index < get_recording_thread_count() &&
+           "Secondary command buffer requested for unknown thread index");
+    auto& thread_pool = secondary_pools_[current_frame_index_][thread_index];
+    if (thread_pool.used == thread_pool.buffers.size())
+    {
+        VkCommandBufferAllocateInfo alloc_info{
+            .sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = thread_pool.pool,
+            .level       = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1};
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(
+                device_.device(), &alloc_info, &command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error(
+                "Failed to allocate secondary command buffer.");
+        }
+        thread_pool.buffers.push_back(command_buffer);
+    }
+    auto command_buffer = thread_pool.buffers[thread_pool.used++];
+
+    // the render graph begins the render pass and picks the framebuffer, the
+    // swap chain render pass is compatible with it. Without one the
+    // rendering is described by the attachment formats.
+    const auto target = get_render_target();
+    const VkCommandBufferInheritanceRenderingInfo rendering_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount    = 1,
+        .pColorAttachmentFormats = &target.color_format,
+        .depthAttachmentFormat   = target.depth_format,
+        .stencilAttachmentFormat = target.stencil_format,
+        .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT};
+    VkCommandBufferInheritanceInfo inheritance_info{
+        .sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext       = target.render_pass == VK_NULL_HANDLE ? &rendering_info
+                                                            : nullptr,
+        .renderPass  = target.render_pass,
+        .subpass     = 0,
+        .framebuffer = VK_NULL_HANDLE};
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                 VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritance_info};
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error(
+            "Failed to begin recording secondary command buffer.");
+    }
+    // dynamic state is not inherited from the primary command buffer
+    set_viewport_and_scissor(command_buffer);
+    return command_buffer;
+}
+
+void LveRenderer::end_secondary_command_buffer(VkCommandBuffer command_buffer)
+{
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record secondary command buffer.");
+    }
+}
+
+void LveRenderer::execute_secondary_command_buffers(
+    VkCommandBuffer command_buffer,
+    const std::pmr::vector<VkCommandBuffer>& secondary_buffers)
+{
+    assert(command_buffer == get_current_command_buffer() &&
+           "Can't execute secondary buffers on command buffer from a "
+           "different frame");
+    if (secondary_buffers.empty())
+    {
+        return;
+    }
+    vkCmdExecuteCommands(command_buffer,
+                         static_cast<uint32_t>(secondary_buffers.size()),
+                         secondary_buffers.data());
+}
+
+void LveRenderer::set_swap_chain_config(SwapChainConfig config)
+{
+    swap_chain_config_   = std::move(config);
+    swap_chain_outdated_ = true;
+}
+
+void LveRenderer::wait_for_frame()
+{
+    assert(!is_frame_in_progress() &&
+           "Can't call wait_for_frame() while frame is in progress");
+    if (swap_chain_config_.lowLatency)
+    {
+        wait_for_completed_frame(slot_frames_[current_frame_index_]);
+    }
+    poll_presented_frames();
+}
+
+void LveRenderer::collect_latency(FrameStats::Latency& stats)
+{
+    poll_presented_frames();
+    stats    = latency_;
+    latency_ = {};
+}
+
+void LveRenderer::poll_presented_frames()
+{
+    const auto completed_frame = device_.graphicsTimeline().completed_value();
+    device_.deletionQueue().collect(completed_frame);
+    // frames are shown in the order they were presented
+    const auto now = std::chrono::steady_clock::now();
+    while (!presented_frames_.empty())
+    {
+        const auto& frame = presented_frames_.front();
+        const bool shown =
+            frame.present_id != 0
+                ? swap_chain_->waitForPresent(frame.present_id, 0)
+                : frame.frame <= completed_frame;
+        if (!shown)
+        {
+            break;
+        }
+        const auto latency_ms =
+            std::chrono::duration<double, std::milli>(now - frame.input_time)
+                .count();
+        ++latency_.frames;
+        latency_.total_ms += latency_ms;
+        latency_.max_ms     = std::max(latency_.max_ms, latency_ms);
+        latency_.to_present = frame.present_id != 0;
+        presented_frames_.pop_front();
+    }
+}
+
+VkCommandBuffer LveRenderer::begin_frame(
+    std::chrono::steady_clock::time_point input_time)
 {
     assert(!is_frame_in_progress() &&
            "Can't call begin_frame() while already in progress");
+    if (swap_chain_outdated_ && !recreate_swap_chain())
+    {
+        return nullptr;
+    }
+    // the only wait of the frame, for the one that last used this slot's
+    // resources and semaphore, returns right away with low latency pacing
+    // as wait_for_frame() waited already
+    wait_for_completed_frame(slot_frames_[current_frame_index_]);
     auto result = swap_chain_->acquireNextImage(&current_image_index_);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        recreate_swap_chain();
+        // retried next frame, so this one returns without a stall
+        swap_chain_outdated_ = true;
         return nullptr;
     }
 
@@ -91,6 +365,14 @@ VkCommandBuffer LveRenderer::begin_frame()
     }
 
     is_frame_started_ = true;
+    input_time_       = input_time;
+    frame_number_ = device_.graphicsTimeline().next_value();
+    device_.deletionQueue().begin_frame(frame_number_);
+    poll_presented_frames();
+    reset_secondary_command_pools();
+    frame_descriptor_allocators_[current_frame_index_]->reset_pools();
+    read_gpu_frame_time();
+    render_extent_ = swap_chain_->getSwapChainExtent();
 
     auto command_buffer = get_current_command_buffer();
     VkCommandBufferBeginInfo begin_info{
@@ -99,6 +381,15 @@ VkCommandBuffer LveRenderer::begin_frame()
     {
         throw std::runtime_error("Failed to begin recording command buffer.");
     }
+    if (timestamp_pool_ != VK_NULL_HANDLE)
+    {
+        const uint32_t first_query = 2 * current_frame_index_;
+        vkCmdResetQueryPool(command_buffer, timestamp_pool_, first_query, 2);
+        vkCmdWriteTimestamp(command_buffer,
+                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            timestamp_pool_,
+                            first_query);
+    }
     return command_buffer;
 }
 void LveRenderer::end_frame()
@@ -106,74 +397,72 @@ void LveRenderer::end_frame()
     assert(is_frame_in_progress() &&
            "Can't call end_frame() while frame is not in progress");
     auto command_buffer = get_current_command_buffer();
+    if (timestamp_pool_ != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(command_buffer,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            timestamp_pool_,
+                            2 * current_frame_index_ + 1);
+    }
     if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to record command buffer.");
     }
     auto result = swap_chain_->submitCommandBuffers(&command_buffer,
-                                                    &current_image_index_);
+                                                    &current_image_index_,
+                                                    frame_number_,
+                                                    transfer_wait_value_);
+    transfer_wait_value_ = 0;
+    slot_frames_[current_frame_index_] = frame_number_;
+    presented_frames_.push_back(
+        {swap_chain_->lastPresentId(), frame_number_, input_time_});
+    is_frame_started_ = false;
+    current_frame_index_ =
+        (current_frame_index_ + 1) % swap_chain_->framesInFlight();
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
         window_.was_window_resized())
     {
         window_.reset_window_resized_flag();
-        recreate_swap_chain();
+        swap_chain_outdated_ = true;
     }
     else if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to present swap chain image!");
     }
-    is_frame_started_ = false;
-    current_frame_index_ =
-        (current_frame_index_ + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
 }
 
-void LveRenderer::begin_swap_chain_render_pass(VkCommandBuffer command_buffer)
+RenderGraphImage LveRenderer::import_swap_chain_image(
+    LveRenderGraph& graph) const
 {
     assert(is_frame_in_progress() &&
-           "Can't call begin_swap_chain_render_pass() if frame is not in "
-           "progress");
-    assert(command_buffer == get_current_command_buffer() &&
-           "Can't begin reder pass on command buffer from a different frame");
-    VkRenderPassBeginInfo render_pass_info{
-        .sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .renderPass  = swap_chain_->getRenderPass(),
-        .framebuffer = swap_chain_->getFrameBuffer(current_image_index_),
-        .renderArea  = {.offset = {0, 0},
-                        .extent = swap_chain_->getSwapChainExtent()},
-    };
-
-    std::array<VkClearValue, 2> clear_values{};
-    clear_values[0].color        = {0.1f, 0.1f, 0.1f, 1.0f};
-    clear_values[1].depthStencil = {1.0f, 0};
-
-    render_pass_info.clearValueCount =
-        static_cast<uint32_t>(clear_values.size());
-    render_pass_info.pClearValues = clear_values.data();
-
-    vkCmdBeginRenderPass(
-        command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+           "Can't import the swap chain image if frame is not in progress");
+    // the submit waits for the image to be acquired at the color attachment
+    // output stage, the first use waits for that stage in turn
+    return graph.import_image(
+        "swap chain",
+        {.image   = swap_chain_->getImage(current_image_index_),
+         .view    = swap_chain_->getImageView(current_image_index_),
+         .format  = swap_chain_->getSwapChainImageFormat(),
+         .extent  = swap_chain_->getSwapChainExtent(),
+         .initial = {.layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                     .stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+         .final   = {.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                     .stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT},
+         // the views of a recreated swap chain may reuse the old handles
+         .generation = swap_chain_recreations_});
+}
 
+void LveRenderer::set_viewport_and_scissor(VkCommandBuffer command_buffer)
+{
     VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width =
-        static_cast<float>(swap_chain_->getSwapChainExtent().width);
-    viewport.height =
-        static_cast<float>(swap_chain_->getSwapChainExtent().height);
+    viewport.x        = 0.0f;
+    viewport.y        = 0.0f;
+    viewport.width    = static_cast<float>(render_extent_.width);
+    viewport.height   = static_cast<float>(render_extent_.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    VkRect2D scissor{{0, 0}, swap_chain_->getSwapChainExtent()};
+    VkRect2D scissor{{0, 0}, render_extent_};
     vkCmdSetViewport(command_buffer, 0, 1, &viewport);
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 }
-
-void LveRenderer::end_swap_chain_render_pass(VkCommandBuffer command_buffer)
-{
-    assert(
-        is_frame_in_progress() &&
-        "Can't call end_swap_chain_render_pass() if frame is not in progress");
-    assert(command_buffer == get_current_command_buffer() &&
-           "Can't end reder pass on command buffer from a different frame");
-    vkCmdEndRenderPass(command_buffer);
-}
 } // namespace lve
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include <tutorial/resolution_scaler.hpp>
+
+namespace lve
+{
+LveResolutionScaler::LveResolutionScaler(ResolutionScalerConfig config)
+    : config_{config}
+{
+    scale_ = clamp_to_steps(config_.max_scale);
+}
+
+float LveResolutionScaler::update(std::optional<double> gpu_ms)
+{
+    using Decision = FrameStats::Resolution::Decision;
+    auto decision  = Decision::hold;
+    ++frames_since_change_;
+    if (config_.target_gpu_ms <= 0.0)
+    {
+        scale_ = 1.f;
+    }
+    else if (gpu_ms && *gpu_ms > 0.0)
+    {
+        average_gpu_ms_ =
+            has_average_
+                ? average_gpu_ms_ + SMOOTHING * (*gpu_ms - average_gpu_ms_)
+                : *gpu_ms;
+        has_average_ = true;
+
+        const auto target = config_.target_gpu_ms;
+        auto next         = scale_;
+        if (average_gpu_ms_ > target &&
+            frames_since_change_ >= FRAMES_BEFORE_DROP)
+        {
+            // straight to the scale that fits the budget, a step at least
+            const auto fitting = static_cast<float>(
+                scale_ * std::sqrt(target / average_gpu_ms_));
+            next =
+                clamp_to_steps(std::min(fitting, scale_ - config_.scale_step));
+            decision = next < scale_ ? Decision::drop : Decision::hold;
+        }
+        else if (frames_since_change_ >= FRAMES_BEFORE_RAISE)
+        {
+            next              = clamp_to_steps(scale_ + config_.scale_step);
+            const auto growth = static_cast<double>(next) / scale_;
+            const bool fits   = average_gpu_ms_ * growth * growth <=
+                              target * RAISE_HEADROOM;
+            decision = next > scale_ && fits ? Decision::raise : Decision::hold;
+        }
+
+        if (decision != Decision::hold)
+        {
+            // what the frames at the new scale are expected to take, until
+            // they are measured
+            const auto growth = static_cast<double>(next) / scale_;
+            average_gpu_ms_ *= growth * growth;
+            scale_               = next;
+            frames_since_change_ = 0;
+        }
+    }
+
+    history_.push_back({gpu_ms, scale_, decision});
+    if (history_.size() > HISTORY_LENGTH)
+    {
+        history_.pop_front();
+    }
+    return scale_;
+}
+
+VkExtent2D LveResolutionScaler::scale_extent(VkExtent2D extent) const
+{
+    const auto scale_axis = [&](uint32_t size) {
+        const auto scaled = static_cast<uint32_t>(
+            std::lround(static_cast<float>(size) * scale_));
+        return std::clamp(scaled, 1u, std::max(size, 1u));
+    };
+    return {scale_axis(extent.width), scale_axis(extent.height)};
+}
+
+FrameStats::Resolution LveResolutionScaler::get_stats(
+    VkExtent2D full_extent) const
+{
+    using Decision = FrameStats::Resolution::Decision;
+    const auto extent = scale_extent(full_extent);
+    FrameStats::Resolution stats{};
+    stats.target_ms = config_.target_gpu_ms;
+    stats.scale     = scale_;
+    stats.width     = extent.width;
+    stats.height    = extent.height;
+    stats.min_scale = scale_;
+    stats.max_scale = scale_;
+    if (!history_.empty())
+    {
+        const auto& sample = history_.back();
+        stats.gpu_ms       = sample.gpu_ms.value_or(0.0);
+        stats.decision     = sample.decision;
+        stats.drops        = sample.decision == Decision::drop ? 1 : 0;
+        stats.raises       = sample.decision == Decision::raise ? 1 : 0;
+    }
+    return stats;
+}
+
+float LveResolutionScaler::clamp_to_steps(float scale) const
+{
+    // the epsilon keeps exact multiples from rounding a step down
+    const auto steps = std::floor(scale / config_.scale_step + 1e-3f);
+    return std::clamp(
+        steps * config_.scale_step, config_.min_scale, config_.max_scale);
+}
+} // namespace lve
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <tutorial/shader_reloader.hpp>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace lve
+{
+LveShaderReloader::LveShaderReloader(std::filesystem::path directory)
+    : directory_{std::move(directory)}
+{
+#ifdef __linux__
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    // glslc writes in place, other tools may write elsewhere and rename
+    if (inotify_fd_ < 0 ||
+        inotify_add_watch(inotify_fd_,
+                          directory_.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        if (inotify_fd_ >= 0)
+        {
+            close(inotify_fd_);
+        }
+        throw std::runtime_error("Failed to watch shader directory.");
+    }
+#else
+    std::error_code error;
+    for (const auto& entry :
+         std::filesystem::directory_iterator{directory_, error})
+    {
+        write_times_[entry.path().filename().string()] =
+            entry.last_write_time(error);
+    }
+#endif
+    watcher_ = std::thread{&LveShaderReloader::watcher_loop, this};
+}
+
+LveShaderReloader::~LveShaderReloader()
+{
+    stopping_ = true;
+    watcher_.join();
+#ifdef __linux__
+    close(inotify_fd_);
+#endif
+    // the caller waits for the device to go idle before teardown
+}
+
+void LveShaderReloader::watch(
+    std::unique_ptr<LvePipeline>* pipeline,
+    const std::pmr::vector<std::filesystem::path>& shaders,
+    PipelineFactory factory)
+{
+    assert(pipeline && factory && "Watched pipeline without factory");
+    Watch watch{.pipeline = pipeline, .factory = std::move(factory)};
+    for (const auto& shader : shaders)
+    {
+        watch.shaders.push_back(shader.filename().string());
+    }
+    std::lock_guard lock{watch_mutex_};
+    watches_.push_back(std::move(watch));
+}
+
+void LveShaderReloader::unwatch(std::unique_ptr<LvePipeline>* pipeline)
+{
+    {
+        // the factory may be running on a copy of the watch
+        std::lock_guard rebuild_lock{rebuild_mutex_};
+        std::lock_guard lock{watch_mutex_};
+        std::erase_if(watches_, [pipeline](const Watch& watch) {
+            return watch.pipeline == pipeline;
+        });
+    }
+    std::lock_guard lock{reload_mutex_};
+    std::erase_if(reloads_, [pipeline](const Reload& reload) {
+        return reload.pipeline == pipeline;
+    });
+}
+
+uint32_t LveShaderReloader::apply_reloads()
+{
+    std::pmr::vector<Reload> reloads;
+    {
+        std::lock_guard lock{reload_mutex_};
+        reloads.swap(reloads_);
+    }
+    for (auto& reload : reloads)
+    {
+        // the replaced pipeline is destroyed through the deletion queue once
+        // the frames that recorded it are done
+        *reload.pipeline = std::move(reload.replacement);
+    }
+    return static_cast<uint32_t>(reloads.size());
+}
+
+void LveShaderReloader::watcher_loop()
+{
+    while (!stopping_)
+    {
+        auto changed = wait_for_changes();
+        if (changed.empty())
+        {
+            continue;
+        }
+        // let a build finish writing the rest of its shaders
+        while (!stopping_)
+        {
+            auto more = wait_for_changes();
+            if (more.empty())
+            {
+                break;
+            }
+            changed.insert(changed.end(), more.begin(), more.end());
+        }
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()),
+                      changed.end());
+        rebuild(changed);
+    }
+}
+
+std::pmr::vector<std::string> LveShaderReloader::wait_for_changes()
+{
+    std::pmr::vector<std::string> changed;
+#ifdef __linux__
+    pollfd poll_fd{.fd = inotify_fd_, .events = POLLIN, .revents = 0};
+    if (poll(&poll_fd, 1, static_cast<int>(POLL_INTERVAL.count())) <= 0)
+    {
+        return changed;
+    }
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    ssize_t length = 0;
+    while ((length = read(inotify_fd_, buffer.data(), buffer.size())) > 0)
+    {
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event =
+                reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            if (event->len > 0)
+            {
+                changed.emplace_back(event->name);
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+#else
+    std::this_thread::sleep_for(POLL_INTERVAL);
+    std::error_code error;
+    for (const auto& entry :
+         std::filesystem::directory_iterator{directory_, error})
+    {
+        const auto write_time = entry.last_write_time(error);
+        if (error)
+        {
+            continue;
+        }
+        auto name = entry.path().filename().string();
+        auto& known_time = write_times_[name];
+        if (known_time != write_time)
+        {
+            known_time = write_time;
+            changed.push_back(std::move(name));
+        }
+    }
+#endif
+    return changed;
+}
+
+void LveShaderReloader::rebuild(const std::pmr::vector<std::string>& changed)
+{
+    std::lock_guard rebuild_lock{rebuild_mutex_};
+    // rebuilt from a copy, so watch() on the render thread never waits for
+    // the factories
+    std::pmr::vector<Watch> watches;
+    {
+        std::lock_guard watch_lock{watch_mutex_};
+        watches = watches_;
+    }
+    for (auto& watch : watches)
+    {
+        const auto shader = std::find_first_of(watch.shaders.begin(),
+                                               watch.shaders.end(),
+                                               changed.begin(),
+                                               changed.end());
+        if (shader == watch.shaders.end())
+        {
+            continue;
+        }
+
+        std::unique_ptr<LvePipeline> replacement;
+        try
+        {
+            replacement = watch.factory();
+        }
+        catch (const std::exception& e)
+        {
+            fmt::print(stderr,
+                       "Failed to reload {}, keeping the old pipeline: {}\n",
+                       *shader,
+                       e.what());
+            continue;
+        }
+
+        std::lock_guard reload_lock{reload_mutex_};
+        // a rebuild not swapped in yet is superseded, it was never bound
+        auto pending = std::find_if(
+            reloads_.begin(), reloads_.end(), [&](const Reload& reload) {
+                return reload.pipeline == watch.pipeline;
+            });
+        if (pending != reloads_.end())
+        {
+            pending->replacement = std::move(replacement);
+        }
+        else
+        {
+            reloads_.push_back({watch.pipeline, std::move(replacement)});
+        }
+    }
+}
+} // namespace lve
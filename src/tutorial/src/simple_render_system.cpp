@@ -1,101 +1,453 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <filesystem>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <numeric>
+#include <shaders/embedded_shaders.hpp>
+#include <stdexcept>
 #include <tutorial/simple_render_system.hpp>
+#include <tutorial/spirv_reflection.hpp>
 
 
 namespace lve
 {
-struct SimplePushConstantData
+// Mirrors ObjectUbo in the shaders
+struct ObjectUbo
 {
-    glm::mat4 transform{1.f};
-    alignas(16) glm::vec3 color;
+    glm::mat4 model{1.f};
+    glm::vec4 color{};
+    // bindless image index, LveTextureStreamer::INVALID_SLOT for none
+    uint32_t texture = LveTextureStreamer::INVALID_SLOT;
+    // both std140 and std430 round the struct up to a multiple of 16 bytes
+    std::array<uint32_t, 3> padding{};
 };
+static_assert(sizeof(ObjectUbo) == 96);
 
-SimpleRenderSystem::SimpleRenderSystem(LveDevice& device,
-                                       VkRenderPass render_pass)
-    : device_(device)
+// Mirrors Push in the bindless vertex shader
+struct ObjectPush
 {
-    create_pipeline_layout();
-    create_pipeline(render_pass);
-}
+    uint32_t object_buffer;
+};
 
-SimpleRenderSystem::~SimpleRenderSystem()
+namespace
 {
-    vkDestroyPipelineLayout(device_.device(), pipeline_layout_, nullptr);
+std::span<const uint32_t> embedded_code(const std::filesystem::path& shader)
+{
+    return shaders::find_embedded(shader.filename().string());
 }
+} // namespace
 
-void SimpleRenderSystem::create_pipeline_layout()
+SimpleRenderSystem::SimpleRenderSystem(
+    LveDevice& device,
+    const PipelineRenderTarget& render_target,
+    const LveDescriptorSetLayout& global_set_layout,
+    LveDescriptorLayoutCache& layout_cache,
+    LvePipelineLayoutCache& pipeline_layout_cache,
+    LvePipelineLibraryCache& pipeline_library_cache,
+    LveBindlessTable* bindless_table)
+    : device_(device), dynamic_state_{device},
+      pipeline_library_cache_{pipeline_library_cache},
+      pipeline_variants_{SPECIALIZATION_CONSTANT_COUNT,
+                         [this](std::span<const uint32_t> constants,
+                                uint32_t baked_state,
+                                bool from_files) {
+                             return create_pipeline_variant(
+                                 constants, baked_state, from_files);
+                         }},
+      bindless_table_{bindless_table}
 {
-    VkPushConstantRange push_constant_range{};
-    push_constant_range.stageFlags =
-        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-    push_constant_range.offset = 0;
-    push_constant_range.size   = sizeof(SimplePushConstantData);
+    auto shaders_path = std::filesystem::path{SHADERS_DIRECTORY};
+    vertex_shader_path_ =
+        shaders_path / (bindless_table_ ? "simple_shader_bindless.vert.spv"
+                                        : "simple_shader.vert.spv");
+    fragment_shader_path_ =
+        shaders_path / (bindless_table_ ? "simple_shader_bindless.frag.spv"
+                                        : "simple_shader.frag.spv");
+
+    if (!bindless_table_)
+    {
+        object_set_layout_ =
+            LveDescriptorSetLayout::Builder(device_)
+                .add_binding(0,
+                             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                             VK_SHADER_STAGE_VERTEX_BIT |
+                                 VK_SHADER_STAGE_FRAGMENT_BIT)
+                .set_cache(layout_cache)
+                .build();
+    }
+    create_object_buffers();
+    create_pipeline_layout(global_set_layout, pipeline_layout_cache);
+    create_pipeline(render_target);
+}
 
-    VkPipelineLayoutCreateInfo pipeline_layout_info{
-        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount         = 0,
-        .pSetLayouts            = nullptr,
-        .pushConstantRangeCount = 1,
-        .pPushConstantRanges    = &push_constant_range};
-    if (vkCreatePipelineLayout(device_.device(),
-                               &pipeline_layout_info,
-                               nullptr,
-                               &pipeline_layout_) != VK_SUCCESS)
+SimpleRenderSystem::~SimpleRenderSystem()
+{
+    if (bindless_table_)
     {
-        throw std::runtime_error("Failed to create pipeline layout.");
+        for (auto index : object_buffer_indices_)
+        {
+            bindless_table_->remove_buffer(index);
+        }
     }
 }
 
-void SimpleRenderSystem::create_pipeline(VkRenderPass render_pass)
+void SimpleRenderSystem::create_pipeline_layout(
+    const LveDescriptorSetLayout& global_set_layout,
+    LvePipelineLayoutCache& pipeline_layout_cache)
+{
+    const std::array<ShaderReflection, 2> stages{
+        reflect_shader(embedded_code(vertex_shader_path_)),
+        reflect_shader(embedded_code(fragment_shader_path_))};
+    assert(stages[0].push_constant_size ==
+               (bindless_table_ ? sizeof(ObjectPush) : 0) &&
+           "ObjectPush is out of sync with the vertex shader");
+    // both sets are shared with descriptor sets written elsewhere, the
+    // shaders are only checked against them
+    const std::array<LvePipelineLayoutCache::SetLayout, 2> set_layouts{
+        LvePipelineLayoutCache::describe(0, global_set_layout),
+        LvePipelineLayoutCache::describe(
+            1,
+            bindless_table_ ? bindless_table_->get_layout()
+                            : *object_set_layout_)};
+    pipeline_layout_ =
+        pipeline_layout_cache.get_pipeline_layout(stages, set_layouts);
+}
+
+void SimpleRenderSystem::create_pipeline(
+    const PipelineRenderTarget& render_target)
 {
     assert(pipeline_layout_ != nullptr &&
            "Cannot create pipeline before pipeline layout");
+    render_target_ = render_target;
+    // the default variant is needed on the first frame anyway
+    pipeline_ = &get_pipeline();
+}
+
+LvePipeline& SimpleRenderSystem::get_pipeline()
+{
+    return pipeline_variants_.get(
+        specialization_constants_,
+        dynamic_state_.baked(raster_state_).pack());
+}
+
+std::unique_ptr<LvePipeline> SimpleRenderSystem::create_pipeline_variant(
+    std::span<const uint32_t> specialization_constants,
+    uint32_t baked_state,
+    bool from_files)
+{
+    // built per variant, reloads create them on the reloader's thread
     PipelineConfigInfo pipeline_config{};
-    LvePipeline::default_pipeline_config_info(pipeline_config);
-    pipeline_config.render_pass     = render_pass;
+    LvePipeline::default_pipeline_config_info(pipeline_config,
+                                              device_.featureSupport());
+    LvePipeline::set_raster_state(pipeline_config,
+                                  PipelineRasterState::unpack(baked_state));
+    pipeline_config.render_target   = render_target_;
     pipeline_config.pipeline_layout = pipeline_layout_;
-    auto shaders_path               = std::filesystem::path{SHADERS_DIRECTORY};
-    pipeline_ =
-        std::make_unique<LvePipeline>(device_,
-                                      shaders_path / "simple_shader.vert.spv",
-                                      shaders_path / "simple_shader.frag.spv",
-                                      pipeline_config);
+    pipeline_config.library_cache   = &pipeline_library_cache_;
+    if (from_files)
+    {
+        return std::make_unique<LvePipeline>(device_,
+                                             vertex_shader_path_,
+                                             fragment_shader_path_,
+                                             pipeline_config,
+                                             specialization_constants);
+    }
+    // the build directory is only read once the shaders are reloaded
+    return std::make_unique<LvePipeline>(device_,
+                                         embedded_code(vertex_shader_path_),
+                                         embedded_code(fragment_shader_path_),
+                                         pipeline_config,
+                                         specialization_constants);
+}
+
+void SimpleRenderSystem::watch_shaders(LveShaderReloader& shader_reloader)
+{
+    pipeline_variants_.watch_shaders(
+        shader_reloader, {vertex_shader_path_, fragment_shader_path_});
+}
+
+void SimpleRenderSystem::set_specialization_constant(
+    SpecializationConstant constant,
+    uint32_t value)
+{
+    specialization_constants_[constant] = value;
+}
+
+void SimpleRenderSystem::create_object_buffers()
+{
+    for (size_t i = 0; i < object_buffers_.size(); ++i)
+    {
+        reserve_objects(static_cast<int>(i), INITIAL_OBJECT_CAPACITY);
+    }
+}
+
+void SimpleRenderSystem::reserve_objects(int frame_index, uint32_t count)
+{
+    auto& buffer = object_buffers_[frame_index];
+    if (buffer && buffer->get_instance_count() >= count)
+    {
+        return;
+    }
+    // the previous buffer of this frame is no longer read, the fence of its
+    // last submission has been waited on before the frame started
+    const uint32_t capacity =
+        std::max(count, buffer ? buffer->get_instance_count() * 2 : 0u);
+    if (!bindless_table_)
+    {
+        buffer = std::make_unique<LveBuffer>(
+            device_,
+            sizeof(ObjectUbo),
+            capacity,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            device_.properties.limits.minUniformBufferOffsetAlignment);
+        buffer->map();
+        return;
+    }
+
+    // shaders index the buffer as a tightly packed array of objects
+    if (buffer)
+    {
+        bindless_table_->remove_buffer(object_buffer_indices_[frame_index]);
+    }
+    buffer = std::make_unique<LveBuffer>(
+        device_,
+        sizeof(ObjectUbo),
+        capacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    buffer->map();
+    object_buffer_indices_[frame_index] =
+        bindless_table_->add_buffer(buffer->descriptor_info());
+}
+
+void SimpleRenderSystem::write_object_set(const FrameInfo& frame_info)
+{
+    if (bindless_table_)
+    {
+        return;
+    }
+    // the dynamic offset picks the object, the descriptor only spans one
+    auto buffer_info = object_buffers_[frame_info.frame_index]->descriptor_info(
+        sizeof(ObjectUbo));
+    object_descriptor_set_ = LveDescriptorWriter{*object_set_layout_}
+                                 .write_buffer(0, &buffer_info)
+                                 .build(frame_info.descriptor_allocator);
 }
 
 void SimpleRenderSystem::render_game_objects(
-    VkCommandBuffer command_buffer,
+    const FrameInfo& frame_info,
+    std::pmr::vector<LveGameObject>& game_objects)
+{
+    pipeline_ = &get_pipeline();
+    std::pmr::vector<uint32_t> indices(game_objects.size());
+    std::iota(indices.begin(), indices.end(), 0u);
+    FrameStats stats{};
+    sort_draws(nullptr,
+               game_objects,
+               indices,
+               frame_info.camera.get_projection() *
+                   frame_info.camera.get_view(),
+               stats);
+    reserve_objects(frame_info.frame_index,
+                    static_cast<uint32_t>(draw_list_.size()));
+    write_object_set(frame_info);
+    record_game_objects(frame_info.command_buffer,
+                        frame_info,
+                        game_objects,
+                        0,
+                        draw_list_.size());
+}
+
+void SimpleRenderSystem::render_game_objects_parallel(
+    LveRenderer& renderer,
+    JobSystem& job_system,
+    const FrameInfo& frame_info,
     std::pmr::vector<LveGameObject>& game_objects,
-    const LveCamera& camera)
+    const std::pmr::vector<uint32_t>& visible,
+    FrameStats& stats)
 {
-    pipeline_->bind(command_buffer);
+    // a reload may have swapped the variant since the last frame
+    pipeline_          = &get_pipeline();
+    const auto& camera = frame_info.camera;
+    sort_draws(&job_system,
+               game_objects,
+               visible,
+               camera.get_projection() * camera.get_view(),
+               stats);
+    reserve_objects(frame_info.frame_index,
+                    static_cast<uint32_t>(draw_list_.size()));
+    write_object_set(frame_info);
 
-    const auto projection_view = camera.get_projection() * camera.get_view();
+    const auto start        = std::chrono::steady_clock::now();
+    const auto thread_count = renderer.get_recording_thread_count();
+    // one slot per range keeps submission order independent of scheduling
+    std::pmr::vector<VkCommandBuffer> secondary_buffers(thread_count,
+                                                        VK_NULL_HANDLE);
+    std::pmr::vector<uint32_t> state_changes(thread_count, 0);
+    job_system.parallel_for(
+        draw_list_.size(),
+        MIN_OBJECTS_PER_RECORDING_THREAD,
+        thread_count,
+        [&](size_t begin, size_t end, uint32_t thread_index) {
+            auto secondary =
+                renderer.begin_secondary_command_buffer(thread_index);
+            state_changes[thread_index] = record_game_objects(
+                secondary, frame_info, game_objects, begin, end);
+            renderer.end_secondary_command_buffer(secondary);
+            secondary_buffers[thread_index] = secondary;
+        });
+    std::erase(secondary_buffers, VK_NULL_HANDLE);
+    renderer.execute_secondary_command_buffers(frame_info.command_buffer,
+                                               secondary_buffers);
 
-    for (auto& obj : game_objects)
+    stats.recording.cpu_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+    stats.recording.threads = thread_count;
+    stats.recording.secondary_buffers =
+        static_cast<uint32_t>(secondary_buffers.size());
+    stats.sorting.state_changes = std::accumulate(
+        state_changes.begin(), state_changes.end(), uint32_t{0});
+}
+
+void SimpleRenderSystem::sort_draws(
+    JobSystem* job_system,
+    std::pmr::vector<LveGameObject>& game_objects,
+    const std::pmr::vector<uint32_t>& visible,
+    const glm::mat4& projection_view,
+    FrameStats& stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+    draw_list_.resize(visible.size());
+    auto make_keys = [&](size_t begin, size_t end, uint32_t) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& obj     = game_objects[visible[i]];
+            draw_list_[i] = {make_draw_key(obj, projection_view), visible[i]};
+        }
+    };
+    if (job_system)
     {
-        obj.transform.rotation =
-            glm::mod(obj.transform.rotation + glm::vec3{0.01f, 0.02f, 0.02f},
-                     glm::two_pi<float>());
+        job_system->parallel_for(
+            visible.size(), MIN_OBJECTS_PER_RECORDING_THREAD, make_keys);
+    }
+    else
+    {
+        make_keys(0, visible.size(), 0);
+    }
 
-        SimplePushConstantData push{};
-        push.color     = obj.color;
-        push.transform = projection_view * obj.transform.mat4();
+    const auto unsorted_state_changes = draw_list_.count_state_changes();
+    draw_list_.sort();
+    stats.sorting.state_changes_saved =
+        unsorted_state_changes - draw_list_.count_state_changes();
+    stats.sorting.draws  = static_cast<uint32_t>(draw_list_.size());
+    stats.sorting.cpu_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+}
+
+uint64_t SimpleRenderSystem::make_draw_key(
+    LveGameObject& game_object,
+    const glm::mat4& projection_view) const
+{
+    const auto center = game_object.transform.translation;
+    const auto clip   = projection_view * glm::vec4{center, 1.f};
+    const float depth = clip.w > 0.f ? clip.z / clip.w : 0.f;
+    return DrawList::make_key(
+        pipeline_->get_id(), game_object.model->get_id(), depth);
+}
+
+uint32_t SimpleRenderSystem::record_game_objects(
+    VkCommandBuffer command_buffer,
+    const FrameInfo& frame_info,
+    std::pmr::vector<LveGameObject>& game_objects,
+    size_t begin,
+    size_t end)
+{
+    auto& object_buffer = *object_buffers_[frame_info.frame_index];
+    const auto& draws   = draw_list_.items();
 
+    // every secondary command buffer starts without bound state
+    pipeline_->bind(command_buffer);
+    dynamic_state_.set(command_buffer, raster_state_);
+    if (bindless_table_)
+    {
+        const std::array<VkDescriptorSet, 2> sets{
+            frame_info.global_descriptor_set,
+            bindless_table_->get_descriptor_set()};
+        vkCmdBindDescriptorSets(command_buffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipeline_layout_,
+                                0,
+                                static_cast<uint32_t>(sets.size()),
+                                sets.data(),
+                                0,
+                                nullptr);
+        const ObjectPush push{
+            .object_buffer = object_buffer_indices_[frame_info.frame_index]};
         vkCmdPushConstants(command_buffer,
                            pipeline_layout_,
-                           VK_SHADER_STAGE_VERTEX_BIT |
-                               VK_SHADER_STAGE_FRAGMENT_BIT,
+                           VK_SHADER_STAGE_VERTEX_BIT,
                            0,
-                           sizeof(SimplePushConstantData),
+                           sizeof(ObjectPush),
                            &push);
-        obj.model->bind(command_buffer);
-        obj.model->draw(command_buffer);
     }
+    else
+    {
+        vkCmdBindDescriptorSets(command_buffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipeline_layout_,
+                                0,
+                                1,
+                                &frame_info.global_descriptor_set,
+                                0,
+                                nullptr);
+    }
+    uint32_t state_changes      = 1;
+    const LveModel* bound_model = nullptr;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        auto& obj = game_objects[draws[i].object];
+
+        const ObjectUbo object{
+            .model   = obj.transform.mat4(),
+            .color   = glm::vec4{obj.color, 1.f},
+            .texture = texture_streamer_ && obj.texture != INVALID_TEXTURE_ID
+                           ? texture_streamer_->get_bindless_index(obj.texture)
+                           : LveTextureStreamer::INVALID_SLOT};
+        const auto slot = static_cast<uint32_t>(i);
+        object_buffer.write_to_index(&object, slot);
+        if (!bindless_table_)
+        {
+            const auto offset = static_cast<uint32_t>(
+                slot * object_buffer.get_alignment_size());
+            vkCmdBindDescriptorSets(command_buffer,
+                                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                    pipeline_layout_,
+                                    1,
+                                    1,
+                                    &object_descriptor_set_,
+                                    1,
+                                    &offset);
+        }
+        if (obj.model.get() != bound_model)
+        {
+            obj.model->bind(command_buffer);
+            bound_model = obj.model.get();
+            ++state_changes;
+        }
+        // the bindless shader finds the object through gl_InstanceIndex
+        obj.model->draw(command_buffer, slot);
+    }
+    return state_changes;
 }
-} // namespace lve
\ No newline at end of file
+} // namespace lve
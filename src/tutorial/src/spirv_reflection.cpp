@@ -0,0 +1,554 @@
+#include <algorithm>
+#include <fmt/format.h>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <tutorial/spirv_reflection.hpp>
+
+namespace lve
+{
+namespace
+{
+constexpr uint32_t SPIRV_MAGIC  = 0x07230203;
+constexpr uint32_t HEADER_WORDS = 5;
+
+// the subset of the SPIR-V grammar reflection needs
+enum Op : uint32_t
+{
+    OP_ENTRY_POINT        = 15,
+    OP_TYPE_BOOL          = 20,
+    OP_TYPE_INT           = 21,
+    OP_TYPE_FLOAT         = 22,
+    OP_TYPE_VECTOR        = 23,
+    OP_TYPE_MATRIX        = 24,
+    OP_TYPE_IMAGE         = 25,
+    OP_TYPE_SAMPLER       = 26,
+    OP_TYPE_SAMPLED_IMAGE = 27,
+    OP_TYPE_ARRAY         = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT        = 30,
+    OP_TYPE_POINTER       = 32,
+    OP_CONSTANT           = 43,
+    OP_VARIABLE           = 59,
+    OP_DECORATE           = 71,
+    OP_MEMBER_DECORATE    = 72,
+};
+
+enum Decoration : uint32_t
+{
+    DECORATION_BUFFER_BLOCK   = 3,
+    DECORATION_ARRAY_STRIDE   = 6,
+    DECORATION_MATRIX_STRIDE  = 7,
+    DECORATION_BUILT_IN       = 11,
+    DECORATION_LOCATION       = 30,
+    DECORATION_BINDING        = 33,
+    DECORATION_DESCRIPTOR_SET = 34,
+    DECORATION_OFFSET         = 35,
+};
+
+enum StorageClass : uint32_t
+{
+    STORAGE_UNIFORM_CONSTANT = 0,
+    STORAGE_INPUT            = 1,
+    STORAGE_UNIFORM          = 2,
+    STORAGE_PUSH_CONSTANT    = 9,
+    STORAGE_STORAGE_BUFFER   = 12,
+};
+
+constexpr uint32_t DIM_BUFFER       = 5;
+constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+struct Member
+{
+    std::optional<uint32_t> offset;
+    uint32_t matrix_stride = 0;
+};
+
+// what an id is defined as, plus the decorations reflection looks at
+struct Id
+{
+    uint32_t opcode = 0;
+    // result type of constants and variables
+    uint32_t type = 0;
+    // operands following the result id
+    std::span<const uint32_t> operands;
+    std::optional<uint32_t> set;
+    std::optional<uint32_t> binding;
+    std::optional<uint32_t> location;
+    uint32_t array_stride = 0;
+    bool buffer_block     = false;
+    bool built_in         = false;
+    std::pmr::vector<Member> members;
+
+    uint32_t operand(size_t index) const
+    {
+        if (index >= operands.size())
+        {
+            throw std::runtime_error("SPIR-V instruction lacks an operand.");
+        }
+        return operands[index];
+    }
+};
+
+class Module
+{
+  public:
+    explicit Module(std::span<const uint32_t> code);
+
+    ShaderReflection reflect() const;
+
+  private:
+    const Id& id(uint32_t index) const
+    {
+        if (index >= ids_.size() || ids_[index].opcode == 0)
+        {
+            throw std::runtime_error(
+                fmt::format("SPIR-V uses undefined id {}.", index));
+        }
+        return ids_[index];
+    }
+
+    Id& define(uint32_t index, uint32_t opcode);
+    Id& decorated(uint32_t index);
+    void decorate(uint32_t target, std::span<const uint32_t> operands);
+    void decorate_member(uint32_t target, std::span<const uint32_t> operands);
+
+    uint32_t type_size(uint32_t type, uint32_t matrix_stride = 0) const;
+    uint32_t constant_value(uint32_t constant) const;
+    VkFormat input_format(uint32_t type) const;
+    std::optional<ShaderReflection::Binding> binding(const Id& variable) const;
+
+    std::pmr::vector<Id> ids_;
+    std::optional<VkShaderStageFlagBits> stage_;
+};
+
+VkShaderStageFlagBits stage_of(uint32_t execution_model)
+{
+    switch (execution_model)
+    {
+    case 0:
+        return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1:
+        return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2:
+        return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3:
+        return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4:
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+        throw std::runtime_error(fmt::format(
+            "Unsupported SPIR-V execution model {}.", execution_model));
+    }
+}
+
+Module::Module(std::span<const uint32_t> code)
+{
+    if (code.size() < HEADER_WORDS || code[0] != SPIRV_MAGIC)
+    {
+        throw std::runtime_error("Shader code is not SPIR-V.");
+    }
+    // word 3 is the bound all ids are below
+    ids_.resize(code[3]);
+
+    for (size_t i = HEADER_WORDS; i < code.size();)
+    {
+        const uint32_t word_count = code[i] >> 16;
+        const uint32_t opcode     = code[i] & 0xffff;
+        if (word_count == 0 || i + word_count > code.size())
+        {
+            throw std::runtime_error("Truncated SPIR-V instruction.");
+        }
+        const auto instruction = code.subspan(i, word_count);
+        i += word_count;
+
+        switch (opcode)
+        {
+        case OP_ENTRY_POINT:
+            if (!stage_ && word_count > 1)
+            {
+                stage_ = stage_of(instruction[1]);
+            }
+            break;
+        case OP_DECORATE:
+            if (word_count >= 3)
+            {
+                decorate(instruction[1], instruction.subspan(2));
+            }
+            break;
+        case OP_MEMBER_DECORATE:
+            if (word_count >= 4)
+            {
+                decorate_member(instruction[1], instruction.subspan(2));
+            }
+            break;
+        case OP_TYPE_BOOL:
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_IMAGE:
+        case OP_TYPE_SAMPLER:
+        case OP_TYPE_SAMPLED_IMAGE:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_STRUCT:
+        case OP_TYPE_POINTER:
+            if (word_count >= 2)
+            {
+                define(instruction[1], opcode).operands =
+                    instruction.subspan(2);
+            }
+            break;
+        case OP_CONSTANT:
+        case OP_VARIABLE:
+            if (word_count >= 3)
+            {
+                auto& result    = define(instruction[2], opcode);
+                result.type     = instruction[1];
+                result.operands = instruction.subspan(3);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (!stage_)
+    {
+        throw std::runtime_error("SPIR-V module has no entry point.");
+    }
+}
+
+Id& Module::define(uint32_t index, uint32_t opcode)
+{
+    auto& result  = decorated(index);
+    result.opcode = opcode;
+    return result;
+}
+
+// decorations come before the definitions they apply to
+Id& Module::decorated(uint32_t index)
+{
+    if (index >= ids_.size())
+    {
+        throw std::runtime_error(
+            fmt::format("SPIR-V id {} is out of bounds.", index));
+    }
+    return ids_[index];
+}
+
+void Module::decorate(uint32_t target, std::span<const uint32_t> operands)
+{
+    auto& result = decorated(target);
+    const auto value =
+        operands.size() > 1 ? std::optional{operands[1]} : std::nullopt;
+    switch (operands[0])
+    {
+    case DECORATION_BUFFER_BLOCK:
+        result.buffer_block = true;
+        break;
+    case DECORATION_ARRAY_STRIDE:
+        result.array_stride = value.value_or(0);
+        break;
+    case DECORATION_BUILT_IN:
+        result.built_in = true;
+        break;
+    case DECORATION_LOCATION:
+        result.location = value;
+        break;
+    case DECORATION_BINDING:
+        result.binding = value;
+        break;
+    case DECORATION_DESCRIPTOR_SET:
+        result.set = value;
+        break;
+    default:
+        break;
+    }
+}
+
+void Module::decorate_member(uint32_t target,
+                             std::span<const uint32_t> operands)
+{
+    auto& result          = decorated(target);
+    const uint32_t member = operands[0];
+    if (member >= result.members.size())
+    {
+        result.members.resize(member + 1);
+    }
+    if (operands.size() < 3)
+    {
+        return;
+    }
+    if (operands[1] == DECORATION_OFFSET)
+    {
+        result.members[member].offset = operands[2];
+    }
+    else if (operands[1] == DECORATION_MATRIX_STRIDE)
+    {
+        result.members[member].matrix_stride = operands[2];
+    }
+}
+
+uint32_t Module::type_size(uint32_t type, uint32_t matrix_stride) const
+{
+    const auto& definition = id(type);
+    const auto& operands   = definition.operands;
+    auto operand = [&](size_t index) { return definition.operand(index); };
+    switch (definition.opcode)
+    {
+    case OP_TYPE_BOOL:
+        return 4;
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+        return operand(0) / 8;
+    case OP_TYPE_VECTOR:
+        return operand(1) * type_size(operand(0));
+    case OP_TYPE_MATRIX:
+        return operand(1) * (matrix_stride ? matrix_stride
+                                               : type_size(operand(0)));
+    case OP_TYPE_ARRAY:
+        return constant_value(operand(1)) *
+               (definition.array_stride ? definition.array_stride
+                                        : type_size(operand(0)));
+    case OP_TYPE_STRUCT:
+    {
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < operands.size(); ++i)
+        {
+            const auto member = i < definition.members.size()
+                                    ? definition.members[i]
+                                    : Member{};
+            if (!member.offset)
+            {
+                throw std::runtime_error(
+                    "SPIR-V block member without an offset.");
+            }
+            size = std::max(
+                size,
+                *member.offset +
+                    type_size(operands[i], member.matrix_stride));
+        }
+        return size;
+    }
+    default:
+        throw std::runtime_error(fmt::format(
+            "SPIR-V type {} has no size known to reflection.", type));
+    }
+}
+
+uint32_t Module::constant_value(uint32_t constant) const
+{
+    const auto& definition = id(constant);
+    if (definition.opcode != OP_CONSTANT || definition.operands.empty())
+    {
+        throw std::runtime_error(
+            "SPIR-V array length is not a plain constant.");
+    }
+    return definition.operands[0];
+}
+
+VkFormat Module::input_format(uint32_t type) const
+{
+    const auto& definition = id(type);
+    uint32_t components    = 1;
+    const Id* component    = &definition;
+    if (definition.opcode == OP_TYPE_VECTOR)
+    {
+        components = definition.operand(1);
+        component  = &id(definition.operand(0));
+    }
+    if (components < 1 || components > 4 ||
+        (component->opcode != OP_TYPE_INT &&
+         component->opcode != OP_TYPE_FLOAT) ||
+        component->operand(0) != 32)
+    {
+        throw std::runtime_error(
+            "Unsupported vertex input type, expected 32-bit scalars or "
+            "vectors.");
+    }
+
+    static constexpr VkFormat FLOAT_FORMATS[] = {
+        VK_FORMAT_R32_SFLOAT,
+        VK_FORMAT_R32G32_SFLOAT,
+        VK_FORMAT_R32G32B32_SFLOAT,
+        VK_FORMAT_R32G32B32A32_SFLOAT};
+    static constexpr VkFormat SINT_FORMATS[] = {
+        VK_FORMAT_R32_SINT,
+        VK_FORMAT_R32G32_SINT,
+        VK_FORMAT_R32G32B32_SINT,
+        VK_FORMAT_R32G32B32A32_SINT};
+    static constexpr VkFormat UINT_FORMATS[] = {
+        VK_FORMAT_R32_UINT,
+        VK_FORMAT_R32G32_UINT,
+        VK_FORMAT_R32G32B32_UINT,
+        VK_FORMAT_R32G32B32A32_UINT};
+    if (component->opcode == OP_TYPE_FLOAT)
+    {
+        return FLOAT_FORMATS[components - 1];
+    }
+    // the second operand of OpTypeInt is its signedness
+    return component->operand(1) ? SINT_FORMATS[components - 1]
+                                     : UINT_FORMATS[components - 1];
+}
+
+std::optional<ShaderReflection::Binding> Module::binding(
+    const Id& variable) const
+{
+    if (!variable.binding)
+    {
+        return std::nullopt;
+    }
+    const auto storage  = variable.operand(0);
+    const auto& pointer = id(variable.type);
+    // arrays of descriptors take one binding
+    uint32_t count = 1;
+    const Id* type = &id(pointer.operand(1));
+    if (type->opcode == OP_TYPE_ARRAY)
+    {
+        count = constant_value(type->operand(1));
+        type  = &id(type->operand(0));
+    }
+    else if (type->opcode == OP_TYPE_RUNTIME_ARRAY)
+    {
+        count = 0;
+        type  = &id(type->operand(0));
+    }
+
+    std::optional<VkDescriptorType> descriptor_type;
+    if (storage == STORAGE_STORAGE_BUFFER)
+    {
+        descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    else if (storage == STORAGE_UNIFORM && type->opcode == OP_TYPE_STRUCT)
+    {
+        // before SPIR-V 1.3 storage buffers are BufferBlock uniforms
+        descriptor_type = type->buffer_block
+                              ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                              : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+    else if (storage == STORAGE_UNIFORM_CONSTANT)
+    {
+        switch (type->opcode)
+        {
+        case OP_TYPE_SAMPLER:
+            descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+        case OP_TYPE_SAMPLED_IMAGE:
+            descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+        case OP_TYPE_IMAGE:
+        {
+            // operands: sampled type, dim, depth, arrayed, ms, sampled
+            const auto dim           = type->operand(1);
+            const bool storage_image = type->operand(5) == 2;
+            if (dim == DIM_SUBPASS_DATA)
+            {
+                descriptor_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            else if (dim == DIM_BUFFER)
+            {
+                descriptor_type = storage_image
+                                      ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                                      : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            else
+            {
+                descriptor_type = storage_image
+                                      ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                      : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (!descriptor_type)
+    {
+        throw std::runtime_error(
+            fmt::format("Unsupported descriptor at binding {}.{}.",
+                        variable.set.value_or(0),
+                        *variable.binding));
+    }
+    return ShaderReflection::Binding{.set     = variable.set.value_or(0),
+                                     .binding = *variable.binding,
+                                     .type    = *descriptor_type,
+                                     .count   = count};
+}
+
+ShaderReflection Module::reflect() const
+{
+    ShaderReflection reflection{.stage = *stage_};
+    for (const auto& variable : ids_)
+    {
+        if (variable.opcode != OP_VARIABLE || variable.operands.empty())
+        {
+            continue;
+        }
+        const auto storage = variable.operands[0];
+        if (storage == STORAGE_INPUT)
+        {
+            if (variable.built_in || !variable.location)
+            {
+                continue;
+            }
+            const auto& pointer = id(variable.type);
+            reflection.inputs.push_back(
+                {.location = *variable.location,
+                 .format   = input_format(pointer.operand(1))});
+        }
+        else if (storage == STORAGE_PUSH_CONSTANT)
+        {
+            const auto& pointer = id(variable.type);
+            reflection.push_constant_size =
+                type_size(pointer.operand(1));
+        }
+        else if (auto found = binding(variable))
+        {
+            reflection.bindings.push_back(*found);
+        }
+    }
+
+    std::sort(reflection.bindings.begin(),
+              reflection.bindings.end(),
+              [](const auto& a, const auto& b) {
+                  return std::tie(a.set, a.binding) <
+                         std::tie(b.set, b.binding);
+              });
+    std::sort(reflection.inputs.begin(),
+              reflection.inputs.end(),
+              [](const auto& a, const auto& b) {
+                  return a.location < b.location;
+              });
+    return reflection;
+}
+} // namespace
+
+ShaderReflection reflect_shader(std::span<const uint32_t> code)
+{
+    return Module{code}.reflect();
+}
+
+void check_vertex_inputs(
+    const ShaderReflection& vertex_shader,
+    std::span<const VkVertexInputAttributeDescription> attributes)
+{
+    for (const auto& input : vertex_shader.inputs)
+    {
+        const auto attribute = std::find_if(
+            attributes.begin(), attributes.end(), [&](const auto& attribute) {
+                return attribute.location == input.location;
+            });
+        if (attribute == attributes.end() || attribute->format != input.format)
+        {
+            throw std::runtime_error(
+                fmt::format("Vertex shader input at location {} has no "
+                            "matching vertex attribute.",
+                            input.location));
+        }
+    }
+}
+} // namespace lve
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <cassert>
+#include <tutorial/staging_ring.hpp>
+
+namespace lve
+{
+LveStagingRing::LveStagingRing(LveDevice& device, VkDeviceSize size)
+    : buffer_{device,
+              size,
+              1,
+              VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                  VK_MEMORY_PROPERTY_HOST_COHERENT_BIT}
+{
+    buffer_.map();
+}
+
+std::optional<LveStagingRing::Allocation> LveStagingRing::allocate(
+    VkDeviceSize size,
+    VkDeviceSize alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0 &&
+           "Alignment must be a power of two");
+    const auto capacity = buffer_.get_buffer_size();
+    const auto wrap     = head_ - head_ % capacity;
+    auto offset         = (head_ % capacity + alignment - 1) & ~(alignment - 1);
+    auto start          = wrap + offset;
+    if (offset + size > capacity)
+    {
+        // allocations never wrap, skip the rest of the buffer
+        offset = 0;
+        start  = wrap + capacity;
+    }
+    if (size > capacity || start + size - tail_ > capacity)
+    {
+        return std::nullopt;
+    }
+    head_      = start + size;
+    auto* data = static_cast<std::byte*>(buffer_.get_mapped_memory()) + offset;
+    return Allocation{.offset = offset, .end = head_, .data = data};
+}
+
+void LveStagingRing::release(VkDeviceSize end)
+{
+    assert(end <= head_ && "Releasing past the last allocation");
+    tail_ = std::max(tail_, end);
+}
+} // namespace lve
@@ -1,6 +1,7 @@
 #include <tutorial/swap_chain.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -8,23 +9,58 @@
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <utility>
 
 namespace lve
 {
 
-LveSwapChain::LveSwapChain(LveDevice& deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent}
+const char* presentModeName(VkPresentModeKHR presentMode)
 {
-    init();
-    old_swap_chain_ = nullptr;
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "Immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "Mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:
+        return "V-Sync";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "Relaxed V-Sync";
+    default:
+        return "Unknown";
+    }
 }
 
 LveSwapChain::LveSwapChain(LveDevice& deviceRef,
                            VkExtent2D extent,
+                           const SwapChainConfig& config)
+    : LveSwapChain(deviceRef, extent, config, nullptr)
+{
+}
+
+LveSwapChain::LveSwapChain(LveDevice& deviceRef,
+                           VkExtent2D extent,
+                           const SwapChainConfig& config,
                            std::shared_ptr<LveSwapChain> previous)
-    : device{deviceRef}, windowExtent{extent}, old_swap_chain_{previous}
+    : config_{config}, device{deviceRef}, windowExtent{extent},
+      old_swap_chain_{previous}
 {
+    framesInFlight_ = config_.framesInFlight == 0
+                          ? MAX_FRAMES_IN_FLIGHT
+                          : std::min<uint32_t>(config_.framesInFlight,
+                                               MAX_FRAMES_IN_FLIGHT);
+    if (device.featureSupport().presentWait)
+    {
+        waitForPresent_ = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+            vkGetDeviceProcAddr(device.device(), "vkWaitForPresentKHR"));
+    }
+    if (old_swap_chain_ != nullptr)
+    {
+        currentFrame = old_swap_chain_->currentFrame % framesInFlight_;
+    }
     init();
+    // otherwise every swap chain would keep all of its predecessors alive
+    old_swap_chain_ = nullptr;
 }
 
 void LveSwapChain::init()
@@ -32,58 +68,51 @@ void LveSwapChain::init()
     createSwapChain();
     createImageViews();
     createRenderPass();
-    createDepthResources();
-    createFramebuffers();
     createSyncObjects();
 }
 
 LveSwapChain::~LveSwapChain()
 {
-    for (auto imageView : swapChainImageViews)
-    {
-        vkDestroyImageView(device.device(), imageView, nullptr);
-    }
-    swapChainImageViews.clear();
-
-    if (swapChain != nullptr)
-    {
-        vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
-        swapChain = nullptr;
-    }
-
-    for (int i = 0; i < depthImages.size(); i++)
-    {
-        vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-        vkDestroyImage(device.device(), depthImages[i], nullptr);
-        vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
-    }
-
-    for (auto framebuffer : swapChainFramebuffers)
-    {
-        vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-    }
-
-    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+    // frames in flight may still render and present to it while its
+    // successor is in use already
+    device.deletionQueue().push(
+        [device = device.device(),
+         swapChain = swapChain,
+         renderPass = renderPass,
+         imageViews = std::move(swapChainImageViews),
+         imageAvailable = std::move(imageAvailableSemaphores),
+         renderFinished = std::move(renderFinishedSemaphores)] {
+            for (auto imageView : imageViews)
+            {
+                vkDestroyImageView(device, imageView, nullptr);
+            }
+            vkDestroySwapchainKHR(device, swapChain, nullptr);
+            vkDestroyRenderPass(device, renderPass, nullptr);
+
+            // cleanup synchronization objects
+            for (auto semaphore : imageAvailable)
+            {
+                vkDestroySemaphore(device, semaphore, nullptr);
+            }
+            for (auto semaphore : renderFinished)
+            {
+                vkDestroySemaphore(device, semaphore, nullptr);
+            }
+        });
+}
 
-    // cleanup synchronization objects
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        vkDestroySemaphore(
-            device.device(), renderFinishedSemaphores[i], nullptr);
-        vkDestroySemaphore(
-            device.device(), imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device.device(), inFlightFences[i], nullptr);
-    }
+bool LveSwapChain::waitForPresent(uint64_t presentId, uint64_t timeout)
+{
+    return waitForPresent_ && waitForPresent_(device.device(),
+                                              swapChain,
+                                              presentId,
+                                              timeout) == VK_SUCCESS;
 }
 
 VkResult LveSwapChain::acquireNextImage(uint32_t* imageIndex)
 {
-    vkWaitForFences(device.device(),
-                    1,
-                    &inFlightFences[currentFrame],
-                    VK_TRUE,
-                    std::numeric_limits<uint64_t>::max());
-
+    // the semaphore is free again, the caller waited for the frame last
+    // submitted in this slot
     VkResult result = vkAcquireNextImageKHR(
         device.device(),
         swapChain,
@@ -97,40 +126,48 @@ VkResult LveSwapChain::acquireNextImage(uint32_t* imageIndex)
 }
 
 VkResult LveSwapChain::submitCommandBuffers(const VkCommandBuffer* buffers,
-                                            uint32_t* imageIndex)
+                                            uint32_t* imageIndex,
+                                            uint64_t timelineValue,
+                                            uint64_t transferWaitValue)
 {
-    if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
-    {
-        vkWaitForFences(device.device(),
-                        1,
-                        &imagesInFlight[*imageIndex],
-                        VK_TRUE,
-                        UINT64_MAX);
-    }
-    imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
-
     VkSubmitInfo submitInfo = {};
     submitInfo.sType        = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
+    // the transfer wait makes uploads visible to the shaders sampling them
+    VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame],
+                                    device.transferTimeline().get_semaphore()};
     VkPipelineStageFlags waitStages[] = {
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+    const uint64_t waitValues[]   = {0, transferWaitValue};
+    submitInfo.waitSemaphoreCount = transferWaitValue != 0 ? 2 : 1;
     submitInfo.pWaitSemaphores    = waitSemaphores;
     submitInfo.pWaitDstStageMask  = waitStages;
 
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers    = buffers;
 
-    VkSemaphore signalSemaphores[]  = {renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    // one render finished semaphore per image, an image is only acquired
+    // again after the present that waited on its semaphore
+    VkSemaphore signalSemaphores[] = {
+        renderFinishedSemaphores[*imageIndex],
+        device.graphicsTimeline().get_semaphore()};
+    // the value for the binary semaphore is ignored
+    const uint64_t signalValues[]   = {0, timelineValue};
+    submitInfo.signalSemaphoreCount = 2;
     submitInfo.pSignalSemaphores    = signalSemaphores;
 
-    vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-    if (vkQueueSubmit(device.graphicsQueue(),
-                      1,
-                      &submitInfo,
-                      inFlightFences[currentFrame]) != VK_SUCCESS)
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount   = submitInfo.waitSemaphoreCount;
+    timelineInfo.pWaitSemaphoreValues      = waitValues;
+    timelineInfo.signalSemaphoreValueCount = 2;
+    timelineInfo.pSignalSemaphoreValues    = signalValues;
+    submitInfo.pNext                       = &timelineInfo;
+
+    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) !=
+        VK_SUCCESS)
     {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
@@ -139,7 +176,7 @@ VkResult LveSwapChain::submitCommandBuffers(const VkCommandBuffer* buffers,
     presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores    = signalSemaphores;
+    presentInfo.pWaitSemaphores    = &renderFinishedSemaphores[*imageIndex];
 
     VkSwapchainKHR swapChains[] = {swapChain};
     presentInfo.swapchainCount  = 1;
@@ -147,9 +184,21 @@ VkResult LveSwapChain::submitCommandBuffers(const VkCommandBuffer* buffers,
 
     presentInfo.pImageIndices = imageIndex;
 
+    // ids let waitForPresent tell when this image reached the screen
+    VkPresentIdKHR presentIdInfo{};
+    uint64_t presentId = presentId_ + 1;
+    if (waitForPresent_)
+    {
+        presentIdInfo.sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds    = &presentId;
+        presentInfo.pNext            = &presentIdInfo;
+        presentId_                   = presentId;
+    }
+
     auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrame = (currentFrame + 1) % framesInFlight_;
 
     return result;
 }
@@ -164,11 +213,15 @@ void LveSwapChain::createSwapChain()
         chooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-    if (swapChainSupport.capabilities.maxImageCount > 0 &&
-        imageCount > swapChainSupport.capabilities.maxImageCount)
+    const auto& capabilities = swapChainSupport.capabilities;
+    uint32_t imageCount      = config_.imageCount == 0
+                                   ? capabilities.minImageCount + 1
+                                   : std::max(config_.imageCount,
+                                              capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0 &&
+        imageCount > capabilities.maxImageCount)
     {
-        imageCount = swapChainSupport.capabilities.maxImageCount;
+        imageCount = capabilities.maxImageCount;
     }
 
     VkSwapchainCreateInfoKHR createInfo = {};
@@ -180,7 +233,10 @@ void LveSwapChain::createSwapChain()
     createInfo.imageColorSpace  = surfaceFormat.colorSpace;
     createInfo.imageExtent      = extent;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // blitted to when the scene is rendered at a lower resolution
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                            (capabilities.supportedUsageFlags &
+                             VK_IMAGE_USAGE_TRANSFER_DST_BIT);
 
     QueueFamilyIndices indices    = device.findPhysicalQueueFamilies();
     uint32_t queueFamilyIndices[] = {indices.graphicsFamily,
@@ -232,6 +288,17 @@ void LveSwapChain::createSwapChain()
 
     swapChainImageFormat = surfaceFormat.format;
     swapChainExtent      = extent;
+    presentMode_         = presentMode;
+    supportsUpscaling_ =
+        (createInfo.imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0 &&
+        device.hasFormatFeatures(
+            swapChainImageFormat,
+            VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+    std::cout << "Swap chain: " << presentModeName(presentMode) << ", "
+              << imageCount << " images, " << framesInFlight_
+              << " frames in flight"
+              << (config_.lowLatency ? ", low latency" : "") << std::endl;
 }
 
 void LveSwapChain::createImageViews()
@@ -261,8 +328,27 @@ void LveSwapChain::createImageViews()
 
 void LveSwapChain::createRenderPass()
 {
+    swap_chain_depth_format_ = findDepthFormat();
+    // with dynamic rendering pipelines and secondary command buffers only
+    // need the formats
+    if (device.featureSupport().dynamicRendering)
+    {
+        renderPass = VK_NULL_HANDLE;
+        return;
+    }
+    // pipelines are created against the first swap chain's render pass, so
+    // it is handed on to the swap chains replacing it instead of destroyed
+    // with the retired one
+    if (old_swap_chain_ != nullptr &&
+        old_swap_chain_->swapChainImageFormat == swapChainImageFormat)
+    {
+        renderPass =
+            std::exchange(old_swap_chain_->renderPass, VK_NULL_HANDLE);
+        return;
+    }
+
     VkAttachmentDescription depthAttachment{};
-    depthAttachment.format         = findDepthFormat();
+    depthAttachment.format         = swap_chain_depth_format_;
     depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
     depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
     depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -327,120 +413,34 @@ void LveSwapChain::createRenderPass()
     }
 }
 
-void LveSwapChain::createFramebuffers()
-{
-    swapChainFramebuffers.resize(imageCount());
-    for (size_t i = 0; i < imageCount(); i++)
-    {
-        std::array<VkImageView, 2> attachments = {swapChainImageViews[i],
-                                                  depthImageViews[i]};
-
-        VkExtent2D swapChainExtent              = getSwapChainExtent();
-        VkFramebufferCreateInfo framebufferInfo = {};
-        framebufferInfo.sType      = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount =
-            static_cast<uint32_t>(attachments.size());
-        framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width        = swapChainExtent.width;
-        framebufferInfo.height       = swapChainExtent.height;
-        framebufferInfo.layers       = 1;
-
-        if (vkCreateFramebuffer(device.device(),
-                                &framebufferInfo,
-                                nullptr,
-                                &swapChainFramebuffers[i]) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create framebuffer!");
-        }
-    }
-}
-
-void LveSwapChain::createDepthResources()
-{
-    VkFormat depthFormat       = findDepthFormat();
-    swap_chain_depth_format_   = depthFormat;
-    VkExtent2D swapChainExtent = getSwapChainExtent();
-
-    depthImages.resize(imageCount());
-    depthImageMemorys.resize(imageCount());
-    depthImageViews.resize(imageCount());
-
-    for (int i = 0; i < depthImages.size(); i++)
-    {
-        VkImageCreateInfo imageInfo{};
-        imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageInfo.imageType     = VK_IMAGE_TYPE_2D;
-        imageInfo.extent.width  = swapChainExtent.width;
-        imageInfo.extent.height = swapChainExtent.height;
-        imageInfo.extent.depth  = 1;
-        imageInfo.mipLevels     = 1;
-        imageInfo.arrayLayers   = 1;
-        imageInfo.format        = depthFormat;
-        imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
-        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageInfo.usage         = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
-        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
-        imageInfo.flags         = 0;
-
-        device.createImageWithInfo(imageInfo,
-                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                   depthImages[i],
-                                   depthImageMemorys[i]);
-
-        VkImageViewCreateInfo viewInfo{};
-        viewInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        viewInfo.image    = depthImages[i];
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format   = depthFormat;
-        viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_DEPTH_BIT;
-        viewInfo.subresourceRange.baseMipLevel   = 0;
-        viewInfo.subresourceRange.levelCount     = 1;
-        viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount     = 1;
-
-        if (vkCreateImageView(
-                device.device(), &viewInfo, nullptr, &depthImageViews[i]) !=
-            VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create texture image view!");
-        }
-    }
-}
-
 void LveSwapChain::createSyncObjects()
 {
     imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+    renderFinishedSemaphores.resize(imageCount());
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (auto& semaphore : imageAvailableSemaphores)
     {
-        if (vkCreateSemaphore(device.device(),
-                              &semaphoreInfo,
-                              nullptr,
-                              &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device.device(),
-                              &semaphoreInfo,
-                              nullptr,
-                              &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(
-                device.device(), &fenceInfo, nullptr, &inFlightFences[i]) !=
-                VK_SUCCESS)
+        if (vkCreateSemaphore(
+                device.device(), &semaphoreInfo, nullptr, &semaphore) !=
+            VK_SUCCESS)
         {
             throw std::runtime_error(
                 "failed to create synchronization objects for a frame!");
         }
     }
+    for (auto& semaphore : renderFinishedSemaphores)
+    {
+        if (vkCreateSemaphore(
+                device.device(), &semaphoreInfo, nullptr, &semaphore) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error(
+                "failed to create synchronization objects for an image!");
+        }
+    }
 }
 
 VkSurfaceFormatKHR LveSwapChain::chooseSwapSurfaceFormat(
@@ -461,23 +461,17 @@ VkSurfaceFormatKHR LveSwapChain::chooseSwapSurfaceFormat(
 VkPresentModeKHR LveSwapChain::chooseSwapPresentMode(
     const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-    for (const auto& availablePresentMode : availablePresentModes)
+    for (const auto preferred : config_.presentModes)
     {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        if (std::find(availablePresentModes.begin(),
+                      availablePresentModes.end(),
+                      preferred) != availablePresentModes.end())
         {
-            std::cout << "Present mode: Mailbox" << std::endl;
-            return availablePresentMode;
+            return preferred;
         }
     }
 
-    // for (const auto &availablePresentMode : availablePresentModes) {
-    //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-    //     std::cout << "Present mode: Immediate" << std::endl;
-    //     return availablePresentMode;
-    //   }
-    // }
-
-    std::cout << "Present mode: V-Sync" << std::endl;
+    // the only mode every surface supports
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
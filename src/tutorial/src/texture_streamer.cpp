@@ -0,0 +1,694 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <tutorial/swap_chain.hpp>
+#include <tutorial/texture_streamer.hpp>
+
+namespace lve
+{
+namespace
+{
+// keeps level offsets valid for vkCmdCopyBufferToImage with any format whose
+// texel block is at most 16 bytes
+constexpr VkDeviceSize LEVEL_ALIGNMENT = 16;
+
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+LveTextureStreamer::LveTextureStreamer(LveDevice& device,
+                                       LveBindlessTable* bindless_table,
+                                       const TextureStreamerConfig& config)
+    : device_{device}, bindless_table_{bindless_table}, config_{config},
+      staging_ring_{device, config.staging_size}
+{
+    const auto queue_families = device_.findPhysicalQueueFamilies();
+    queue_families_ = {queue_families.graphicsFamily,
+                       queue_families.transferFamily};
+
+    VkCommandPoolCreateInfo pool_info{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queue_families.transferFamily};
+    if (vkCreateCommandPool(
+            device_.device(), &pool_info, nullptr, &command_pool_) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create streaming command pool.");
+    }
+    for (auto& batch : batches_)
+    {
+        VkCommandBufferAllocateInfo alloc_info{
+            .sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = command_pool_,
+            .level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1};
+        if (vkAllocateCommandBuffers(device_.device(),
+                                     &alloc_info,
+                                     &batch.command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create streaming batch.");
+        }
+    }
+
+    VkSamplerCreateInfo sampler_info{
+        .sType            = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter        = VK_FILTER_LINEAR,
+        .minFilter        = VK_FILTER_LINEAR,
+        .mipmapMode       = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU     = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV     = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW     = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .mipLodBias       = 0.f,
+        .anisotropyEnable = VK_TRUE,
+        .maxAnisotropy    = device_.properties.limits.maxSamplerAnisotropy,
+        .compareEnable    = VK_FALSE,
+        .minLod           = 0.f,
+        .maxLod           = VK_LOD_CLAMP_NONE,
+        .borderColor      = VK_BORDER_COLOR_INT_OPAQUE_BLACK};
+    if (vkCreateSampler(device_.device(), &sampler_info, nullptr, &sampler_) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create streaming sampler.");
+    }
+
+    loader_ = std::thread{&LveTextureStreamer::loader_loop, this};
+}
+
+LveTextureStreamer::~LveTextureStreamer()
+{
+    {
+        std::lock_guard lock{loader_mutex_};
+        stopping_ = true;
+    }
+    loader_wakeup_.notify_all();
+    loader_.join();
+
+    for (auto& batch : batches_)
+    {
+        if (batch.submitted)
+        {
+            device_.transferTimeline().wait(batch.sequence);
+        }
+        for (auto& swap : batch.swaps)
+        {
+            destroy_image(swap.image);
+        }
+    }
+    // the caller waits for the graphics queue to go idle before teardown
+    for (auto& retired : retired_)
+    {
+        destroy_image(retired.image);
+    }
+    for (auto& texture : textures_)
+    {
+        destroy_image(texture.image);
+    }
+    vkDestroyCommandPool(device_.device(), command_pool_, nullptr);
+    vkDestroySampler(device_.device(), sampler_, nullptr);
+}
+
+TextureId LveTextureStreamer::add_texture(
+    std::shared_ptr<const TextureSource> source)
+{
+    assert(source && source->mip_levels() > 0 && "Texture without levels");
+    if (is_bc_compressed(source->format()) &&
+        !device_.featureSupport().textureCompressionBC)
+    {
+        throw std::runtime_error(
+            "Texture uses a BC format the device cannot sample.");
+    }
+    auto& texture          = textures_.emplace_back();
+    texture.source         = std::move(source);
+    texture.mip_levels     = texture.source->mip_levels();
+    texture.resident_level = texture.mip_levels;
+    texture.pending_level  = texture.mip_levels;
+    texture.wanted_level.store(texture.mip_levels);
+
+    texture.tail_level = texture.mip_levels - 1;
+    while (texture.tail_level > 0)
+    {
+        const auto finer = texture.source->level_extent(texture.tail_level - 1);
+        if (std::max(finer.width, finer.height) > TAIL_EXTENT)
+        {
+            break;
+        }
+        --texture.tail_level;
+    }
+
+    // a chain is uploaded in one allocation, leave room for other requests
+    texture.finest_level = 0;
+    while (texture.finest_level < texture.tail_level &&
+           chain_size(texture, texture.finest_level) >
+               staging_ring_.size() / 2)
+    {
+        ++texture.finest_level;
+    }
+    return static_cast<TextureId>(textures_.size() - 1);
+}
+
+void LveTextureStreamer::mark_visible(TextureId id, float screen_pixels)
+{
+    auto& texture = textures_[id];
+    texture.last_visible_frame.store(frame_.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+
+    const auto extent = texture.source->extent();
+    const auto texels =
+        static_cast<float>(std::max(extent.width, extent.height));
+    // one texel per pixel needs the level whose size matches the coverage
+    auto level = texture.mip_levels - 1;
+    if (screen_pixels >= 1.f)
+    {
+        const auto lod = std::floor(std::log2(texels / screen_pixels));
+        level          = static_cast<uint32_t>(
+            std::clamp(lod, 0.f, static_cast<float>(texture.mip_levels - 1)));
+    }
+    auto wanted = texture.wanted_level.load(std::memory_order_relaxed);
+    while (level < wanted && !texture.wanted_level.compare_exchange_weak(
+                                 wanted, level, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LveTextureStreamer::update(FrameStats::Streaming& stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    retire_batches(stats);
+    destroy_retired_images();
+    record_loaded_requests(stats);
+    issue_requests(stats);
+    submit_batch();
+
+    for (const auto& texture : textures_)
+    {
+        stats.resident += texture.resident_level < texture.mip_levels;
+        stats.pending += texture.pending_level < texture.mip_levels;
+    }
+    stats.textures       = static_cast<uint32_t>(textures_.size());
+    stats.resident_bytes = resident_bytes_;
+    stats.budget_bytes   = config_.memory_budget;
+    stats.cpu_ms         = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    frame_.fetch_add(1, std::memory_order_relaxed);
+}
+
+VkImageView LveTextureStreamer::get_image_view(TextureId texture) const
+{
+    return textures_[texture].image.view;
+}
+
+uint32_t LveTextureStreamer::get_bindless_index(TextureId texture) const
+{
+    return textures_[texture].image.bindless_slot;
+}
+
+void LveTextureStreamer::loader_loop()
+{
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock lock{loader_mutex_};
+            loader_wakeup_.wait(
+                lock, [this] { return stopping_ || !load_queue_.empty(); });
+            if (stopping_)
+            {
+                return;
+            }
+            request = std::move(load_queue_.front());
+            load_queue_.pop_front();
+        }
+
+        try
+        {
+            for (size_t i = 0; i < request.level_offsets.size(); ++i)
+            {
+                const auto level =
+                    request.first_level + static_cast<uint32_t>(i);
+                request.source->load_level(
+                    level,
+                    {request.staging.data + request.level_offsets[i],
+                     request.source->level_size(level)});
+            }
+        }
+        catch (const std::runtime_error&)
+        {
+            request.failed = true;
+        }
+
+        std::lock_guard lock{loader_mutex_};
+        loaded_.push_back(std::move(request));
+    }
+}
+
+void LveTextureStreamer::retire_batches(FrameStats::Streaming& stats)
+{
+    while (true)
+    {
+        Batch* oldest = nullptr;
+        for (auto& batch : batches_)
+        {
+            if (batch.submitted &&
+                (!oldest || batch.sequence < oldest->sequence))
+            {
+                oldest = &batch;
+            }
+        }
+        if (!oldest ||
+            !device_.transferTimeline().is_complete(oldest->sequence))
+        {
+            return;
+        }
+
+        // staging space is released in submission order
+        staging_ring_.release(oldest->staging_end);
+        if (!oldest->swaps.empty())
+        {
+            transfer_wait_value_ = oldest->sequence;
+        }
+        for (auto& swap : oldest->swaps)
+        {
+            auto& texture = textures_[swap.texture];
+            if (bindless_table_)
+            {
+                const VkDescriptorImageInfo image_info{
+                    .sampler     = sampler_,
+                    .imageView   = swap.image.view,
+                    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+                swap.image.bindless_slot =
+                    bindless_table_->add_image(image_info);
+            }
+            // frames up to the one being recorded may sample the old image
+            if (texture.image.image != VK_NULL_HANDLE)
+            {
+                retired_.push_back(
+                    {texture.image, device_.graphicsTimeline().last_value()});
+            }
+            texture.image          = swap.image;
+            texture.resident_level = swap.first_level;
+            texture.pending_level  = texture.mip_levels;
+            ++stats.uploads;
+        }
+        oldest->swaps.clear();
+        oldest->submitted = false;
+    }
+}
+
+void LveTextureStreamer::destroy_retired_images()
+{
+    const auto completed_frame = device_.graphicsTimeline().completed_value();
+    std::erase_if(retired_, [&](RetiredImage& retired) {
+        if (retired.frame > completed_frame)
+        {
+            return false;
+        }
+        destroy_image(retired.image);
+        return true;
+    });
+}
+
+void LveTextureStreamer::record_loaded_requests(FrameStats::Streaming& stats)
+{
+    while (true)
+    {
+        // only this thread takes from loaded_, what is seen here stays
+        {
+            std::lock_guard lock{loader_mutex_};
+            if (loaded_.empty())
+            {
+                return;
+            }
+        }
+        auto* batch = recording_batch();
+        if (!batch)
+        {
+            return;
+        }
+        Request request;
+        {
+            std::lock_guard lock{loader_mutex_};
+            request = std::move(loaded_.front());
+            loaded_.pop_front();
+        }
+        batch->staging_end = request.staging.end;
+
+        auto& texture = textures_[request.texture];
+        if (request.failed)
+        {
+            projected_bytes_ -= chain_size(texture, request.first_level);
+            projected_bytes_ += chain_size(texture, texture.resident_level);
+            texture.pending_level = texture.mip_levels;
+            texture.failed        = true;
+            continue;
+        }
+
+        auto image               = create_image(texture, request.first_level);
+        const auto level_count   = texture.mip_levels - request.first_level;
+        const auto command_buffer = batch->command_buffer;
+
+        VkImageMemoryBarrier to_transfer{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask       = 0,
+            .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = image.image,
+            .subresourceRange    = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                    .baseMipLevel   = 0,
+                                    .levelCount     = level_count,
+                                    .baseArrayLayer = 0,
+                                    .layerCount     = 1}};
+        vkCmdPipelineBarrier(command_buffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             1,
+                             &to_transfer);
+
+        std::pmr::vector<VkBufferImageCopy> regions;
+        regions.reserve(level_count);
+        for (uint32_t i = 0; i < level_count; ++i)
+        {
+            const auto extent =
+                texture.source->level_extent(request.first_level + i);
+            regions.push_back(VkBufferImageCopy{
+                .bufferOffset =
+                    request.staging.offset + request.level_offsets[i],
+                .bufferRowLength   = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource  = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                      .mipLevel   = i,
+                                      .baseArrayLayer = 0,
+                                      .layerCount     = 1},
+                .imageOffset       = {0, 0, 0},
+                .imageExtent       = {extent.width, extent.height, 1}});
+            stats.uploaded_bytes +=
+                texture.source->level_size(request.first_level + i);
+        }
+        vkCmdCopyBufferToImage(command_buffer,
+                               staging_ring_.get_buffer(),
+                               image.image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(regions.size()),
+                               regions.data());
+
+        // the image is only sampled by frames whose submission waits for
+        // this batch's transfer timeline value, get_transfer_wait_value()
+        auto to_shader_read          = to_transfer;
+        to_shader_read.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        to_shader_read.dstAccessMask = 0;
+        to_shader_read.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        to_shader_read.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(command_buffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             1,
+                             &to_shader_read);
+
+        batch->swaps.push_back({request.texture, request.first_level, image});
+    }
+}
+
+void LveTextureStreamer::issue_requests(FrameStats::Streaming& stats)
+{
+    // textures asking for more detail than they have get one finer level,
+    // coarsest resident textures first
+    std::pmr::vector<TextureId> upgrades;
+    for (TextureId id = 0; id < textures_.size(); ++id)
+    {
+        auto& texture = textures_[id];
+        const auto wanted =
+            texture.wanted_level.exchange(texture.mip_levels);
+        if (!texture.failed && texture.pending_level == texture.mip_levels &&
+            texture.resident_level < texture.mip_levels &&
+            texture.resident_level > std::max(wanted, texture.finest_level))
+        {
+            upgrades.push_back(id);
+        }
+    }
+    std::sort(upgrades.begin(), upgrades.end(), [&](TextureId a, TextureId b) {
+        return textures_[a].resident_level > textures_[b].resident_level;
+    });
+
+    // mip tails go first, they make a texture usable at all
+    uint32_t issued = 0;
+    for (TextureId id = 0; id < textures_.size(); ++id)
+    {
+        auto& texture = textures_[id];
+        if (texture.failed || texture.resident_level < texture.mip_levels ||
+            texture.pending_level < texture.mip_levels)
+        {
+            continue;
+        }
+        if (issued == config_.max_requests_per_update ||
+            !request_chain(id, texture.tail_level))
+        {
+            return;
+        }
+        ++issued;
+    }
+
+    for (auto id : upgrades)
+    {
+        if (issued == config_.max_requests_per_update)
+        {
+            return;
+        }
+        auto& texture       = textures_[id];
+        const auto level    = texture.resident_level - 1;
+        const auto required = chain_size(texture, level) -
+                              chain_size(texture, texture.resident_level);
+        while (projected_bytes_ + required > config_.memory_budget)
+        {
+            if (!evict_least_recently_visible(stats))
+            {
+                return;
+            }
+        }
+        if (!request_chain(id, level))
+        {
+            return;
+        }
+        ++issued;
+    }
+}
+
+bool LveTextureStreamer::request_chain(TextureId id, uint32_t first_level)
+{
+    auto& texture = textures_[id];
+    Request request{.texture     = id,
+                    .source      = texture.source,
+                    .first_level = first_level};
+    VkDeviceSize size = 0;
+    for (auto level = first_level; level < texture.mip_levels; ++level)
+    {
+        size = align_up(size, LEVEL_ALIGNMENT);
+        request.level_offsets.push_back(size);
+        size += texture.source->level_size(level);
+    }
+    auto staging = staging_ring_.allocate(size, LEVEL_ALIGNMENT);
+    if (!staging)
+    {
+        return false;
+    }
+    request.staging = *staging;
+
+    projected_bytes_ -= chain_size(texture, texture.resident_level);
+    projected_bytes_ += chain_size(texture, first_level);
+    texture.pending_level = first_level;
+    {
+        std::lock_guard lock{loader_mutex_};
+        load_queue_.push_back(std::move(request));
+    }
+    loader_wakeup_.notify_one();
+    return true;
+}
+
+bool LveTextureStreamer::evict_least_recently_visible(
+    FrameStats::Streaming& stats)
+{
+    const auto frame = frame_.load();
+    Texture* victim  = nullptr;
+    TextureId id     = INVALID_TEXTURE_ID;
+    for (TextureId i = 0; i < textures_.size(); ++i)
+    {
+        auto& texture = textures_[i];
+        const auto last_visible = texture.last_visible_frame.load();
+        if (texture.failed || texture.pending_level < texture.mip_levels ||
+            texture.resident_level >= texture.tail_level ||
+            last_visible >= frame)
+        {
+            continue;
+        }
+        if (!victim || last_visible < victim->last_visible_frame.load())
+        {
+            victim = &texture;
+            id     = i;
+        }
+    }
+    // the tail is reloaded into a smaller image, the large one is dropped
+    // when it lands
+    if (!victim || !request_chain(id, victim->tail_level))
+    {
+        return false;
+    }
+    ++stats.evictions;
+    return true;
+}
+
+LveTextureStreamer::Batch* LveTextureStreamer::recording_batch()
+{
+    auto& batch = batches_[next_batch_];
+    if (batch.recording)
+    {
+        return &batch;
+    }
+    if (batch.submitted)
+    {
+        return nullptr;
+    }
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    if (vkBeginCommandBuffer(batch.command_buffer, &begin_info) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin streaming command buffer.");
+    }
+    batch.recording = true;
+    return &batch;
+}
+
+void LveTextureStreamer::submit_batch()
+{
+    auto& batch = batches_[next_batch_];
+    if (!batch.recording)
+    {
+        return;
+    }
+    if (vkEndCommandBuffer(batch.command_buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record streaming command buffer.");
+    }
+    auto& timeline       = device_.transferTimeline();
+    const uint64_t value = timeline.next_value();
+    const VkSemaphore semaphore = timeline.get_semaphore();
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues    = &value};
+    VkSubmitInfo submit_info{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                             .pNext = &timeline_info,
+                             .commandBufferCount   = 1,
+                             .pCommandBuffers      = &batch.command_buffer,
+                             .signalSemaphoreCount = 1,
+                             .pSignalSemaphores    = &semaphore};
+    if (vkQueueSubmit(
+            device_.transferQueue(), 1, &submit_info, VK_NULL_HANDLE) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit streaming command buffer.");
+    }
+    batch.recording = false;
+    batch.submitted = true;
+    batch.sequence  = value;
+    next_batch_     = (next_batch_ + 1) % batches_.size();
+}
+
+LveTextureStreamer::Image LveTextureStreamer::create_image(
+    const Texture& texture,
+    uint32_t first_level)
+{
+    const auto extent = texture.source->level_extent(first_level);
+    // concurrent sharing spares ownership transfers between the transfer
+    // and graphics queues
+    const bool shared = queue_families_[0] != queue_families_[1];
+    VkImageCreateInfo image_info{
+        .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType   = VK_IMAGE_TYPE_2D,
+        .format      = texture.source->format(),
+        .extent      = {extent.width, extent.height, 1},
+        .mipLevels   = texture.mip_levels - first_level,
+        .arrayLayers = 1,
+        .samples     = VK_SAMPLE_COUNT_1_BIT,
+        .tiling      = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = shared ? VK_SHARING_MODE_CONCURRENT
+                              : VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = shared ? 2u : 0u,
+        .pQueueFamilyIndices   = queue_families_.data(),
+        .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED};
+    Image image{};
+    device_.createImageWithInfo(image_info,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                image.image,
+                                image.memory);
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device_.device(), image.image, &requirements);
+    image.bytes = requirements.size;
+    resident_bytes_ += image.bytes;
+
+    VkImageViewCreateInfo view_info{
+        .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image            = image.image,
+        .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+        .format           = image_info.format,
+        .subresourceRange = {.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                             .baseMipLevel   = 0,
+                             .levelCount     = image_info.mipLevels,
+                             .baseArrayLayer = 0,
+                             .layerCount     = 1}};
+    if (vkCreateImageView(device_.device(), &view_info, nullptr, &image.view) !=
+        VK_SUCCESS)
+    {
+        destroy_image(image);
+        throw std::runtime_error("Failed to create streamed image view.");
+    }
+    return image;
+}
+
+void LveTextureStreamer::destroy_image(Image& image)
+{
+    if (image.image == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    if (bindless_table_ && image.bindless_slot != INVALID_SLOT)
+    {
+        bindless_table_->remove_image(image.bindless_slot);
+    }
+    vkDestroyImageView(device_.device(), image.view, nullptr);
+    vkDestroyImage(device_.device(), image.image, nullptr);
+    vkFreeMemory(device_.device(), image.memory, nullptr);
+    resident_bytes_ -= image.bytes;
+    image = {};
+}
+
+VkDeviceSize LveTextureStreamer::chain_size(const Texture& texture,
+                                            uint32_t first_level) const
+{
+    VkDeviceSize size = 0;
+    for (auto level = first_level; level < texture.mip_levels; ++level)
+    {
+        size += texture.source->level_size(level);
+    }
+    return size;
+}
+} // namespace lve
@@ -0,0 +1,43 @@
+#include <stdexcept>
+#include <tutorial/timeline.hpp>
+
+namespace lve
+{
+LveTimeline::LveTimeline(VkDevice device) : device_{device}
+{
+    VkSemaphoreTypeCreateInfo type_info{
+        .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue  = 0};
+    VkSemaphoreCreateInfo semaphore_info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &type_info};
+    if (vkCreateSemaphore(device_, &semaphore_info, nullptr, &semaphore_) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timeline semaphore.");
+    }
+}
+
+LveTimeline::~LveTimeline()
+{
+    vkDestroySemaphore(device_, semaphore_, nullptr);
+}
+
+uint64_t LveTimeline::completed_value() const
+{
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device_, semaphore_, &value);
+    return value;
+}
+
+bool LveTimeline::wait(uint64_t value, uint64_t timeout) const
+{
+    VkSemaphoreWaitInfo wait_info{
+        .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores    = &semaphore_,
+        .pValues        = &value};
+    return vkWaitSemaphores(device_, &wait_info, timeout) == VK_SUCCESS;
+}
+} // namespace lve